@@ -1,97 +1,208 @@
 #include "bytes.hpp"
 
 #include "base/assert.hpp"
+#include "base/config.hpp"
+#include "base/cpu.hpp"
 #include "base/error.hpp"
 
-#include <openssl/pem.h>
-
 #include <boost/container_hash/hash.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <iterator>
 
+#ifdef CONFIG_ARCH_X86
+#include <immintrin.h>
+#endif
+
 namespace base
 {
 
-Bytes::Bytes() {}
+Bytes::Bytes() noexcept
+  : _data{ _inline }
+{}
 
 
 Bytes::Bytes(std::size_t size)
-  : _raw(size)
-{}
+  : Bytes()
+{
+    resize(size);
+}
+
 
 Bytes::Bytes(const std::vector<Byte>& bytes)
-  : _raw(bytes)
+  : Bytes(bytes.data(), bytes.size())
 {}
 
 
 Bytes::Bytes(const std::string& s)
-  : _raw(s.length())
+  : Bytes(reinterpret_cast<const Byte*>(s.data()), s.size())
+{}
+
+
+Bytes::Bytes(const Byte* const bytes, std::size_t length)
+  : Bytes()
 {
-    std::size_t index = 0;
-    for (const char c : s) {
-        _raw[index++] = static_cast<Byte>(c);
-    }
+    assign(bytes, length);
 }
 
 
-Bytes::Bytes(const Byte* const bytes, std::size_t length)
-  : _raw(bytes, bytes + length)
+Bytes::Bytes(std::initializer_list<Byte> l)
+  : Bytes(l.begin(), l.size())
 {}
 
 
-Bytes::Bytes(std::initializer_list<Byte> l)
-  : _raw(l)
+Bytes::Bytes(const Bytes& other)
+  : Bytes(other._data, other._size)
 {}
 
 
+Bytes::Bytes(Bytes&& other) noexcept
+  : Bytes()
+{
+    stealFrom(other);
+}
+
+
+Bytes& Bytes::operator=(const Bytes& other)
+{
+    if (this != &other) {
+        assign(other._data, other._size);
+    }
+    return *this;
+}
+
+
+Bytes& Bytes::operator=(Bytes&& other) noexcept
+{
+    if (this != &other) {
+        if (!isInline()) {
+            delete[] _data;
+            _data = _inline;
+            _capacity = INLINE_CAPACITY;
+        }
+        stealFrom(other);
+    }
+    return *this;
+}
+
+
+Bytes::~Bytes()
+{
+    if (!isInline()) {
+        delete[] _data;
+    }
+}
+
+
+bool Bytes::isInline() const noexcept
+{
+    return _data == _inline;
+}
+
+
+void Bytes::reallocate(std::size_t new_capacity)
+{
+    ASSERT(new_capacity >= _size);
+    Byte* new_data = new_capacity <= INLINE_CAPACITY ? _inline : new Byte[new_capacity];
+    if (new_data != _data) {
+        std::memcpy(new_data, _data, _size);
+        if (!isInline()) {
+            delete[] _data;
+        }
+        _data = new_data;
+    }
+    _capacity = isInline() ? INLINE_CAPACITY : new_capacity;
+}
+
+
+void Bytes::ensureCapacity(std::size_t required_capacity)
+{
+    if (required_capacity > _capacity) {
+        reallocate(std::max(required_capacity, 2 * _capacity));
+    }
+}
+
+
+void Bytes::assign(const Byte* data, std::size_t size)
+{
+    if (size > _capacity) {
+        // old bytes are not needed, so they are not copied to the new buffer
+        _size = 0;
+        reallocate(size);
+    }
+    if (size != 0) {
+        std::memmove(_data, data, size);
+    }
+    _size = size;
+}
+
+
+void Bytes::stealFrom(Bytes& other) noexcept
+{
+    // this object must be empty and inline
+    if (other.isInline()) {
+        std::memcpy(_inline, other._inline, other._size);
+    }
+    else {
+        _data = other._data;
+        _capacity = other._capacity;
+        other._data = other._inline;
+        other._capacity = INLINE_CAPACITY;
+    }
+    _size = other._size;
+    other._size = 0;
+}
+
+
 Byte& Bytes::operator[](std::size_t index)
 {
-    ASSERT(index < _raw.size());
-    return _raw[index];
+    ASSERT(index < _size);
+    return _data[index];
 }
 
 
 const Byte& Bytes::operator[](std::size_t index) const
 {
-    ASSERT(index < _raw.size());
-    return _raw[index];
+    ASSERT(index < _size);
+    return _data[index];
 }
 
 
 Bytes Bytes::takePart(std::size_t begin_index, std::size_t one_past_end_index) const
 {
     ASSERT(begin_index < one_past_end_index);
-    ASSERT(one_past_end_index <= _raw.size());
-
-    auto begin = _raw.begin();
-    std::advance(begin, begin_index);
-
-    auto end = begin;
-    std::advance(end, one_past_end_index - begin_index);
+    ASSERT(one_past_end_index <= _size);
 
-    return Bytes(begin, end);
+    return Bytes(_data + begin_index, one_past_end_index - begin_index);
 }
 
 
 Bytes& Bytes::append(Byte byte)
 {
-    _raw.push_back(byte);
+    ensureCapacity(_size + 1);
+    _data[_size++] = byte;
     return *this;
 }
 
 
 Bytes& Bytes::append(const Bytes& bytes)
 {
-    _raw.insert(_raw.end(), bytes._raw.begin(), bytes._raw.end());
-    return *this;
+    return append(bytes._data, bytes._size);
 }
 
 
 Bytes& Bytes::append(const Byte* byte, std::size_t length)
 {
-    _raw.reserve(_raw.size() + length);
-    for (const Byte* ptr = byte; ptr < byte + length; ++ptr) {
-        _raw.push_back(*ptr);
+    if (length != 0) {
+        // appended bytes can be a part of this object
+        if (byte >= _data && byte < _data + _size && _size + length > _capacity) {
+            return append(Bytes(byte, length));
+        }
+        ensureCapacity(_size + length);
+        std::memcpy(_data + _size, byte, length);
+        _size += length;
     }
     return *this;
 }
@@ -99,84 +210,75 @@ Bytes& Bytes::append(const Byte* byte, std::size_t length)
 
 void Bytes::clear()
 {
-    _raw.clear();
+    _size = 0;
 }
 
 
 void Bytes::resize(std::size_t new_size)
 {
-    _raw.resize(new_size);
+    if (new_size > _size) {
+        ensureCapacity(new_size);
+        std::memset(_data + _size, 0, new_size - _size);
+    }
+    _size = new_size;
 }
 
 
 void Bytes::reserve(std::size_t reserve_size)
 {
-    _raw.reserve(reserve_size);
+    if (reserve_size > _capacity) {
+        reallocate(reserve_size);
+    }
 }
 
 
 std::size_t Bytes::capacity() const
 {
-    return _raw.capacity();
+    return _capacity;
 }
 
 
 bool Bytes::isEmpty() const noexcept
 {
-    return _raw.empty();
+    return _size == 0;
 }
 
 
 void Bytes::shrinkToFit()
 {
-    _raw.shrink_to_fit();
+    if (!isInline() && _size < _capacity) {
+        reallocate(_size);
+    }
 }
 
 
 std::size_t Bytes::size() const noexcept
 {
-    return _raw.size();
+    return _size;
 }
 
 
 const Byte* Bytes::getData() const
 {
-    return _raw.data();
+    return _data;
 }
 
 
 Byte* Bytes::getData()
 {
-    return _raw.data();
-}
-
-
-std::vector<Byte>& Bytes::toVector() noexcept
-{
-    return _raw;
-}
-
-
-const std::vector<Byte>& Bytes::toVector() const noexcept
-{
-    return _raw;
+    return _data;
 }
 
 
 std::string Bytes::toString() const
 {
-    std::string ret(_raw.size(), static_cast<char>(0));
-    std::size_t index = 0;
-    for (const auto& c : _raw) {
-        ret[index++] = static_cast<char>(c);
-    }
-    return ret;
+    return std::string(reinterpret_cast<const char*>(_data), _size);
 }
 
 
 bool Bytes::operator==(const Bytes& another) const
 {
-    return _raw == another._raw;
+    return _size == another._size && (_size == 0 || std::memcmp(_data, another._data, _size) == 0);
 }
 
 
@@ -188,13 +290,13 @@ bool Bytes::operator!=(const Bytes& another) const
 
 bool Bytes::operator<(const Bytes& another) const
 {
-    return _raw < another._raw;
+    return std::lexicographical_compare(_data, _data + _size, another._data, another._data + another._size);
 }
 
 
 bool Bytes::operator>(const Bytes& another) const
 {
-    return _raw > another._raw;
+    return another < *this;
 }
 
 
@@ -223,30 +325,588 @@ std::ostream& operator<<(std::ostream& os, const Bytes& bytes)
 }
 
 
+BytesView::BytesView(const Byte* bytes, std::size_t length) noexcept
+  : _data{ bytes }
+  , _size{ length }
+{}
+
+
+BytesView::BytesView(const Bytes& bytes) noexcept
+  : _data{ bytes.getData() }
+  , _size{ bytes.size() }
+{}
+
+
+BytesView::BytesView(const SharedBytes& bytes) noexcept
+  : _data{ bytes.getData() }
+  , _size{ bytes.size() }
+{}
+
+
+const Byte& BytesView::operator[](std::size_t index) const
+{
+    ASSERT(index < _size);
+    return _data[index];
+}
+
+
+BytesView BytesView::takePart(std::size_t begin_index, std::size_t one_past_end_index) const
+{
+    ASSERT(begin_index <= one_past_end_index);
+    ASSERT(one_past_end_index <= _size);
+    return BytesView(_data + begin_index, one_past_end_index - begin_index);
+}
+
+
+std::size_t BytesView::size() const noexcept
+{
+    return _size;
+}
+
+
+bool BytesView::isEmpty() const noexcept
+{
+    return _size == 0;
+}
+
+
+const Byte* BytesView::getData() const noexcept
+{
+    return _data;
+}
+
+
+Bytes BytesView::toBytes() const
+{
+    return Bytes(_data, _size);
+}
+
+
+bool BytesView::operator==(const BytesView& another) const
+{
+    return std::equal(_data, _data + _size, another._data, another._data + another._size);
+}
+
+
+bool BytesView::operator!=(const BytesView& another) const
+{
+    return !(*this == another);
+}
+
+
+SharedBytes::SharedBytes(Bytes&& bytes)
+  : _owner{ std::make_shared<const Bytes>(std::move(bytes)) }
+  , _data{ _owner->getData() }
+  , _size{ _owner->size() }
+{}
+
+
+const Byte& SharedBytes::operator[](std::size_t index) const
+{
+    ASSERT(index < _size);
+    return _data[index];
+}
+
+
+SharedBytes SharedBytes::takePart(std::size_t begin_index, std::size_t one_past_end_index) const
+{
+    ASSERT(begin_index <= one_past_end_index);
+    ASSERT(one_past_end_index <= _size);
+    SharedBytes part{ *this };
+    part._data += begin_index;
+    part._size = one_past_end_index - begin_index;
+    return part;
+}
+
+
+std::size_t SharedBytes::size() const noexcept
+{
+    return _size;
+}
+
+
+bool SharedBytes::isEmpty() const noexcept
+{
+    return _size == 0;
+}
+
+
+const Byte* SharedBytes::getData() const noexcept
+{
+    return _data;
+}
+
+
+Bytes SharedBytes::toBytes() const
+{
+    return Bytes(_data, _size);
+}
+
+
+bool SharedBytes::operator==(const SharedBytes& another) const
+{
+    return BytesView(*this) == BytesView(another);
+}
+
+
+bool SharedBytes::operator!=(const SharedBytes& another) const
+{
+    return !(*this == another);
+}
+
+namespace
+{
+
+enum class SimdLevel
+{
+    NONE,
+    SSSE3,
+    AVX2
+};
+
+
+SimdLevel getSimdLevel() noexcept
+{
+    if (cpu::hasAvx2()) {
+        return SimdLevel::AVX2;
+    }
+    if (cpu::hasSsse3()) {
+        return SimdLevel::SSSE3;
+    }
+    return SimdLevel::NONE;
+}
+
+
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+// values of hex digits, 0xFF for other symbols
+constexpr std::array<Byte, 256> HEX_VALUES = [] {
+    std::array<Byte, 256> values{};
+    for (std::size_t c = 0; c < values.size(); ++c) {
+        if ('0' <= c && c <= '9') {
+            values[c] = static_cast<Byte>(c - '0');
+        }
+        else if ('a' <= c && c <= 'f') {
+            values[c] = static_cast<Byte>(c - 'a' + 10);
+        }
+        else if ('A' <= c && c <= 'F') {
+            values[c] = static_cast<Byte>(c - 'A' + 10);
+        }
+        else {
+            values[c] = 0xFF;
+        }
+    }
+    return values;
+}();
+
+
+void encodeHexScalar(const Byte* bytes, std::size_t size, char* hex) noexcept
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        hex[2 * i] = HEX_DIGITS[bytes[i] >> 4];
+        hex[2 * i + 1] = HEX_DIGITS[bytes[i] & 0xF];
+    }
+}
+
+
+bool decodeHexScalar(const char* hex, std::size_t size, Byte* bytes) noexcept
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        auto high_part = HEX_VALUES[static_cast<Byte>(hex[2 * i])];
+        auto low_part = HEX_VALUES[static_cast<Byte>(hex[2 * i + 1])];
+        if ((high_part | low_part) > 0xF) {
+            return false;
+        }
+        bytes[i] = static_cast<Byte>((high_part << 4) | low_part);
+    }
+    return true;
+}
+
+
+constexpr char BASE64_DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// values of base64 digits, 0xFF for other symbols
+constexpr std::array<Byte, 256> BASE64_VALUES = [] {
+    std::array<Byte, 256> values{};
+    for (auto& value : values) {
+        value = 0xFF;
+    }
+    for (std::size_t i = 0; i < 64; ++i) {
+        values[static_cast<Byte>(BASE64_DIGITS[i])] = static_cast<Byte>(i);
+    }
+    return values;
+}();
+
+
+// encodes full groups of 3 bytes
+void encodeBase64Scalar(const Byte* bytes, std::size_t groups_count, char* base64) noexcept
+{
+    for (std::size_t i = 0; i < groups_count; ++i, bytes += 3, base64 += 4) {
+        std::uint32_t group = (bytes[0] << 16) | (bytes[1] << 8) | bytes[2];
+        base64[0] = BASE64_DIGITS[group >> 18];
+        base64[1] = BASE64_DIGITS[(group >> 12) & 0x3F];
+        base64[2] = BASE64_DIGITS[(group >> 6) & 0x3F];
+        base64[3] = BASE64_DIGITS[group & 0x3F];
+    }
+}
+
+
+// decodes full groups of 4 symbols without padding
+bool decodeBase64Scalar(const char* base64, std::size_t groups_count, Byte* bytes) noexcept
+{
+    for (std::size_t i = 0; i < groups_count; ++i, base64 += 4, bytes += 3) {
+        std::uint32_t a = BASE64_VALUES[static_cast<Byte>(base64[0])];
+        std::uint32_t b = BASE64_VALUES[static_cast<Byte>(base64[1])];
+        std::uint32_t c = BASE64_VALUES[static_cast<Byte>(base64[2])];
+        std::uint32_t d = BASE64_VALUES[static_cast<Byte>(base64[3])];
+        if ((a | b | c | d) > 0x3F) {
+            return false;
+        }
+        std::uint32_t group = (a << 18) | (b << 12) | (c << 6) | d;
+        bytes[0] = static_cast<Byte>(group >> 16);
+        bytes[1] = static_cast<Byte>(group >> 8);
+        bytes[2] = static_cast<Byte>(group);
+    }
+    return true;
+}
+
+
+#ifdef CONFIG_ARCH_X86
+// SIMD kernels process whole blocks only and return the number of processed bytes, the rest is left to
+// the scalar code, which also reports invalid symbols
+
+__attribute__((target("ssse3"))) std::size_t encodeHexSsse3(const Byte* bytes, std::size_t size, char* hex) noexcept
+{
+    const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(HEX_DIGITS));
+    const __m128i low_mask = _mm_set1_epi8(0x0F);
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+        __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(in, 4), low_mask));
+        __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(in, low_mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex + 2 * i), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hex + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+    }
+    return i;
+}
+
+
+__attribute__((target("avx2"))) std::size_t encodeHexAvx2(const Byte* bytes, std::size_t size, char* hex) noexcept
+{
+    const __m256i digits = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(HEX_DIGITS)));
+    const __m256i low_mask = _mm256_set1_epi8(0x0F);
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i));
+        __m256i high = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(in, 4), low_mask));
+        __m256i low = _mm256_shuffle_epi8(digits, _mm256_and_si256(in, low_mask));
+        // unpacking works inside 128-bit lanes, so the lanes are put back in order
+        __m256i first = _mm256_unpacklo_epi8(high, low);
+        __m256i second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hex + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(hex + 2 * i + 32),
+                            _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    return i;
+}
+
+
+// values of 16 hex digits, lanes of valid are cleared for other symbols
+__attribute__((target("ssse3"))) __m128i hexValuesSsse3(__m128i symbols, __m128i& valid) noexcept
+{
+    // x <= n for unsigned bytes is min(x, n) == x
+    __m128i digit = _mm_sub_epi8(symbols, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(symbols, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+    valid = _mm_and_si128(valid, _mm_or_si128(is_digit, is_letter));
+    return _mm_or_si128(_mm_and_si128(is_digit, digit),
+                        _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+
+__attribute__((target("ssse3"))) std::size_t decodeHexSsse3(const char* hex, std::size_t size, Byte* bytes) noexcept
+{
+    // high digit is multiplied by 16 and added to the low one
+    const __m128i weights = _mm_set1_epi16(0x0110);
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i valid = _mm_set1_epi8(-1);
+        __m128i first = hexValuesSsse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + 2 * i)), valid);
+        __m128i second = hexValuesSsse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + 2 * i + 16)), valid);
+        if (_mm_movemask_epi8(valid) != 0xFFFF) {
+            break;
+        }
+        __m128i out = _mm_packus_epi16(_mm_maddubs_epi16(first, weights), _mm_maddubs_epi16(second, weights));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i), out);
+    }
+    return i;
+}
+
+
+__attribute__((target("avx2"))) __m256i hexValuesAvx2(__m256i symbols, __m256i& valid) noexcept
+{
+    __m256i digit = _mm256_sub_epi8(symbols, _mm256_set1_epi8('0'));
+    __m256i letter = _mm256_sub_epi8(_mm256_or_si256(symbols, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+    valid = _mm256_and_si256(valid, _mm256_or_si256(is_digit, is_letter));
+    return _mm256_or_si256(_mm256_and_si256(is_digit, digit),
+                           _mm256_and_si256(is_letter, _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+}
+
+
+__attribute__((target("avx2"))) std::size_t decodeHexAvx2(const char* hex, std::size_t size, Byte* bytes) noexcept
+{
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i valid = _mm256_set1_epi8(-1);
+        __m256i first = hexValuesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hex + 2 * i)), valid);
+        __m256i second =
+          hexValuesAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hex + 2 * i + 32)), valid);
+        if (_mm256_movemask_epi8(valid) != -1) {
+            break;
+        }
+        // packing works inside 128-bit lanes, so 64-bit quarters are put back in order
+        __m256i out = _mm256_packus_epi16(_mm256_maddubs_epi16(first, weights), _mm256_maddubs_epi16(second, weights));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(bytes + i), _mm256_permute4x64_epi64(out, 0xD8));
+    }
+    return i;
+}
+
+
+// 12 bytes are encoded at a time, but 16 are loaded
+__attribute__((target("ssse3"))) std::size_t encodeBase64Ssse3(const Byte* bytes,
+                                                               std::size_t size,
+                                                               char* base64) noexcept
+{
+    // every 3 bytes are spread to 4 bytes with 6-bit values
+    const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    // offsets from values to symbols: A-Z, a-z, 0-9 and then + and /
+    const __m128i offsets = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 12, base64 += 16) {
+        __m128i in = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i)), spread);
+        __m128i high = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        __m128i low = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        __m128i values = _mm_or_si128(high, low);
+
+        __m128i index = _mm_subs_epu8(values, _mm_set1_epi8(51));
+        index = _mm_sub_epi8(index, _mm_cmpgt_epi8(values, _mm_set1_epi8(25)));
+        __m128i out = _mm_add_epi8(values, _mm_shuffle_epi8(offsets, index));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(base64), out);
+    }
+    return i;
+}
+
+
+// 16 symbols are decoded at a time, but 16 bytes are stored, so size of output must be 4 bytes more than decoded
+__attribute__((target("ssse3"))) std::size_t decodeBase64Ssse3(const char* base64,
+                                                               std::size_t size,
+                                                               Byte* bytes) noexcept
+{
+    // a symbol is valid if bits of its low and high nibbles in these tables don't intersect
+    const __m128i low_nibble_bits = _mm_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i high_nibble_bits = _mm_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    // offsets from symbols to values by high nibble, / has its own
+    const __m128i offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i slash = _mm_set1_epi8(0x2F);
+    // joins 4 6-bit values into 3 bytes
+    const __m128i merge_pairs = _mm_set1_epi32(0x01400140);
+    const __m128i merge_quads = _mm_set1_epi32(0x00011000);
+    const __m128i gather = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16, bytes += 12) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base64 + i));
+        __m128i high_nibbles = _mm_and_si128(_mm_srli_epi32(in, 4), slash);
+        __m128i low_nibbles = _mm_and_si128(in, slash);
+        __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(low_nibble_bits, low_nibbles),
+                                        _mm_shuffle_epi8(high_nibble_bits, high_nibbles));
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(invalid, _mm_setzero_si128())) != 0) {
+            break;
+        }
+        __m128i offset = _mm_shuffle_epi8(offsets, _mm_add_epi8(_mm_cmpeq_epi8(in, slash), high_nibbles));
+        __m128i values = _mm_add_epi8(in, offset);
+
+        __m128i out = _mm_madd_epi16(_mm_maddubs_epi16(values, merge_pairs), merge_quads);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), _mm_shuffle_epi8(out, gather));
+    }
+    return i;
+}
+#endif
+
+
+// base 58^5 keeps 5 digits of base58 in 32 bits, so long numbers are converted a few digits or bytes at a time
+constexpr std::uint64_t BASE58_LIMB = 58ull * 58 * 58 * 58 * 58;
+constexpr std::size_t BASE58_LIMB_DIGITS = 5;
+
+constexpr char BASE58_DIGITS[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+} // namespace
+
+
+namespace codec
+{
+
+void encodeHex(const Byte* bytes, std::size_t size, char* hex) noexcept
+{
+    std::size_t done = 0;
+#ifdef CONFIG_ARCH_X86
+    switch (getSimdLevel()) {
+        case SimdLevel::AVX2:
+            done = encodeHexAvx2(bytes, size, hex);
+            [[fallthrough]];
+        case SimdLevel::SSSE3:
+            done += encodeHexSsse3(bytes + done, size - done, hex + 2 * done);
+            break;
+        case SimdLevel::NONE:
+            break;
+    }
+#endif
+    encodeHexScalar(bytes + done, size - done, hex + 2 * done);
+}
+
+
+bool decodeHex(const char* hex, std::size_t size, Byte* bytes) noexcept
+{
+    std::size_t done = 0;
+#ifdef CONFIG_ARCH_X86
+    switch (getSimdLevel()) {
+        case SimdLevel::AVX2:
+            done = decodeHexAvx2(hex, size, bytes);
+            [[fallthrough]];
+        case SimdLevel::SSSE3:
+            done += decodeHexSsse3(hex + 2 * done, size - done, bytes + done);
+            break;
+        case SimdLevel::NONE:
+            break;
+    }
+#endif
+    return decodeHexScalar(hex + 2 * done, size - done, bytes + done);
+}
+
+
+std::string encodeBase64(const Byte* bytes, std::size_t size)
+{
+    std::string ret((size + 2) / 3 * 4, '=');
+    std::size_t done = 0;
+#ifdef CONFIG_ARCH_X86
+    if (getSimdLevel() != SimdLevel::NONE) {
+        done = encodeBase64Ssse3(bytes, size, ret.data());
+    }
+#endif
+    auto groups_count = (size - done) / 3;
+    encodeBase64Scalar(bytes + done, groups_count, ret.data() + done / 3 * 4);
+    done += groups_count * 3;
+
+    if (done != size) {
+        auto* tail = ret.data() + done / 3 * 4;
+        std::uint32_t group = bytes[done] << 16;
+        if (done + 1 != size) {
+            group |= bytes[done + 1] << 8;
+            tail[2] = BASE64_DIGITS[(group >> 6) & 0x3F];
+        }
+        tail[0] = BASE64_DIGITS[group >> 18];
+        tail[1] = BASE64_DIGITS[(group >> 12) & 0x3F];
+    }
+    return ret;
+}
+
+
+std::string encodeBase58(const Byte* bytes, std::size_t size)
+{
+    std::size_t zeroes_count = 0;
+    while (zeroes_count != size && bytes[zeroes_count] == 0) {
+        zeroes_count++;
+    }
+
+    // least significant limb goes first
+    std::vector<std::uint32_t> limbs;
+    limbs.reserve((size - zeroes_count) * 138 / 100 / BASE58_LIMB_DIGITS + 1); // log(256) / log(58)
+    for (std::size_t current_pos = zeroes_count; current_pos != size;) {
+        auto chunk_size = std::min<std::size_t>(4, size - current_pos);
+        std::uint64_t carry = 0;
+        for (std::size_t i = 0; i < chunk_size; ++i) {
+            carry = (carry << 8) | bytes[current_pos++];
+        }
+        const std::uint64_t multiplier = std::uint64_t{ 1 } << (8 * chunk_size);
+        for (auto& limb : limbs) {
+            carry += limb * multiplier;
+            limb = static_cast<std::uint32_t>(carry % BASE58_LIMB);
+            carry /= BASE58_LIMB;
+        }
+        while (carry != 0) {
+            limbs.push_back(static_cast<std::uint32_t>(carry % BASE58_LIMB));
+            carry /= BASE58_LIMB;
+        }
+    }
+
+    std::string digits;
+    digits.reserve(limbs.size() * BASE58_LIMB_DIGITS);
+    for (auto limb : limbs) {
+        for (std::size_t i = 0; i < BASE58_LIMB_DIGITS; ++i) {
+            digits += BASE58_DIGITS[limb % 58];
+            limb /= 58;
+        }
+    }
+    while (!digits.empty() && digits.back() == BASE58_DIGITS[0]) {
+        digits.pop_back();
+    }
+
+    std::string str;
+    str.reserve(zeroes_count + digits.size());
+    str.assign(zeroes_count, BASE58_DIGITS[0]);
+    str.append(digits.rbegin(), digits.rend());
+    return str;
+}
+
+} // namespace codec
+
+
 base::Bytes base64Decode(std::string_view base64)
 {
-    auto length = base64.length();
-    if (length == 0) {
+    if (base64.size() % 4 != 0) {
+        RAISE_ERROR(base::InvalidArgument, "Invalid base64 string length");
+    }
+    if (base64.empty()) {
         return base::Bytes();
     }
 
-    BIO* b64 = BIO_new(BIO_f_base64());
-    BIO* bio = BIO_new_mem_buf(base64.data(), length);
-    base::Bytes ret(length);
-
-    BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL);
-    bio = BIO_push(b64, bio);
-    auto new_length = BIO_read(bio, ret.getData(), length);
-    if (new_length < 1) {
-        BIO_free_all(bio);
-        RAISE_ERROR(CryptoError, "Base64 decode read error");
+    std::size_t padding = 0;
+    if (base64.back() == '=') {
+        padding = base64[base64.size() - 2] == '=' ? 2 : 1;
+    }
+    auto groups_count = base64.size() / 4;
+    base::Bytes ret(groups_count * 3 - padding);
+
+    // the last group can be padded, so it is decoded separately
+    std::size_t done = 0;
+#ifdef CONFIG_ARCH_X86
+    if (getSimdLevel() != SimdLevel::NONE && base64.size() > 8) {
+        // the kernel writes 4 bytes past decoded ones, so at least 2 last groups are left to the scalar code
+        done = decodeBase64Ssse3(base64.data(), base64.size() - 8, ret.getData());
+    }
+#endif
+    auto full_groups_count = groups_count - 1 - done / 4;
+    if (!decodeBase64Scalar(base64.data() + done, full_groups_count, ret.getData() + done / 4 * 3)) {
+        RAISE_ERROR(base::InvalidArgument, "Invalid base64 string");
     }
 
-    BIO_free_all(bio);
-    ret.resize(new_length);
+    const char* last = base64.data() + base64.size() - 4;
+    Byte last_bytes[3];
+    char last_group[4] = { last[0], last[1], padding > 1 ? 'A' : last[2], padding > 0 ? 'A' : last[3] };
+    if (!decodeBase64Scalar(last_group, 1, last_bytes)) {
+        RAISE_ERROR(base::InvalidArgument, "Invalid base64 string");
+    }
+    std::copy(last_bytes, last_bytes + 3 - padding, ret.getData() + (groups_count - 1) * 3);
     return ret;
 }
 
+
 // clang-format off
 static constexpr int8_t mapBase58[256] = {
      -1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
@@ -271,34 +931,45 @@ static constexpr int8_t mapBase58[256] = {
 
 base::Bytes base58Decode(std::string_view base58)
 {
-    std::size_t current_pos = 0;
     std::size_t zeroes_count = 0;
-    std::size_t length = 0;
-    while (base58[current_pos] == '1') {
+    while (zeroes_count != base58.size() && base58[zeroes_count] == BASE58_DIGITS[0]) {
         zeroes_count++;
-        current_pos++;
     }
 
-    std::vector<unsigned char> b256((base58.size() - current_pos) * 733 / 1000 + 1); // log(58) / log(256)
-    while (current_pos != base58.size()) {
-        auto carry = static_cast<int>(mapBase58[static_cast<std::int8_t>(base58[current_pos])]);
-        if (carry == -1) {
-            RAISE_ERROR(base::InvalidArgument, "Invalid base58 string");
+    // least significant limb goes first
+    std::vector<std::uint32_t> limbs;
+    limbs.reserve((base58.size() - zeroes_count) * 733 / 1000 / 4 + 1); // log(58) / log(256)
+    for (std::size_t current_pos = zeroes_count; current_pos != base58.size();) {
+        auto chunk_size = std::min(BASE58_LIMB_DIGITS, base58.size() - current_pos);
+        std::uint64_t carry = 0;
+        std::uint64_t multiplier = 1;
+        for (std::size_t i = 0; i < chunk_size; ++i) {
+            auto digit = mapBase58[static_cast<Byte>(base58[current_pos++])];
+            if (digit == -1) {
+                RAISE_ERROR(base::InvalidArgument, "Invalid base58 string");
+            }
+            carry = carry * 58 + static_cast<std::uint64_t>(digit);
+            multiplier *= 58;
         }
-        std::size_t i = 0;
-        for (auto it = b256.rbegin(); (carry != 0 || i < length) && (it != b256.rend()); ++it, ++i) {
-            carry += 58 * (*it);
-            *it = carry % 256;
-            carry /= 256;
+        for (auto& limb : limbs) {
+            carry += limb * multiplier;
+            limb = static_cast<std::uint32_t>(carry);
+            carry >>= 32;
+        }
+        if (carry != 0) {
+            limbs.push_back(static_cast<std::uint32_t>(carry));
         }
-        length = i;
-        current_pos++;
     }
 
-    auto it = b256.begin() + (b256.size() - length);
-    base::Bytes ret_bytes(std::vector<base::Byte>(zeroes_count, 0x00));
-    while (it != b256.end()) {
-        ret_bytes.append(*(it++));
+    std::size_t length = limbs.size() * 4;
+    while (length != 0 && ((limbs[(length - 1) / 4] >> (8 * ((length - 1) % 4))) & 0xFF) == 0) {
+        length--;
+    }
+    // leading zeroes are already set by the constructor
+    base::Bytes ret_bytes(zeroes_count + length);
+    auto* it = ret_bytes.getData() + zeroes_count;
+    for (std::size_t i = length; i != 0; --i) {
+        *(it++) = static_cast<Byte>(limbs[(i - 1) / 4] >> (8 * ((i - 1) % 4)));
     }
     return ret_bytes;
 }
@@ -307,5 +978,5 @@ base::Bytes base58Decode(std::string_view base58)
 
 std::size_t std::hash<base::Bytes>::operator()(const base::Bytes& k) const
 {
-    return boost::hash_value(k.toVector());
+    return boost::hash_range(k.getData(), k.getData() + k.size());
 }
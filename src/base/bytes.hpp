@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <initializer_list>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -15,12 +16,20 @@ namespace base
 template<std::size_t S>
 class FixedBytes;
 
+class SharedBytes;
 
+
+/*
+ *  Payloads of up to INLINE_CAPACITY bytes, that are hashes, addresses, database keys and storage values, are
+ *  kept inside the object, so they don't cost a heap allocation. Larger ones are kept on the heap.
+ */
 class Bytes
 {
   public:
     //==============
-    Bytes();
+    static constexpr std::size_t INLINE_CAPACITY = 56;
+    //==============
+    Bytes() noexcept;
     explicit Bytes(std::size_t size);
     explicit Bytes(const std::vector<Byte>& bytes);
     explicit Bytes(const std::string& s);
@@ -30,11 +39,11 @@ class Bytes
     template<std::size_t S>
     explicit Bytes(const FixedBytes<S>& bytes);
 
-    Bytes(const Bytes&) = default;
-    Bytes(Bytes&&) = default;
-    Bytes& operator=(const Bytes&) = default;
-    Bytes& operator=(Bytes&&) = default;
-    ~Bytes() = default;
+    Bytes(const Bytes& other);
+    Bytes(Bytes&& other) noexcept;
+    Bytes& operator=(const Bytes& other);
+    Bytes& operator=(Bytes&& other) noexcept;
+    ~Bytes();
     //==============
 
     template<typename I>
@@ -62,9 +71,6 @@ class Bytes
     const Byte* getData() const;
     Byte* getData();
     //==============
-    [[nodiscard]] std::vector<Byte>& toVector() noexcept;
-    [[nodiscard]] const std::vector<Byte>& toVector() const noexcept;
-    //==============
     [[nodiscard]] std::string toString() const;
     //==============
     bool operator==(const Bytes& another) const;
@@ -78,7 +84,20 @@ class Bytes
     //==============
 
   private:
-    std::vector<Byte> _raw;
+    //==============
+    Byte* _data;
+    std::size_t _size{ 0 };
+    std::size_t _capacity{ INLINE_CAPACITY };
+    Byte _inline[INLINE_CAPACITY];
+    //==============
+    bool isInline() const noexcept;
+    // keeps existing bytes, doesn't check the current capacity
+    void reallocate(std::size_t new_capacity);
+    // the capacity is grown geometrically, so appending bytes one by one is amortized constant
+    void ensureCapacity(std::size_t required_capacity);
+    void assign(const Byte* data, std::size_t size);
+    void stealFrom(Bytes& other) noexcept;
+    //==============
 };
 
 base::Bytes operator+(const base::Bytes& a, const base::Bytes& b);
@@ -127,6 +146,73 @@ class FixedBytes
     std::array<Byte, S> _array{};
 };
 
+/**
+ *  @brief Non-owning read-only view of contiguous bytes.
+ *
+ *  @note Viewed bytes must outlive the view and must not be reallocated while it is used.
+ */
+class BytesView
+{
+  public:
+    //==============
+    BytesView() = default;
+    BytesView(const Byte* bytes, std::size_t length) noexcept;
+    BytesView(const Bytes& bytes) noexcept;
+    BytesView(const SharedBytes& bytes) noexcept;
+
+    template<std::size_t S>
+    BytesView(const FixedBytes<S>& bytes) noexcept;
+    //==============
+    const Byte& operator[](std::size_t index) const;
+    //==============
+    [[nodiscard]] BytesView takePart(std::size_t begin_index, std::size_t one_past_end_index) const;
+    //==============
+    std::size_t size() const noexcept;
+    bool isEmpty() const noexcept;
+    const Byte* getData() const noexcept;
+    //==============
+    [[nodiscard]] Bytes toBytes() const;
+    //==============
+    bool operator==(const BytesView& another) const;
+    bool operator!=(const BytesView& another) const;
+    //==============
+  private:
+    const Byte* _data{ nullptr };
+    std::size_t _size{ 0 };
+};
+
+/**
+ *  @brief Read-only bytes, that are owned together by all their copies and parts.
+ *
+ *  Copying or taking a part doesn't copy bytes, so a received message can be passed from a socket to
+ *  decoded objects and storage without copies. Bytes are freed with the last object, that refers to them.
+ */
+class SharedBytes
+{
+  public:
+    //==============
+    SharedBytes() = default;
+    explicit SharedBytes(Bytes&& bytes);
+    //==============
+    const Byte& operator[](std::size_t index) const;
+    //==============
+    // the part refers to the same bytes
+    [[nodiscard]] SharedBytes takePart(std::size_t begin_index, std::size_t one_past_end_index) const;
+    //==============
+    std::size_t size() const noexcept;
+    bool isEmpty() const noexcept;
+    const Byte* getData() const noexcept;
+    //==============
+    [[nodiscard]] Bytes toBytes() const;
+    //==============
+    bool operator==(const SharedBytes& another) const;
+    bool operator!=(const SharedBytes& another) const;
+    //==============
+  private:
+    std::shared_ptr<const Bytes> _owner;
+    const Byte* _data{ nullptr };
+    std::size_t _size{ 0 };
+};
 
 template<typename T>
 std::string base64Encode(const T& bytes);
@@ -143,6 +229,19 @@ template<typename T>
 template<typename T>
 [[nodiscard]] T fromHex(const std::string_view& hex_view);
 
+namespace codec
+{
+// kernels of the codecs above, SSSE3 and AVX2 versions are picked at runtime if the CPU supports them
+
+// writes 2 * size hex digits
+void encodeHex(const Byte* bytes, std::size_t size, char* hex) noexcept;
+// reads 2 * size hex digits, returns false if any of them is not a hex digit
+bool decodeHex(const char* hex, std::size_t size, Byte* bytes) noexcept;
+
+std::string encodeBase64(const Byte* bytes, std::size_t size);
+std::string encodeBase58(const Byte* bytes, std::size_t size);
+} // namespace codec
+
 } // namespace base
 
 namespace std
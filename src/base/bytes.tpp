@@ -5,46 +5,29 @@
 #include "base/assert.hpp"
 #include "base/error.hpp"
 
-#include <openssl/pem.h>
-
 #include <boost/container_hash/hash.hpp>
 
 #include <algorithm>
-
-
-namespace
-{
-
-std::size_t hexToInt(char hex)
-{
-    if ('0' <= hex && hex <= '9') {
-        return hex - '0';
-    }
-    else if ('a' <= hex && hex <= 'f') {
-        return hex - 'a' + 10;
-    }
-    else if ('A' <= hex && hex <= 'F') {
-        return hex - 'A' + 10;
-    }
-    else {
-        RAISE_ERROR(base::InvalidArgument, "Non hex symbol");
-    }
-}
-
-} // namespace
+#include <iterator>
+#include <utility>
 
 namespace base
 {
 
 template<std::size_t S>
 Bytes::Bytes(const FixedBytes<S>& bytes)
-  : _raw(bytes.getData(), S)
+  : Bytes(bytes.getData(), S)
 {}
 
 template<typename I>
 Bytes::Bytes(I begin, I end)
-  : _raw(begin, end)
-{}
+  : Bytes()
+{
+    reserve(static_cast<std::size_t>(std::distance(begin, end)));
+    for (; begin != end; ++begin) {
+        append(static_cast<Byte>(*begin));
+    }
+}
 
 
 template<std::size_t S>
@@ -72,7 +55,7 @@ FixedBytes<S>::FixedBytes(const Bytes& bytes)
     if (S != bytes.size()) {
         RAISE_ERROR(base::InvalidArgument, "Invalid bytes size for FixedBytes");
     }
-    std::copy_n(bytes.toVector().begin(), S, _array.begin());
+    std::copy_n(bytes.getData(), S, _array.begin());
 }
 
 
@@ -225,17 +208,19 @@ bool FixedBytes<S>::operator>=(const FixedBytes<S>& another) const
 }
 
 
+template<std::size_t S>
+BytesView::BytesView(const FixedBytes<S>& bytes) noexcept
+  : _data{ bytes.getData() }
+  , _size{ S }
+{}
+
+
 template<typename T>
 std::string toHex(const T& bytes)
 {
-    static constexpr const char HEX_DIGITS[] = "0123456789abcdef";
     // since every byte is represented by 2 hex digits, we do * 2
     std::string ret(bytes.size() * 2, static_cast<char>(0));
-    std::size_t index = 0;
-    for (const Byte& c : bytes.toString()) {
-        ret[index++] = HEX_DIGITS[c >> 4];
-        ret[index++] = HEX_DIGITS[c & 0xF];
-    }
+    codec::encodeHex(bytes.getData(), bytes.size(), ret.data());
     return ret;
 }
 
@@ -247,91 +232,25 @@ T fromHex(const std::string_view& hex_view)
         RAISE_ERROR(InvalidArgument, "Invalid string length. Odd line length.");
     }
 
-    auto bytes_size = hex_view.size() / 2;
-    std::vector<Byte> bytes(bytes_size);
-    for (std::size_t current_symbol_index = 0; current_symbol_index < bytes_size; current_symbol_index++) {
-        auto index = current_symbol_index * 2;
-        auto high_part = hexToInt(hex_view[index]);
-        auto low_part = hexToInt(hex_view[index + 1]);
-        bytes[current_symbol_index] = (high_part << 4) + low_part;
+    Bytes bytes(hex_view.size() / 2);
+    if (!codec::decodeHex(hex_view.data(), bytes.size(), bytes.getData())) {
+        RAISE_ERROR(base::InvalidArgument, "Non hex symbol");
     }
-
-    return T(bytes);
+    return T(std::move(bytes));
 }
 
 
 template<typename T>
 std::string base64Encode(const T& bytes)
 {
-    if (bytes.size() == 0) {
-        return "";
-    }
-
-    BIO* bio_temp = BIO_new(BIO_s_mem());
-    BIO* b64 = BIO_new(BIO_f_base64());
-    BUF_MEM* bufferPtr = nullptr;
-
-    std::unique_ptr<BIO, decltype(&::BIO_free_all)> bio(BIO_push(b64, bio_temp), ::BIO_free_all);
-    BIO_set_flags(bio.get(), BIO_FLAGS_BASE64_NO_NL);
-    if (BIO_write(bio.get(), bytes.getData(), static_cast<int>(bytes.size())) < 1) {
-        RAISE_ERROR(CryptoError, "Base64 encode write error");
-    }
-    if (BIO_flush(bio.get()) < 1) {
-        RAISE_ERROR(CryptoError, "Base64 encode flush error");
-    }
-    if (BIO_get_mem_ptr(bio.get(), &bufferPtr) < 1) {
-        if (bufferPtr) {
-            BUF_MEM_free(bufferPtr);
-        }
-        RAISE_ERROR(CryptoError, "Get pointer to memory from base64 error");
-    }
-
-    std::string base64_bytes(bufferPtr->data, bufferPtr->length);
-
-    BUF_MEM_free(bufferPtr);
-    BIO_set_close(bio.get(), BIO_NOCLOSE);
-    return base64_bytes;
+    return codec::encodeBase64(bytes.getData(), bytes.size());
 }
 
 
-static constexpr char pszBase58[59] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
-
 template<typename T>
 std::string base58Encode(const T& bytes)
 {
-    std::size_t current_pos = 0;
-    std::size_t zeroes_count = 0;
-    std::size_t length = 0;
-    while (current_pos != bytes.size() && bytes[current_pos] == 0) {
-        current_pos++;
-        zeroes_count++;
-    }
-
-    base::Bytes b58(bytes.size() * 138 / 100 + 1); // log(256) / log(58)
-    while (current_pos != bytes.size()) {
-        auto carry = static_cast<std::size_t>(bytes[current_pos]);
-        std::size_t i = 0;
-        for (auto it = b58.toVector().rbegin(); (carry != 0 || i < length) && (it != b58.toVector().rend());
-             it++, i++) {
-            carry += 256 * (*it);
-            *it = carry % 58;
-            carry /= 58;
-        }
-        length = i;
-        current_pos++;
-    }
-    auto it = b58.toVector().begin() + (b58.size() - length);
-    while (it != b58.toVector().end() && *it == 0) {
-        it++;
-    }
-
-    std::string str;
-    str.reserve(zeroes_count + (b58.toVector().end() - it));
-    str.assign(zeroes_count, '1');
-    while (it != b58.toVector().end()) {
-        str += pszBase58[*(it++)];
-    }
-    return str;
+    return codec::encodeBase58(bytes.getData(), bytes.size());
 }
 
 
@@ -41,6 +41,12 @@ static_assert(false, "cannot determine OS");
 
 //------------------------
 
+// macro CONFIG_ARCH_X86 definition, x86 SIMD code is built with target attributes of GCC and Clang
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CONFIG_ARCH_X86
+#endif
+//------------------------
+
 // constexpr OS_NAME definition
 constexpr const char* const OS_NAME =
 #if defined(_WIN32) || defined(_WIN64)
@@ -73,12 +79,28 @@ constexpr int EXIT_ASSERT_FAILED = 2;
 //------------------------
 
 // net
-constexpr std::size_t NET_MESSAGE_BUFFER_SIZE = 16 * 1024; // 16KB
-constexpr std::size_t NET_PING_FREQUENCY = 7000;           // seconds
+constexpr std::size_t NET_PING_FREQUENCY = 7000; // seconds
 //------------------------
 
 // blockchain
 constexpr std::size_t BC_MAX_TRANSACTIONS_IN_BLOCK = 100;
+constexpr std::size_t BC_TOP_BLOCKS_CACHE_SIZE = 1000;     // number of the latest blocks, that are always in memory
+constexpr std::size_t BC_RECENT_BLOCKS_CACHE_SIZE = 1000;  // number of other recently requested blocks in memory
+constexpr std::size_t BC_PRUNE_DEPTH = 0;                  // bodies of deeper blocks are dropped, 0 keeps all
+constexpr std::size_t BC_PRUNE_MAX_BLOCKS_PER_PASS = 1000; // blocks pruned by a single write at most
+constexpr std::size_t BC_BLOCK_FILE_MAX_SIZE = 128 * 1024 * 1024; // 128MB segment of block files
+//------------------------
+
+// state
+constexpr std::size_t STATE_ACCOUNTS_CACHE_SIZE = 10000;        // number of recently used accounts in memory
+constexpr std::size_t STATE_STORAGE_VALUES_CACHE_SIZE = 100000; // number of storage values of those accounts in memory
+constexpr std::size_t STATE_CODES_CACHE_SIZE = 1000;            // number of recently used codes of contracts in memory
+constexpr std::size_t STATE_OUTPUTS_CACHE_SIZE = 10000;         // number of recent outputs of transactions in memory
+constexpr std::size_t STATE_OUTPUTS_RETENTION_DEPTH = 0;        // outputs of deeper blocks are dropped, 0 keeps all
+//------------------------
+
+// snapshot
+constexpr std::size_t SNAPSHOT_CHUNK_SIZE = 1024 * 1024; // 1MB of records in a single checksummed chunk at least
 //------------------------
 
 // rpc
@@ -90,6 +112,8 @@ constexpr std::size_t DATABASE_WRITE_BUFFER_SIZE = 50 * 1024 * 1024;     // 50MB
 constexpr std::size_t DATABASE_DATA_BLOCK_SIZE = 10 * 1024;              // 10KB data-block size
 constexpr std::size_t DATABASE_DATA_BLOCK_CACHE_SIZE = 50 * 1024 * 1024; // 50MB data-block cache size
 constexpr bool DATABASE_COMPRESS_DATA = false;                           // no compress data
+constexpr std::size_t DATABASE_GROUP_COMMIT_MAX_DELAY = 100;             // milliseconds a block may wait for a write
+constexpr std::size_t DATABASE_GROUP_COMMIT_MAX_BLOCKS = 100;            // blocks written by a single write at most
 //--------------------
 
 // keys paths
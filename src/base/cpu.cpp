@@ -0,0 +1,66 @@
+#include "cpu.hpp"
+
+#include "base/config.hpp"
+
+#ifdef CONFIG_ARCH_X86
+#include <cpuid.h>
+#endif
+
+namespace
+{
+
+struct Features
+{
+    bool ssse3{ false };
+    bool avx2{ false };
+    bool sha{ false };
+};
+
+
+Features detectFeatures() noexcept
+{
+    Features features;
+#ifdef CONFIG_ARCH_X86
+    __builtin_cpu_init();
+    features.ssse3 = __builtin_cpu_supports("ssse3");
+    features.avx2 = __builtin_cpu_supports("avx2");
+
+    // SHA extensions are reported in EBX of the leaf 7, bit 29
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        features.sha = (ebx & (1u << 29)) && __builtin_cpu_supports("sse4.1");
+    }
+#endif
+    return features;
+}
+
+
+const Features& getFeatures() noexcept
+{
+    static const Features features = detectFeatures();
+    return features;
+}
+
+} // namespace
+
+namespace base::cpu
+{
+
+bool hasSsse3() noexcept
+{
+    return getFeatures().ssse3;
+}
+
+
+bool hasAvx2() noexcept
+{
+    return getFeatures().avx2;
+}
+
+
+bool hasSha() noexcept
+{
+    return getFeatures().sha;
+}
+
+} // namespace base::cpu
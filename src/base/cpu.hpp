@@ -0,0 +1,12 @@
+#pragma once
+
+namespace base::cpu
+{
+
+// instruction sets, that vectorized kernels of base pick at runtime, they are detected once per process
+bool hasSsse3() noexcept;
+bool hasAvx2() noexcept;
+// SHA extensions, their kernels also need SSE4.1, so it is checked too
+bool hasSha() noexcept;
+
+} // namespace base::cpu
@@ -14,6 +14,7 @@
 #include <include/secp256k1.h>
 #include <include/secp256k1_recovery.h>
 
+#include <array>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
@@ -22,6 +23,10 @@
 namespace
 {
 
+// number of public keys, that are loaded last by a thread and are reused when the same keys are loaded again
+constexpr std::size_t RECENT_PUBLIC_KEYS_COUNT = 16;
+
+
 base::Bytes readAllFile(const std::filesystem::path& path)
 {
     if (!std::filesystem::exists(path)) {
@@ -72,34 +77,27 @@ namespace base
 {
 
 RsaPublicKey::RsaPublicKey(const base::Bytes& key_word)
-  : _rsa_key(loadKey(key_word))
-  , _encrypted_message_size(RSA_size(_rsa_key.get()))
+  : RsaPublicKey(BytesView(key_word))
 {}
 
 
-RsaPublicKey::RsaPublicKey(const RsaPublicKey& another)
-  : _rsa_key(loadKey(another.toBytes()))
-  , _encrypted_message_size(another._encrypted_message_size)
+RsaPublicKey::RsaPublicKey(BytesView key_word)
+  : _data{ loadKey(key_word) }
 {}
 
 
-RsaPublicKey& RsaPublicKey::operator=(const RsaPublicKey& another)
-{
-    _rsa_key = loadKey(another.toBytes());
-    _encrypted_message_size = another._encrypted_message_size;
-    return *this;
-}
-
-
 Bytes RsaPublicKey::encrypt(const Bytes& message) const
 {
     if (message.size() > maxEncryptSize()) {
         RAISE_ERROR(InvalidArgument, "large message size for RSA encryption");
     }
 
-    Bytes encrypted_message(_encrypted_message_size);
-    if (!RSA_public_encrypt(
-          message.size(), message.getData(), encrypted_message.getData(), _rsa_key.get(), RSA_PKCS1_OAEP_PADDING)) {
+    Bytes encrypted_message(_data->encrypted_message_size);
+    if (!RSA_public_encrypt(message.size(),
+                            message.getData(),
+                            encrypted_message.getData(),
+                            _data->rsa_key.get(),
+                            RSA_PKCS1_OAEP_PADDING)) {
         RAISE_ERROR(CryptoError, "rsa encryption failed");
     }
 
@@ -131,15 +129,15 @@ Bytes RsaPublicKey::encryptWithAes(const Bytes& message) const
 
 Bytes RsaPublicKey::decrypt(const Bytes& encrypted_message) const
 {
-    if (encrypted_message.size() != _encrypted_message_size) {
+    if (encrypted_message.size() != _data->encrypted_message_size) {
         RAISE_ERROR(InvalidArgument, "large message size for RSA encryption");
     }
 
-    Bytes decrypted_message(_encrypted_message_size);
+    Bytes decrypted_message(_data->encrypted_message_size);
     auto message_size = RSA_public_decrypt(encrypted_message.size(),
                                            encrypted_message.getData(),
                                            decrypted_message.getData(),
-                                           _rsa_key.get(),
+                                           _data->rsa_key.get(),
                                            RSA_PKCS1_PADDING);
     if (message_size == -1) {
         RAISE_ERROR(CryptoError, "rsa decryption failed");
@@ -151,7 +149,7 @@ Bytes RsaPublicKey::decrypt(const Bytes& encrypted_message) const
 
 std::size_t RsaPublicKey::maxEncryptSize() const noexcept
 {
-    return _encrypted_message_size - ASYMMETRIC_DIFFERENCE;
+    return _data->encrypted_message_size - ASYMMETRIC_DIFFERENCE;
 }
 
 
@@ -169,42 +167,47 @@ RsaPublicKey RsaPublicKey::load(const std::filesystem::path& path)
 
 Bytes RsaPublicKey::toBytes() const
 {
-    std::unique_ptr<BIO, decltype(&::BIO_free)> public_bio(BIO_new(BIO_s_mem()), ::BIO_free);
-
-    if (!PEM_write_bio_RSAPublicKey(public_bio.get(), _rsa_key.get())) {
-        RAISE_ERROR(CryptoError, "failed to write public RSA key to big num");
-    }
-
-    Bytes public_key_bytes(BIO_pending(public_bio.get()));
-    if (!BIO_read(public_bio.get(), public_key_bytes.getData(), public_key_bytes.size())) {
-        RAISE_ERROR(CryptoError, "failed to write big num with public RSA to bytes");
-    }
-
-    return public_key_bytes;
+    return _data->key_word;
 }
 
 
-std::unique_ptr<RSA, decltype(&::RSA_free)> RsaPublicKey::loadKey(const Bytes& key_word)
+std::shared_ptr<const RsaPublicKey::Data> RsaPublicKey::loadKey(BytesView key_word)
 {
+    // transactions of a block are often signed by the same senders, so keys loaded last by the thread are
+    // reused instead of being parsed by OpenSSL again
+    thread_local std::array<std::shared_ptr<const Data>, RECENT_PUBLIC_KEYS_COUNT> recent_keys;
+    thread_local std::size_t next_replaced_index = 0;
+    for (const auto& key : recent_keys) {
+        if (key && BytesView(key->key_word) == key_word) {
+            return key;
+        }
+    }
+
     std::unique_ptr<BIO, decltype(&::BIO_free)> bio(BIO_new_mem_buf(key_word.getData(), key_word.size()), ::BIO_free);
     RSA* rsa_key = nullptr;
     if (!PEM_read_bio_RSAPublicKey(bio.get(), &rsa_key, nullptr, nullptr)) {
         RAISE_ERROR(CryptoError, "Fail to read public RSA key");
     }
-    return std::unique_ptr<RSA, decltype(&::RSA_free)>(rsa_key, ::RSA_free);
+    std::unique_ptr<RSA, decltype(&::RSA_free)> rsa(rsa_key, ::RSA_free);
+    auto encrypted_message_size = static_cast<std::size_t>(RSA_size(rsa.get()));
+    auto key = std::make_shared<const Data>(Data{ key_word.toBytes(), std::move(rsa), encrypted_message_size });
+
+    recent_keys[next_replaced_index] = key;
+    next_replaced_index = (next_replaced_index + 1) % recent_keys.size();
+    return key;
 }
 
 
 RsaPublicKey RsaPublicKey::deserialize(base::SerializationIArchive& ia)
 {
-    base::Bytes bytes = ia.deserialize<base::Bytes>();
-    return { bytes };
+    // the key is parsed right from deserialized bytes, they are copied only if the key wasn't loaded recently
+    return RsaPublicKey{ ia.deserialize<base::BytesView>() };
 }
 
 
 void RsaPublicKey::serialize(base::SerializationOArchive& oa) const
 {
-    oa.serialize(toBytes());
+    oa.serialize(_data->key_word);
 }
 
 std::ostream& operator<<(std::ostream& os, const RsaPublicKey& public_key)
@@ -19,9 +19,10 @@ class RsaPublicKey
   public:
     //=================
     RsaPublicKey(const Bytes& key_word);
-    RsaPublicKey(const RsaPublicKey& another);
+    explicit RsaPublicKey(BytesView key_word);
+    RsaPublicKey(const RsaPublicKey& another) = default;
     RsaPublicKey(RsaPublicKey&& another) = default;
-    RsaPublicKey& operator=(const RsaPublicKey& another);
+    RsaPublicKey& operator=(const RsaPublicKey& another) = default;
     RsaPublicKey& operator=(RsaPublicKey&& another) = default;
     //=================
     Bytes encrypt(const Bytes& message) const;
@@ -41,10 +42,18 @@ class RsaPublicKey
     //=================
     static constexpr std::size_t ASYMMETRIC_DIFFERENCE = 42;
     //=================
-    std::unique_ptr<RSA, decltype(&::RSA_free)> _rsa_key;
-    std::size_t _encrypted_message_size;
+    // a parsed key is never changed, so it is shared by copies and by keys loaded from the same bytes
+    struct Data
+    {
+        // the key is kept in its PEM form too, so serialization doesn't export it through OpenSSL every time
+        Bytes key_word;
+        std::unique_ptr<RSA, decltype(&::RSA_free)> rsa_key;
+        std::size_t encrypted_message_size;
+    };
+
+    std::shared_ptr<const Data> _data;
     //=================
-    static std::unique_ptr<RSA, decltype(&::RSA_free)> loadKey(const Bytes& key_word);
+    static std::shared_ptr<const Data> loadKey(BytesView key_word);
     //=================
 };
 
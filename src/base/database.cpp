@@ -1,13 +1,171 @@
 #include "database.hpp"
 
+#include "base/assert.hpp"
 #include "base/config.hpp"
 #include "base/error.hpp"
 
 #include <leveldb/cache.h>
 
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+
+// leveldb copies sliced bytes itself, so they are not copied to a string before
+leveldb::Slice toSlice(base::BytesView bytes)
+{
+    return leveldb::Slice(reinterpret_cast<const char*>(bytes.getData()), bytes.size());
+}
+
+} // namespace
+
+
 namespace base
 {
 
+void Database::WriteBatch::put(const Bytes& key, BytesView value)
+{
+    _batch.Put(toSlice(key), toSlice(value));
+    ++_operations_count;
+}
+
+
+void Database::WriteBatch::remove(const Bytes& key)
+{
+    _batch.Delete(key.toString());
+    ++_operations_count;
+}
+
+
+void Database::WriteBatch::append(const WriteBatch& another)
+{
+    _batch.Append(another._batch);
+    _operations_count += another._operations_count;
+}
+
+
+void Database::WriteBatch::clear()
+{
+    _batch.Clear();
+    _operations_count = 0;
+}
+
+
+bool Database::WriteBatch::isEmpty() const noexcept
+{
+    return _operations_count == 0;
+}
+
+
+std::size_t Database::WriteBatch::size() const noexcept
+{
+    return _operations_count;
+}
+
+
+Database::Snapshot::Snapshot(SnapshotPtr snapshot)
+  : _snapshot{ std::move(snapshot) }
+{}
+
+
+Database::Iterator::Iterator(std::unique_ptr<leveldb::Iterator> iterator, const Bytes& prefix, Direction direction)
+  : _iterator{ std::move(iterator) }
+  , _prefix{ prefix.toString() }
+  , _direction{ direction }
+{
+    if (_direction == Direction::FORWARD) {
+        _iterator->Seek(_prefix);
+    }
+    else {
+        seekToPrefixEnd();
+    }
+    checkStatus();
+}
+
+
+bool Database::Iterator::isValid() const
+{
+    return _iterator->Valid() && _iterator->key().starts_with(_prefix);
+}
+
+
+void Database::Iterator::next()
+{
+    if (_direction == Direction::FORWARD) {
+        _iterator->Next();
+    }
+    else {
+        _iterator->Prev();
+    }
+    checkStatus();
+}
+
+
+void Database::Iterator::seek(const Bytes& key)
+{
+    auto target = key.toString();
+    _iterator->Seek(target);
+    if (_direction == Direction::BACKWARD) {
+        if (!_iterator->Valid()) {
+            _iterator->SeekToLast();
+        }
+        else if (_iterator->key().compare(target) > 0) {
+            _iterator->Prev();
+        }
+    }
+    checkStatus();
+}
+
+
+Bytes Database::Iterator::key() const
+{
+    ASSERT(isValid());
+    auto key = _iterator->key();
+    return Bytes(reinterpret_cast<const Byte*>(key.data()), key.size());
+}
+
+
+Bytes Database::Iterator::value() const
+{
+    ASSERT(isValid());
+    auto value = _iterator->value();
+    return Bytes(reinterpret_cast<const Byte*>(value.data()), value.size());
+}
+
+
+void Database::Iterator::seekToPrefixEnd()
+{
+    // the first key after all keys with the prefix is the prefix with its last non-0xFF byte incremented
+    auto upper_bound = _prefix;
+    while (!upper_bound.empty() && static_cast<Byte>(upper_bound.back()) == 0xFF) {
+        upper_bound.pop_back();
+    }
+
+    if (upper_bound.empty()) {
+        _iterator->SeekToLast();
+        return;
+    }
+
+    upper_bound.back() = static_cast<char>(static_cast<Byte>(upper_bound.back()) + 1);
+    _iterator->Seek(upper_bound);
+    if (_iterator->Valid()) {
+        _iterator->Prev();
+    }
+    else {
+        _iterator->SeekToLast();
+    }
+}
+
+
+void Database::Iterator::checkStatus() const
+{
+    if (auto const status = _iterator->status(); !status.ok()) {
+        RAISE_ERROR(base::DatabaseError, status.ToString());
+    }
+}
+
+
 Database::Database(Directory const& path)
 {
     open(path);
@@ -58,9 +216,21 @@ void Database::open(Directory const& path)
 std::optional<Bytes> Database::get(const Bytes& key) const
 {
     checkStatus();
+    return get(key, _read_options);
+}
+
+
+std::optional<Bytes> Database::get(const Bytes& key, const Snapshot& snapshot) const
+{
+    checkStatus();
+    return get(key, createReadOptions(snapshot));
+}
+
 
+std::optional<Bytes> Database::get(const Bytes& key, const leveldb::ReadOptions& options) const
+{
     std::string value;
-    auto const status = _database->Get(_read_options, key.toString(), &value);
+    auto const status = _database->Get(options, key.toString(), &value);
     if (!status.ok()) {
         return std::nullopt;
     }
@@ -68,28 +238,71 @@ std::optional<Bytes> Database::get(const Bytes& key) const
 }
 
 
+std::vector<std::optional<Bytes>> Database::getMany(const std::vector<Bytes>& keys) const
+{
+    checkStatus();
+    auto snapshot = createSnapshot();
+    return getMany(keys, createReadOptions(snapshot));
+}
+
+
+std::vector<std::optional<Bytes>> Database::getMany(const std::vector<Bytes>& keys, const Snapshot& snapshot) const
+{
+    checkStatus();
+    return getMany(keys, createReadOptions(snapshot));
+}
+
+
+std::vector<std::optional<Bytes>> Database::getMany(const std::vector<Bytes>& keys,
+                                                    const leveldb::ReadOptions& options) const
+{
+    // reading in order of keys touches neighbour data-blocks one after another
+    std::vector<std::size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&keys](std::size_t a, std::size_t b) { return keys[a] < keys[b]; });
+
+    std::vector<std::optional<Bytes>> values(keys.size());
+    for (auto index : order) {
+        values[index] = get(keys[index], options);
+    }
+    return values;
+}
+
+
 bool Database::exists(const Bytes& key) const
 {
     checkStatus();
+    return exists(key, _read_options);
+}
+
+
+bool Database::exists(const Bytes& key, const Snapshot& snapshot) const
+{
+    checkStatus();
+    return exists(key, createReadOptions(snapshot));
+}
+
 
+bool Database::exists(const Bytes& key, const leveldb::ReadOptions& options) const
+{
+    // a point lookup is cheaper than seeking an iterator, which merges all levels of the database
     std::string value;
-    auto const status = _database->Get(_read_options, key.toString(), &value);
+    auto const status = _database->Get(options, key.toString(), &value);
     if (status.IsNotFound()) {
         return false;
     }
     if (!status.ok()) {
         RAISE_ERROR(base::DatabaseError, status.ToString());
     }
-
     return true;
 }
 
 
-void Database::put(const Bytes& key, const Bytes& value)
+void Database::put(const Bytes& key, BytesView value)
 {
     checkStatus();
 
-    auto const status = _database->Put(_write_options, key.toString(), value.toString());
+    auto const status = _database->Put(_write_options, toSlice(key), toSlice(value));
     if (!status.ok()) {
         RAISE_ERROR(base::DatabaseError, status.ToString());
     }
@@ -107,6 +320,77 @@ void Database::remove(const Bytes& key)
 }
 
 
+void Database::write(WriteBatch& batch)
+{
+    write(batch, _write_options);
+}
+
+
+void Database::writeUnsynced(WriteBatch& batch)
+{
+    auto options = _write_options;
+    options.sync = false;
+    write(batch, options);
+}
+
+
+void Database::write(WriteBatch& batch, const leveldb::WriteOptions& options)
+{
+    checkStatus();
+
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    auto const status = _database->Write(options, &batch._batch);
+    if (!status.ok()) {
+        RAISE_ERROR(base::DatabaseError, status.ToString());
+    }
+}
+
+
+Database::Snapshot Database::createSnapshot() const
+{
+    checkStatus();
+
+    auto* database = _database.get();
+    return Snapshot(Snapshot::SnapshotPtr(database->GetSnapshot(), [database](const leveldb::Snapshot* snapshot) {
+        database->ReleaseSnapshot(snapshot);
+    }));
+}
+
+
+Database::Iterator Database::createIterator(const Bytes& prefix, Direction direction) const
+{
+    checkStatus();
+    return createIterator(prefix, _read_options, direction);
+}
+
+
+Database::Iterator Database::createIterator(const Bytes& prefix, const Snapshot& snapshot, Direction direction) const
+{
+    checkStatus();
+    return createIterator(prefix, createReadOptions(snapshot), direction);
+}
+
+
+Database::Iterator Database::createIterator(const Bytes& prefix,
+                                            leveldb::ReadOptions options,
+                                            Direction direction) const
+{
+    options.fill_cache = false; // scans must not evict hot data-blocks from the cache
+    return Iterator(std::unique_ptr<leveldb::Iterator>(_database->NewIterator(options)), prefix, direction);
+}
+
+
+leveldb::ReadOptions Database::createReadOptions(const Snapshot& snapshot) const
+{
+    auto options = _read_options;
+    options.snapshot = snapshot._snapshot.get();
+    return options;
+}
+
+
 void Database::checkStatus() const
 {
     if (!_inited) {
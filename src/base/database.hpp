@@ -5,11 +5,14 @@
 
 #include <leveldb/cache.h>
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace base
 {
@@ -17,6 +20,110 @@ namespace base
 class Database
 {
   public:
+    //======================
+    /**
+     *  @brief Set of put/remove operations, that are applied to a database atomically by Database::write.
+     */
+    class WriteBatch
+    {
+      public:
+        //======================
+        WriteBatch() = default;
+        WriteBatch(const WriteBatch&) = default;
+        WriteBatch(WriteBatch&&) = default;
+        WriteBatch& operator=(const WriteBatch&) = default;
+        WriteBatch& operator=(WriteBatch&&) = default;
+        ~WriteBatch() = default;
+        //======================
+        void put(const Bytes& key, BytesView value);
+
+        template<std::size_t S>
+        void put(const Bytes& key, const FixedBytes<S>& value);
+        void remove(const Bytes& key);
+        // operations of another batch are applied after operations of this one
+        void append(const WriteBatch& another);
+        //======================
+        void clear();
+        bool isEmpty() const noexcept;
+        std::size_t size() const noexcept;
+        //======================
+      private:
+        friend class Database;
+        //======================
+        leveldb::WriteBatch _batch;
+        std::size_t _operations_count{ 0 };
+        //======================
+    };
+    //======================
+    /**
+     *  @brief Consistent read-only view of a database at the moment of creation.
+     *
+     *  @note Must not outlive the database it was created from.
+     */
+    class Snapshot
+    {
+      public:
+        //======================
+        Snapshot(const Snapshot&) = delete;
+        Snapshot(Snapshot&&) = default;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot& operator=(Snapshot&&) = default;
+        ~Snapshot() = default;
+        //======================
+      private:
+        friend class Database;
+        //======================
+        using SnapshotPtr = std::unique_ptr<const leveldb::Snapshot, std::function<void(const leveldb::Snapshot*)>>;
+        //======================
+        explicit Snapshot(SnapshotPtr snapshot);
+        //======================
+        SnapshotPtr _snapshot;
+        //======================
+    };
+    //======================
+    enum class Direction
+    {
+        FORWARD,
+        BACKWARD
+    };
+    //======================
+    /**
+     *  @brief Iterator over keys, that start with a given prefix, in lexicographical or reverse order.
+     *
+     *  @note Iterator sees the database as it was at the moment of iterator creation.
+     */
+    class Iterator
+    {
+      public:
+        //======================
+        Iterator(const Iterator&) = delete;
+        Iterator(Iterator&&) = default;
+        Iterator& operator=(const Iterator&) = delete;
+        Iterator& operator=(Iterator&&) = default;
+        ~Iterator() = default;
+        //======================
+        bool isValid() const;
+        void next();
+        // positions at the first key not less (FORWARD) or the last key not greater (BACKWARD) than a given one
+        void seek(const Bytes& key);
+        //======================
+        Bytes key() const;
+        Bytes value() const;
+        //======================
+      private:
+        friend class Database;
+        //======================
+        Iterator(std::unique_ptr<leveldb::Iterator> iterator, const Bytes& prefix, Direction direction);
+        //======================
+        std::unique_ptr<leveldb::Iterator> _iterator;
+        std::string _prefix;
+        Direction _direction;
+        //======================
+        void seekToPrefixEnd();
+        void checkStatus() const;
+        //======================
+    };
+    //======================
     explicit Database() = default;
     explicit Database(Directory const& path);
     Database(Database&&) = default;
@@ -26,13 +133,35 @@ class Database
     void open(Directory const& path);
     //======================
     [[nodiscard]] std::optional<Bytes> get(const Bytes& key) const;
+    [[nodiscard]] std::optional<Bytes> get(const Bytes& key, const Snapshot& snapshot) const;
+    // all values are read from one snapshot, the order of results is the same as the order of keys
+    [[nodiscard]] std::vector<std::optional<Bytes>> getMany(const std::vector<Bytes>& keys) const;
+    [[nodiscard]] std::vector<std::optional<Bytes>> getMany(const std::vector<Bytes>& keys,
+                                                            const Snapshot& snapshot) const;
+    // the value is read and dropped, so it costs the same as get
     bool exists(const Bytes& key) const;
-    void put(const Bytes& key, const Bytes& value);
+    bool exists(const Bytes& key, const Snapshot& snapshot) const;
+    void put(const Bytes& key, BytesView value);
 
     template<std::size_t S>
     void put(const Bytes& key, const FixedBytes<S>& value);
     void remove(const Bytes& key);
     //======================
+    // applies all operations of the batch atomically and with a single sync to disk
+    void write(WriteBatch& batch);
+    // the same as write, but without a sync: a crash of the system may lose the batch, though never a part of it,
+    // and the batch is on disk after any later synced write
+    void writeUnsynced(WriteBatch& batch);
+    //======================
+    [[nodiscard]] Snapshot createSnapshot() const;
+    //======================
+    // iterator is positioned at the first (FORWARD) or the last (BACKWARD) key with a given prefix;
+    // an empty prefix means the whole database
+    [[nodiscard]] Iterator createIterator(const Bytes& prefix, Direction direction = Direction::FORWARD) const;
+    [[nodiscard]] Iterator createIterator(const Bytes& prefix,
+                                          const Snapshot& snapshot,
+                                          Direction direction = Direction::FORWARD) const;
+    //======================
   private:
     //======================
     bool _inited{ false };
@@ -43,6 +172,13 @@ class Database
     std::unique_ptr<leveldb::Cache> _cache;
     //=====================
     void checkStatus() const;
+    leveldb::ReadOptions createReadOptions(const Snapshot& snapshot) const;
+    std::optional<Bytes> get(const Bytes& key, const leveldb::ReadOptions& options) const;
+    bool exists(const Bytes& key, const leveldb::ReadOptions& options) const;
+    std::vector<std::optional<Bytes>> getMany(const std::vector<Bytes>& keys,
+                                              const leveldb::ReadOptions& options) const;
+    Iterator createIterator(const Bytes& prefix, leveldb::ReadOptions options, Direction direction) const;
+    void write(WriteBatch& batch, const leveldb::WriteOptions& options);
     //=====================
 };
 
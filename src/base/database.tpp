@@ -13,4 +13,12 @@ void Database::put(const Bytes& key, const FixedBytes<S>& value)
         RAISE_ERROR(base::DatabaseError, status.ToString());
     }
 }
+
+
+template<std::size_t S>
+void Database::WriteBatch::put(const Bytes& key, const FixedBytes<S>& value)
+{
+    _batch.Put(key.toString(), value.toString());
+    ++_operations_count;
+}
 } // namespace base
\ No newline at end of file
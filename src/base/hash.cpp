@@ -1,12 +1,316 @@
 #include "hash.hpp"
 
 #include "base/assert.hpp"
+#include "base/config.hpp"
+#include "base/cpu.hpp"
 #include "base/error.hpp"
 
 #include <openssl/evp.h>
 #include <openssl/ripemd.h>
 #include <openssl/sha.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+#ifdef CONFIG_ARCH_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+constexpr std::size_t SHA256_BLOCK_SIZE = base::Sha256::SHA256_BLOCK_SIZE;
+
+constexpr std::uint32_t SHA256_INITIAL_STATE[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                                    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+
+void storeBigEndian32(std::uint32_t value, base::Byte* p) noexcept
+{
+    p[0] = static_cast<base::Byte>(value >> 24);
+    p[1] = static_cast<base::Byte>(value >> 16);
+    p[2] = static_cast<base::Byte>(value >> 8);
+    p[3] = static_cast<base::Byte>(value);
+}
+
+
+// the end of a message, that doesn't fill a whole block, followed by the 0x80 byte, zeroes and the message length
+// in bits, that are one or two blocks
+struct Sha256Tail
+{
+    base::Byte blocks[2 * SHA256_BLOCK_SIZE];
+    std::size_t blocks_count;
+};
+
+
+// rest is the end of a message, that doesn't fill a whole block
+void makeTail(base::BytesView rest, std::uint64_t message_size, Sha256Tail& tail) noexcept
+{
+    tail.blocks_count = rest.size() + 1 + sizeof(std::uint64_t) > SHA256_BLOCK_SIZE ? 2 : 1;
+    std::memset(tail.blocks, 0, sizeof(tail.blocks));
+    if (!rest.isEmpty()) {
+        std::memcpy(tail.blocks, rest.getData(), rest.size());
+    }
+    tail.blocks[rest.size()] = 0x80;
+
+    const std::uint64_t bits_count = message_size * 8;
+    auto* length = tail.blocks + tail.blocks_count * SHA256_BLOCK_SIZE - sizeof(std::uint64_t);
+    storeBigEndian32(static_cast<std::uint32_t>(bits_count >> 32), length);
+    storeBigEndian32(static_cast<std::uint32_t>(bits_count), length + 4);
+}
+
+
+using Sha256Compress = void (*)(std::uint32_t* state, const base::Byte* blocks, std::size_t blocks_count);
+
+
+// OpenSSL block function, that is its assembly for the CPU, is called without the per call setup of SHA256()
+void compressOpenSsl(std::uint32_t* state, const base::Byte* blocks, std::size_t blocks_count)
+{
+    SHA256_CTX context;
+    std::copy(state, state + 8, context.h);
+    for (; blocks_count > 0; --blocks_count, blocks += SHA256_BLOCK_SIZE) {
+        SHA256_Transform(&context, blocks);
+    }
+    std::copy(context.h, context.h + 8, state);
+}
+
+#ifdef CONFIG_ARCH_X86
+
+alignas(16) constexpr std::uint32_t SHA256_ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+
+// 4 rounds by SHA extensions, that keep the state as ABEF and CDGH halves; while they go, msg1/msg2 schedule words
+// of the next groups, so the groups are expanded at compile time and the words stay in registers
+template<int Group>
+__attribute__((target("sha,sse4.1"), always_inline)) inline void roundsSha(__m128i& state0,
+                                                                         __m128i& state1,
+                                                                         __m128i (&words)[4],
+                                                                         const base::Byte* block)
+{
+    auto& current = words[Group % 4];
+    if constexpr (Group < 4) {
+        const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+        current = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + Group * 16)), byte_swap);
+    }
+    auto message = _mm_add_epi32(
+      current, _mm_load_si128(reinterpret_cast<const __m128i*>(SHA256_ROUND_CONSTANTS + Group * 4)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+    if constexpr (Group >= 3 && Group < 15) {
+        auto& next = words[(Group + 1) % 4];
+        next = _mm_add_epi32(next, _mm_alignr_epi8(current, words[(Group + 3) % 4], 4));
+        next = _mm_sha256msg2_epu32(next, current);
+    }
+    message = _mm_shuffle_epi32(message, 0x0E);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, message);
+    if constexpr (Group >= 1 && Group < 13) {
+        auto& previous = words[(Group + 3) % 4];
+        previous = _mm_sha256msg1_epu32(previous, current);
+    }
+}
+
+
+template<int... Groups>
+__attribute__((target("sha,sse4.1"), always_inline)) inline void compressBlockSha(
+  __m128i& state0, __m128i& state1, const base::Byte* block, std::integer_sequence<int, Groups...>)
+{
+    __m128i words[4];
+    (roundsSha<Groups>(state0, state1, words, block), ...);
+}
+
+
+__attribute__((target("sha,sse4.1"))) void compressSha(std::uint32_t* state,
+                                                       const base::Byte* blocks,
+                                                       std::size_t blocks_count)
+{
+    auto tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    auto state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);            // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1B);      // EFGH
+    auto state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);   // CDGH
+
+    for (; blocks_count > 0; --blocks_count, blocks += SHA256_BLOCK_SIZE) {
+        const auto saved_state0 = state0;
+        const auto saved_state1 = state1;
+        compressBlockSha(state0, state1, blocks, std::make_integer_sequence<int, 16>{});
+        state0 = _mm_add_epi32(state0, saved_state0);
+        state1 = _mm_add_epi32(state1, saved_state1);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);       // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);    // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0); // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);    // ABEF
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+
+constexpr std::size_t AVX2_LANES_COUNT = 8;
+
+
+template<int N>
+__attribute__((target("avx2"))) __m256i rotateRight(__m256i x) noexcept
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+}
+
+
+// loads 8 big-endian words from every lane's block, so that a vector holds the same word of all lanes
+__attribute__((target("avx2"))) void loadWordsAvx2(const base::Byte* const* blocks, std::size_t offset, __m256i* words)
+{
+    __m256i rows[AVX2_LANES_COUNT];
+    for (std::size_t lane = 0; lane < AVX2_LANES_COUNT; ++lane) {
+        rows[lane] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[lane] + offset));
+    }
+
+    __m256i pairs[AVX2_LANES_COUNT];
+    for (std::size_t i = 0; i < AVX2_LANES_COUNT; i += 4) {
+        const auto low01 = _mm256_unpacklo_epi32(rows[i], rows[i + 1]);
+        const auto high01 = _mm256_unpackhi_epi32(rows[i], rows[i + 1]);
+        const auto low23 = _mm256_unpacklo_epi32(rows[i + 2], rows[i + 3]);
+        const auto high23 = _mm256_unpackhi_epi32(rows[i + 2], rows[i + 3]);
+        pairs[i] = _mm256_unpacklo_epi64(low01, low23);
+        pairs[i + 1] = _mm256_unpackhi_epi64(low01, low23);
+        pairs[i + 2] = _mm256_unpacklo_epi64(high01, high23);
+        pairs[i + 3] = _mm256_unpackhi_epi64(high01, high23);
+    }
+
+    const auto byte_swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (std::size_t i = 0; i < 4; ++i) {
+        words[i] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(pairs[i], pairs[i + 4], 0x20), byte_swap);
+        words[i + 4] = _mm256_shuffle_epi8(_mm256_permute2x128_si256(pairs[i], pairs[i + 4], 0x31), byte_swap);
+    }
+}
+
+
+// every lane of 32-bit words hashes its own message, the lanes go over blocks together, so messages of a call
+// should have close numbers of blocks; a lane, whose message has ended, hashes a zero block and its digest is
+// taken right after its last block
+__attribute__((target("avx2"))) void computeLanesAvx2(const base::BytesView* messages,
+                                                      std::size_t messages_count,
+                                                      base::Byte* const* digests)
+{
+    alignas(32) static constexpr base::Byte ZERO_BLOCK[SHA256_BLOCK_SIZE] = {};
+    Sha256Tail tails[AVX2_LANES_COUNT];
+    std::size_t full_blocks_counts[AVX2_LANES_COUNT] = {};
+    std::size_t blocks_counts[AVX2_LANES_COUNT] = {};
+    std::size_t max_blocks_count = 0;
+    for (std::size_t lane = 0; lane < messages_count; ++lane) {
+        const auto& message = messages[lane];
+        full_blocks_counts[lane] = message.size() / SHA256_BLOCK_SIZE;
+        const auto full_size = full_blocks_counts[lane] * SHA256_BLOCK_SIZE;
+        makeTail(
+          base::BytesView(message.getData() + full_size, message.size() - full_size), message.size(), tails[lane]);
+        blocks_counts[lane] = full_blocks_counts[lane] + tails[lane].blocks_count;
+        max_blocks_count = std::max(max_blocks_count, blocks_counts[lane]);
+    }
+
+    __m256i state[8];
+    for (std::size_t i = 0; i < 8; ++i) {
+        state[i] = _mm256_set1_epi32(static_cast<int>(SHA256_INITIAL_STATE[i]));
+    }
+
+    for (std::size_t block_index = 0; block_index < max_blocks_count; ++block_index) {
+        const base::Byte* blocks[AVX2_LANES_COUNT];
+        for (std::size_t lane = 0; lane < AVX2_LANES_COUNT; ++lane) {
+            if (block_index < full_blocks_counts[lane]) {
+                blocks[lane] = messages[lane].getData() + block_index * SHA256_BLOCK_SIZE;
+            }
+            else if (block_index < blocks_counts[lane]) {
+                blocks[lane] = tails[lane].blocks + (block_index - full_blocks_counts[lane]) * SHA256_BLOCK_SIZE;
+            }
+            else {
+                blocks[lane] = ZERO_BLOCK;
+            }
+        }
+
+        __m256i w[16];
+        loadWordsAvx2(blocks, 0, w);
+        loadWordsAvx2(blocks, 32, w + 8);
+
+        auto a = state[0], b = state[1], c = state[2], d = state[3];
+        auto e = state[4], f = state[5], g = state[6], h = state[7];
+        for (std::size_t t = 0; t < 64; ++t) {
+            if (t >= 16) {
+                const auto w15 = w[(t - 15) % 16];
+                const auto w2 = w[(t - 2) % 16];
+                const auto s0 = _mm256_xor_si256(_mm256_xor_si256(rotateRight<7>(w15), rotateRight<18>(w15)),
+                                                 _mm256_srli_epi32(w15, 3));
+                const auto s1 = _mm256_xor_si256(_mm256_xor_si256(rotateRight<17>(w2), rotateRight<19>(w2)),
+                                                 _mm256_srli_epi32(w2, 10));
+                w[t % 16] = _mm256_add_epi32(_mm256_add_epi32(w[t % 16], s0),
+                                             _mm256_add_epi32(w[(t - 7) % 16], s1));
+            }
+            const auto s1 =
+              _mm256_xor_si256(_mm256_xor_si256(rotateRight<6>(e), rotateRight<11>(e)), rotateRight<25>(e));
+            const auto choice = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            const auto t1 = _mm256_add_epi32(
+              _mm256_add_epi32(_mm256_add_epi32(h, s1), choice),
+              _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(SHA256_ROUND_CONSTANTS[t])), w[t % 16]));
+            const auto s0 =
+              _mm256_xor_si256(_mm256_xor_si256(rotateRight<2>(a), rotateRight<13>(a)), rotateRight<22>(a));
+            const auto majority = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+            h = g;
+            g = f;
+            f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c;
+            c = b;
+            b = a;
+            a = _mm256_add_epi32(t1, _mm256_add_epi32(s0, majority));
+        }
+        state[0] = _mm256_add_epi32(state[0], a);
+        state[1] = _mm256_add_epi32(state[1], b);
+        state[2] = _mm256_add_epi32(state[2], c);
+        state[3] = _mm256_add_epi32(state[3], d);
+        state[4] = _mm256_add_epi32(state[4], e);
+        state[5] = _mm256_add_epi32(state[5], f);
+        state[6] = _mm256_add_epi32(state[6], g);
+        state[7] = _mm256_add_epi32(state[7], h);
+
+        for (std::size_t lane = 0; lane < messages_count; ++lane) {
+            if (blocks_counts[lane] == block_index + 1) {
+                alignas(32) std::uint32_t words[8][AVX2_LANES_COUNT];
+                for (std::size_t i = 0; i < 8; ++i) {
+                    _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+                }
+                for (std::size_t i = 0; i < 8; ++i) {
+                    storeBigEndian32(words[i][lane], digests[lane] + i * 4);
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+
+Sha256Compress getSha256Compress() noexcept
+{
+#ifdef CONFIG_ARCH_X86
+    if (base::cpu::hasSha()) {
+        return compressSha;
+    }
+#endif
+    return compressOpenSsl;
+}
+
+} // namespace
+
 
 namespace base
 {
@@ -81,11 +385,57 @@ bool Sha256::operator<(const Sha256& another) const
 }
 
 
-Sha256 Sha256::compute(const base::Bytes& data)
+Sha256 Sha256::compute(base::BytesView data)
 {
-    base::FixedBytes<SHA256_SIZE> ret;
-    SHA256(data.getData(), data.size(), ret.getData());
-    return Sha256(ret);
+    Sha256Hasher hasher;
+    hasher.update(data);
+    return hasher.finalize();
+}
+
+
+std::vector<Sha256> Sha256::computeMany(std::span<const base::BytesView> data)
+{
+#ifdef CONFIG_ARCH_X86
+    // a core with SHA extensions hashes a message faster than 8 AVX2 lanes hash 8 of them
+    if (!cpu::hasSha() && cpu::hasAvx2()) {
+        // messages of close sizes go to the same lanes, so lanes rarely idle
+        std::vector<std::size_t> order(data.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&data](std::size_t a, std::size_t b) {
+            return data[a].size() < data[b].size();
+        });
+
+        std::vector<FixedBytes<SHA256_SIZE>> digests(data.size());
+        std::size_t done_count = 0;
+        for (; done_count + AVX2_LANES_COUNT / 2 <= order.size(); done_count += AVX2_LANES_COUNT) {
+            const auto lanes_count = std::min(AVX2_LANES_COUNT, order.size() - done_count);
+            BytesView messages[AVX2_LANES_COUNT];
+            Byte* lanes_digests[AVX2_LANES_COUNT];
+            for (std::size_t lane = 0; lane < lanes_count; ++lane) {
+                messages[lane] = data[order[done_count + lane]];
+                lanes_digests[lane] = digests[order[done_count + lane]].getData();
+            }
+            computeLanesAvx2(messages, lanes_count, lanes_digests);
+        }
+        // too few messages are left to fill the lanes
+        for (; done_count < order.size(); ++done_count) {
+            digests[order[done_count]] = compute(data[order[done_count]]).getBytes();
+        }
+
+        std::vector<Sha256> ret;
+        ret.reserve(digests.size());
+        for (auto& digest : digests) {
+            ret.emplace_back(std::move(digest));
+        }
+        return ret;
+    }
+#endif
+    std::vector<Sha256> ret;
+    ret.reserve(data.size());
+    for (const auto& message : data) {
+        ret.push_back(compute(message));
+    }
+    return ret;
 }
 
 
@@ -106,6 +456,67 @@ std::ostream& operator<<(std::ostream& os, const Sha256& sha)
     return os << toHex<FixedBytes<Sha256::SHA256_SIZE>>(sha.getBytes());
 }
 
+
+Sha256Hasher::Sha256Hasher() noexcept
+{
+    std::copy(std::begin(SHA256_INITIAL_STATE), std::end(SHA256_INITIAL_STATE), _state);
+}
+
+
+void Sha256Hasher::update(BytesView data)
+{
+    update(data.getData(), data.size());
+}
+
+
+void Sha256Hasher::update(const Byte* data, std::size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+    _total_size += size;
+    const auto compress = getSha256Compress();
+
+    if (_buffered_size > 0) {
+        const auto taken_size = std::min(size, Sha256::SHA256_BLOCK_SIZE - _buffered_size);
+        std::memcpy(_buffer + _buffered_size, data, taken_size);
+        _buffered_size += taken_size;
+        data += taken_size;
+        size -= taken_size;
+        if (_buffered_size < Sha256::SHA256_BLOCK_SIZE) {
+            return;
+        }
+        compress(_state, _buffer, 1);
+        _buffered_size = 0;
+    }
+
+    const auto blocks_count = size / Sha256::SHA256_BLOCK_SIZE;
+    if (blocks_count > 0) {
+        compress(_state, data, blocks_count);
+        data += blocks_count * Sha256::SHA256_BLOCK_SIZE;
+        size -= blocks_count * Sha256::SHA256_BLOCK_SIZE;
+    }
+    if (size > 0) {
+        std::memcpy(_buffer, data, size);
+        _buffered_size = size;
+    }
+}
+
+
+Sha256 Sha256Hasher::finalize()
+{
+    Sha256Tail tail;
+    makeTail(BytesView(_buffer, _buffered_size), _total_size, tail);
+    getSha256Compress()(_state, tail.blocks, tail.blocks_count);
+
+    FixedBytes<Sha256::SHA256_SIZE> digest;
+    for (std::size_t i = 0; i < 8; ++i) {
+        storeBigEndian32(_state[i], digest.getData() + i * 4);
+    }
+    *this = Sha256Hasher{};
+    return Sha256(std::move(digest));
+}
+
 } // namespace base
 
 
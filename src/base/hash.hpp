@@ -2,8 +2,11 @@
 
 #include "base/serialization.hpp"
 
+#include <cstdint>
 #include <functional>
 #include <iosfwd>
+#include <span>
+#include <vector>
 
 namespace base
 {
@@ -12,6 +15,7 @@ class Sha256
 {
   public:
     static constexpr std::size_t SHA256_SIZE = 32;
+    static constexpr std::size_t SHA256_BLOCK_SIZE = 64;
     //----------------------------------
     Sha256(const Sha256&) = default;
     Sha256(Sha256&&) = default;
@@ -33,10 +37,18 @@ class Sha256
     bool operator!=(const Sha256& another) const;
     bool operator<(const Sha256& another) const;
     //----------------------------------
-    static Sha256 compute(const base::Bytes& data);
+    static Sha256 compute(base::BytesView data);
 
     template<std::size_t S>
     static Sha256 compute(const base::FixedBytes<S>& data);
+
+    // hash of the value serialized with fixed encoding, the value is serialized straight into a hasher
+    template<typename T>
+    static Sha256 computeSerialized(const T& value);
+
+    // digests go in the order of data, messages are hashed several at once by SIMD lanes, if the CPU has no SHA
+    // extensions, so batches of similar sizes are cheaper than separate compute calls
+    static std::vector<Sha256> computeMany(std::span<const base::BytesView> data);
     //----------------------------------
     void serialize(SerializationOArchive& oa) const;
     static Sha256 deserialize(SerializationIArchive& ia);
@@ -47,6 +59,26 @@ class Sha256
 
 std::ostream& operator<<(std::ostream& os, const Sha256& sha);
 
+
+// computes Sha256 of data, that is given by parts, so the data is never gathered into one buffer; see also
+// SerializationOArchive, that serializes values straight into a hasher
+class Sha256Hasher
+{
+  public:
+    Sha256Hasher() noexcept;
+    //----------------------------------
+    void update(BytesView data);
+    void update(const Byte* data, std::size_t size);
+    // the hasher starts over after it, so it can be reused for the next data
+    Sha256 finalize();
+    //----------------------------------
+  private:
+    std::uint32_t _state[8];
+    Byte _buffer[Sha256::SHA256_BLOCK_SIZE];
+    std::size_t _buffered_size{ 0 };
+    std::uint64_t _total_size{ 0 };
+};
+
 } // namespace base
 
 namespace std
@@ -1,15 +1,24 @@
 #include "hash.hpp"
 
 #include <openssl/ripemd.h>
+#include <openssl/sha.h>
 
 namespace base
 {
 template<std::size_t S>
 Sha256 Sha256::compute(const FixedBytes<S>& data)
 {
-    base::FixedBytes<SHA256_SIZE> ret;
-    SHA256(data.getData(), S, ret.getData());
-    return Sha256(ret);
+    return compute(BytesView(data));
+}
+
+
+template<typename T>
+Sha256 Sha256::computeSerialized(const T& value)
+{
+    Sha256Hasher hasher;
+    SerializationOArchive oa{ hasher };
+    oa.serialize(value);
+    return hasher.finalize();
 }
 
 
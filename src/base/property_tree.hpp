@@ -22,6 +22,10 @@ class PropertyTree
     template<typename R>
     R get(const std::string& path) const;
 
+    // a given value is returned, if there is no such key
+    template<typename R>
+    R get(const std::string& path, const R& default_value) const;
+
     template<typename R>
     std::vector<R> getVector(const std::string& path) const;
 
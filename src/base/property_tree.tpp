@@ -19,6 +19,15 @@ R PropertyTree::get(const std::string& path) const
     }
 }
 
+template<typename R>
+R PropertyTree::get(const std::string& path, const R& default_value) const
+{
+    if (hasKey(path)) {
+        return get<R>(path);
+    }
+    return default_value;
+}
+
 template<typename R>
 std::vector<R> PropertyTree::getVector(const std::string& path) const
 {
@@ -1,17 +1,59 @@
 #include "serialization.hpp"
 
+#include "base/assert.hpp"
+#include "base/error.hpp"
+#include "base/hash.hpp"
+
 #include <utility>
 
 namespace base
 {
 
 
+SerializationOArchive::SerializationOArchive(Mode mode, IntegerEncoding encoding)
+  : _mode{ mode }
+  , _encoding{ encoding }
+{
+    if (_mode == Mode::HASH) {
+        RAISE_ERROR(InvalidArgument, "Hashing archive needs a hasher");
+    }
+}
+
+
+SerializationOArchive::SerializationOArchive(Sha256Hasher& hasher, IntegerEncoding encoding)
+  : _mode{ Mode::HASH }
+  , _encoding{ encoding }
+  , _hasher{ &hasher }
+{}
+
+
 void SerializationOArchive::clear()
 {
+    _counted_size = 0;
     _bytes.clear();
 }
 
 
+void SerializationOArchive::reserve(std::size_t size)
+{
+    if (_mode == Mode::WRITE) {
+        _bytes.reserve(size);
+    }
+}
+
+
+std::size_t SerializationOArchive::size() const noexcept
+{
+    return _mode == Mode::WRITE ? _bytes.size() : _counted_size;
+}
+
+
+IntegerEncoding SerializationOArchive::getEncoding() const noexcept
+{
+    return _encoding;
+}
+
+
 const base::Bytes& SerializationOArchive::getBytes() const& noexcept
 {
     return _bytes;
@@ -24,10 +66,70 @@ base::Bytes&& SerializationOArchive::getBytes() && noexcept
 }
 
 
-SerializationIArchive::SerializationIArchive(const base::Bytes& raw)
+void SerializationOArchive::writeToHasher(const Byte* data, std::size_t size)
+{
+    _hasher->update(data, size);
+}
+
+
+SerializationIArchive::SerializationIArchive(BytesView raw, IntegerEncoding encoding)
   : _bytes{ raw }
   , _index{ 0 }
+  , _encoding{ encoding }
+{}
+
+
+SerializationIArchive::SerializationIArchive(const SharedBytes& raw, IntegerEncoding encoding)
+  : _owner{ raw }
+  , _bytes{ _owner }
+  , _index{ 0 }
+  , _encoding{ encoding }
 {}
 
 
+BytesView SerializationIArchive::readView(std::size_t size)
+{
+    if (size > _bytes.size() - _index) {
+        RAISE_ERROR(base::InvalidArgument, "not enough bytes to deserialize");
+    }
+    auto view = _bytes.takePart(_index, _index + size);
+    _index += size;
+    return view;
+}
+
+
+std::size_t SerializationIArchive::getRemainingSize() const noexcept
+{
+    return _bytes.size() - _index;
+}
+
+
+std::size_t SerializationIArchive::getPosition() const noexcept
+{
+    return _index;
+}
+
+
+std::optional<SharedBytes> SerializationIArchive::takeSharedPart(std::size_t begin_position) const
+{
+    ASSERT(begin_position <= _index);
+    if (_owner.isEmpty()) {
+        return std::nullopt;
+    }
+    return _owner.takePart(begin_position, _index);
+}
+
+
+IntegerEncoding SerializationIArchive::getEncoding() const noexcept
+{
+    return _encoding;
+}
+
+
+void SerializationIArchive::setEncoding(IntegerEncoding encoding) noexcept
+{
+    _encoding = encoding;
+}
+
+
 } // namespace base
\ No newline at end of file
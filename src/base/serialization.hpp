@@ -12,12 +12,27 @@
 namespace base
 {
 
+class Sha256Hasher;
+
+// values are versions of encoding, so a node can state the newest one it understands
+enum class IntegerEncoding : std::uint8_t
+{
+    // integers are stored as big-endian bytes of their full size
+    FIXED = 0,
+    // 64-bit unsigned integers, that are all lengths, counters, depths and balances, are stored as LEB128
+    // varints, other integers are stored as in FIXED
+    COMPACT = 1
+};
+
+
 class SerializationIArchive
 {
   public:
     //=================
     // it doesn't copy, so the client must be sure that passed bytes are not removed while this class is used
-    SerializationIArchive(const Bytes& raw);
+    SerializationIArchive(BytesView raw, IntegerEncoding encoding = IntegerEncoding::FIXED);
+    // keeps a reference to the bytes, so parts of them can be kept by deserialized objects, see takeSharedPart
+    SerializationIArchive(const SharedBytes& raw, IntegerEncoding encoding = IntegerEncoding::FIXED);
 
     // TODO: work if some of this types is not defined
     //=================
@@ -27,10 +42,23 @@ class SerializationIArchive
     template<typename U, typename V>
     std::pair<U, V> deserialize();
 
+    // returns next bytes without copying, so the view is valid as long as deserialized bytes are
+    BytesView readView(std::size_t size);
+
+    std::size_t getRemainingSize() const noexcept;
+    // number of bytes read so far
+    std::size_t getPosition() const noexcept;
+    // returns bytes read since a given position without copying them, if the archive was created from SharedBytes
+    std::optional<SharedBytes> takeSharedPart(std::size_t begin_position) const;
+    //=================
+    IntegerEncoding getEncoding() const noexcept;
+    void setEncoding(IntegerEncoding encoding) noexcept;
     //=================
   private:
-    const base::Bytes& _bytes;
+    SharedBytes _owner;
+    BytesView _bytes;
     std::size_t _index;
+    IntegerEncoding _encoding;
 };
 
 
@@ -38,32 +66,62 @@ class SerializationOArchive
 {
   public:
     //=================
-    SerializationOArchive() = default;
+    enum class Mode
+    {
+        WRITE,
+        // nothing is written, only size of serialized values is computed, so the same serialize methods
+        // give an exact size to reserve before the real pass
+        COUNT,
+        // serialized bytes go to a hasher instead of the buffer, so a value is hashed without building its encoding
+        HASH
+    };
+    //=================
+    explicit SerializationOArchive(Mode mode = Mode::WRITE, IntegerEncoding encoding = IntegerEncoding::FIXED);
+    // HASH mode, the hasher must outlive the archive
+    explicit SerializationOArchive(Sha256Hasher& hasher, IntegerEncoding encoding = IntegerEncoding::FIXED);
     // TODO: work if some of this types is not defined
     //=================
     void clear();
+    void reserve(std::size_t size);
     //=================
     template<typename T>
     void serialize(const T& v);
 
     template<typename U, typename V>
     void serialize(const std::pair<U, V>& p);
+
+    // all serialized values end up here as raw bytes
+    void write(const Byte* data, std::size_t size);
     //=================
+    // number of serialized bytes in all modes
+    std::size_t size() const noexcept;
+    IntegerEncoding getEncoding() const noexcept;
     const base::Bytes& getBytes() const& noexcept;
     base::Bytes&& getBytes() && noexcept;
     //=================
 
   private:
+    Mode _mode;
+    IntegerEncoding _encoding;
+    std::size_t _counted_size{ 0 };
     base::Bytes _bytes;
+    Sha256Hasher* _hasher{ nullptr };
+    //=================
+    void writeToHasher(const Byte* data, std::size_t size);
 };
 
 
 template<typename T>
-base::Bytes toBytes(const T& value);
+std::size_t calcSerializedSize(const T& value, IntegerEncoding encoding = IntegerEncoding::FIXED);
+
+
+// serialized bytes are allocated once, the size is computed by a dry pass of serialization
+template<typename T>
+base::Bytes toBytes(const T& value, IntegerEncoding encoding = IntegerEncoding::FIXED);
 
 
 template<typename T>
-T fromBytes(const base::Bytes& bytes);
+T fromBytes(BytesView bytes, IntegerEncoding encoding = IntegerEncoding::FIXED);
 
 
 template<typename T>
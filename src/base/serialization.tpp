@@ -3,10 +3,14 @@
 #include "serialization.hpp"
 
 #include "base/assert.hpp"
+#include "base/error.hpp"
 
 #include <boost/asio.hpp>
 #include <boost/endian/conversion.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <functional>
 
 
@@ -51,6 +55,71 @@ void chooseSerializationMethod(base::SerializationOArchive& oa, T&& t)
 }
 
 
+// vectors of such types are serialized by whole memory blocks instead of element by element: their serialized
+// form is their memory, with a byte order swap for integrals wider than a byte
+template<typename T>
+struct is_bulk_serializable
+  : std::integral_constant<bool, std::is_integral<T>::value && !std::is_same<T, bool>::value>
+{};
+
+
+template<std::size_t S>
+struct is_bulk_serializable<base::FixedBytes<S>>
+  : std::integral_constant<bool,
+                           std::is_trivially_copyable<base::FixedBytes<S>>::value && sizeof(base::FixedBytes<S>) == S>
+{};
+
+
+// such integers are written as varints in IntegerEncoding::COMPACT
+template<typename T>
+struct is_compactable
+  : std::integral_constant<bool, std::is_integral<T>::value && std::is_unsigned<T>::value && sizeof(T) == 8>
+{};
+
+
+// bulk serialization is used unless elements are varints in the given encoding
+template<typename T>
+bool isBulkSerialized(base::IntegerEncoding encoding) noexcept
+{
+    return is_bulk_serializable<T>::value &&
+           !(is_compactable<T>::value && encoding == base::IntegerEncoding::COMPACT);
+}
+
+
+// LEB128: 7 bits in a byte starting from the least significant ones, the high bit is set in all bytes but the last
+inline void writeVarint(base::SerializationOArchive& oa, std::uint64_t value)
+{
+    base::Byte buffer[10];
+    std::size_t size = 0;
+    while (value >= 0x80) {
+        buffer[size++] = static_cast<base::Byte>(value | 0x80);
+        value >>= 7;
+    }
+    buffer[size++] = static_cast<base::Byte>(value);
+    oa.write(buffer, size);
+}
+
+
+// only the shortest form is accepted, so every value has a single encoding
+inline std::uint64_t readVarint(base::SerializationIArchive& ia)
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = 0;; ++i) {
+        auto byte = ia.readView(1)[0];
+        if (i == 9 && byte > 1) {
+            RAISE_ERROR(base::InvalidArgument, "varint doesn't fit into 64 bits");
+        }
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80)) {
+            if (byte == 0 && i != 0) {
+                RAISE_ERROR(base::InvalidArgument, "varint is not in the shortest form");
+            }
+            return value;
+        }
+    }
+}
+
+
 template<typename, typename T>
 struct has_deserialize
 {
@@ -80,20 +149,19 @@ template<typename T>
 class global_deserialize
 {
   public:
-    T deserialize(base::SerializationIArchive& ia, const base::Bytes& _bytes, std::size_t& _index)
+    T deserialize(base::SerializationIArchive& ia)
     {
         if constexpr (std::is_integral<T>::value) {
+            if constexpr (is_compactable<T>::value) {
+                if (ia.getEncoding() == base::IntegerEncoding::COMPACT) {
+                    return readVarint(ia);
+                }
+            }
             T v;
             static_assert(sizeof(v) == 1 || sizeof(v) == 2 || sizeof(v) == 4 || sizeof(v) == 8,
                           "this integral type is not serializable");
 
-            if (_index + sizeof(T) > _bytes.size()) {
-                _index += 120;
-            }
-            ASSERT(_index + sizeof(T) <= _bytes.size());
-
-            v = *reinterpret_cast<const T*>(_bytes.getData() + _index);
-            _index += sizeof(v);
+            std::memcpy(&v, ia.readView(sizeof(v)).getData(), sizeof(v));
             if constexpr (sizeof(v) != 1) {
                 v = base::nativeToBig(v);
             }
@@ -114,10 +182,33 @@ template<typename T>
 class global_deserialize<std::vector<T>>
 {
   public:
-    std::vector<T> deserialize(base::SerializationIArchive& ia, const base::Bytes&, std::size_t&)
+    std::vector<T> deserialize(base::SerializationIArchive& ia)
     {
-        std::vector<T> v;
         std::size_t size = ia.deserialize<std::size_t>();
+        const bool is_bulk = isBulkSerialized<T>(ia.getEncoding());
+        // every element takes at least a byte, so a size is checked before memory is reserved for it
+        if (size > ia.getRemainingSize() / (is_bulk ? sizeof(T) : 1)) {
+            RAISE_ERROR(base::InvalidArgument, "not enough bytes to deserialize");
+        }
+
+        if constexpr (is_bulk_serializable<T>::value) {
+            if (is_bulk) {
+                std::vector<T> v(size);
+                // data of an empty vector can be null, and memcpy takes no null pointers even for no bytes
+                if (size != 0) {
+                    std::memcpy(v.data(), ia.readView(size * sizeof(T)).getData(), size * sizeof(T));
+                    if constexpr (std::is_integral<T>::value && sizeof(T) != 1) {
+                        for (auto& x : v) {
+                            x = base::nativeToBig(x);
+                        }
+                    }
+                }
+                return v;
+            }
+        }
+
+        std::vector<T> v;
+        v.reserve(size);
         for (std::size_t i = 0; i < size; i++) {
             v.push_back(ia.deserialize<T>());
         }
@@ -130,7 +221,7 @@ template<typename T>
 class global_deserialize<std::optional<T>>
 {
   public:
-    std::optional<T> deserialize(base::SerializationIArchive& ia, const base::Bytes&, std::size_t&)
+    std::optional<T> deserialize(base::SerializationIArchive& ia)
     {
         auto do_we_have_a_value = ia.deserialize<bool>();
         std::optional<T> v;
@@ -152,31 +243,33 @@ template<std::size_t S>
 class global_deserialize<base::FixedBytes<S>>
 {
   public:
-    base::FixedBytes<S> deserialize(base::SerializationIArchive& ia, const base::Bytes&, std::size_t&)
+    base::FixedBytes<S> deserialize(base::SerializationIArchive& ia)
     {
-        base::FixedBytes<S> fb;
-        for (std::size_t i = 0; i < S; ++i) {
-            auto b = ia.deserialize<base::Byte>();
-            fb[i] = b;
-        }
-        return fb;
+        return base::FixedBytes<S>(ia.readView(S).getData(), S);
     }
 };
 
 
+// has the same format as base::Bytes, but points into deserialized bytes instead of copying them
 template<>
-class global_deserialize<base::Bytes>
+class global_deserialize<base::BytesView>
 {
   public:
-    base::Bytes deserialize(base::SerializationIArchive& ia, const base::Bytes&, std::size_t&)
+    base::BytesView deserialize(base::SerializationIArchive& ia)
     {
         auto size = ia.deserialize<std::size_t>();
-        base::Bytes bytes(size);
-        for (std::size_t i = 0; i < size; ++i) {
-            auto b = ia.deserialize<base::Byte>();
-            bytes[i] = b;
-        }
-        return bytes;
+        return ia.readView(size);
+    }
+};
+
+
+template<>
+class global_deserialize<base::Bytes>
+{
+  public:
+    base::Bytes deserialize(base::SerializationIArchive& ia)
+    {
+        return ia.deserialize<base::BytesView>().toBytes();
     }
 };
 
@@ -185,11 +278,10 @@ template<>
 class global_deserialize<std::string>
 {
   public:
-    std::string deserialize(base::SerializationIArchive& ia, const base::Bytes&, std::size_t&)
+    std::string deserialize(base::SerializationIArchive& ia)
     {
-        base::Bytes bytes = ia.deserialize<base::Bytes>();
-        std::string str = bytes.toString();
-        return str;
+        auto view = ia.deserialize<base::BytesView>();
+        return std::string(reinterpret_cast<const char*>(view.getData()), view.size());
     }
 };
 
@@ -223,19 +315,23 @@ template<typename T>
 class global_serialize
 {
   public:
-    void serialize(base::SerializationOArchive& oa, const T& v, base::Bytes& _bytes)
+    void serialize(base::SerializationOArchive& oa, const T& v)
     {
         if constexpr (std::is_integral<T>::value) {
             static_assert(sizeof(v) == 1 || sizeof(v) == 2 || sizeof(v) == 4 || sizeof(v) == 8,
                           "this integral type is not serializable");
 
-            if constexpr (sizeof(v) != 1) {
-                auto t = base::bigToNative(v);
-                _bytes.append(reinterpret_cast<base::Byte*>(&t), sizeof(v));
+            if constexpr (is_compactable<T>::value) {
+                if (oa.getEncoding() == base::IntegerEncoding::COMPACT) {
+                    writeVarint(oa, v);
+                    return;
+                }
             }
-            else {
-                _bytes.append(static_cast<base::Byte>(v));
+            auto t = v;
+            if constexpr (sizeof(v) != 1) {
+                t = base::bigToNative(v);
             }
+            oa.write(reinterpret_cast<const base::Byte*>(&t), sizeof(t));
         }
         else if constexpr (std::is_enum<T>::value) {
             oa.serialize(static_cast<typename std::underlying_type<T>::type>(v));
@@ -251,9 +347,29 @@ template<typename T>
 class global_serialize<std::vector<T>>
 {
   public:
-    void serialize(base::SerializationOArchive& oa, const std::vector<T>& v, base::Bytes&)
+    void serialize(base::SerializationOArchive& oa, const std::vector<T>& v)
     {
         oa.serialize(v.size());
+        if constexpr (is_bulk_serializable<T>::value) {
+            if (isBulkSerialized<T>(oa.getEncoding())) {
+                if constexpr (!std::is_integral<T>::value || sizeof(T) == 1) {
+                    oa.write(reinterpret_cast<const base::Byte*>(v.data()), v.size() * sizeof(T));
+                }
+                else {
+                    // swapped by blocks on the stack, the loop is simple enough for a compiler to vectorize it
+                    std::array<T, 256 / sizeof(T)> block;
+                    for (std::size_t i = 0; i < v.size(); i += block.size()) {
+                        auto count = std::min(block.size(), v.size() - i);
+                        for (std::size_t j = 0; j < count; ++j) {
+                            block[j] = base::nativeToBig(v[i + j]);
+                        }
+                        oa.write(reinterpret_cast<const base::Byte*>(block.data()), count * sizeof(T));
+                    }
+                }
+                return;
+            }
+        }
+
         for (const auto& x : v) {
             oa.serialize(x);
         }
@@ -265,7 +381,7 @@ template<typename T>
 class global_serialize<std::optional<T>>
 {
   public:
-    void serialize(base::SerializationOArchive& oa, const std::optional<T>& v, base::Bytes&)
+    void serialize(base::SerializationOArchive& oa, const std::optional<T>& v)
     {
         if (v) {
             oa.serialize(true);
@@ -282,25 +398,32 @@ template<std::size_t S>
 class global_serialize<base::FixedBytes<S>>
 {
   public:
-    void serialize(base::SerializationOArchive& oa, const base::FixedBytes<S>& fb, base::Bytes&)
+    void serialize(base::SerializationOArchive& oa, const base::FixedBytes<S>& fb)
     {
-        for (std::size_t i = 0; i < S; i++) {
-            oa.serialize(fb[i]);
-        }
+        oa.write(fb.getData(), S);
     }
 };
 
 
 template<>
-class global_serialize<base::Bytes>
+class global_serialize<base::BytesView>
 {
   public:
-    void serialize(base::SerializationOArchive& oa, const base::Bytes& bytes, base::Bytes&)
+    void serialize(base::SerializationOArchive& oa, const base::BytesView& bytes)
     {
         oa.serialize(bytes.size());
-        for (auto b : bytes.toVector()) {
-            oa.serialize(b);
-        }
+        oa.write(bytes.getData(), bytes.size());
+    }
+};
+
+
+template<>
+class global_serialize<base::Bytes>
+{
+  public:
+    void serialize(base::SerializationOArchive& oa, const base::Bytes& bytes)
+    {
+        oa.serialize(base::BytesView(bytes));
     }
 };
 
@@ -309,7 +432,7 @@ template<>
 class global_serialize<std::string>
 {
   public:
-    void serialize(base::SerializationOArchive& oa, const std::string& str, base::Bytes&)
+    void serialize(base::SerializationOArchive& oa, const std::string& str)
     {
         oa.serialize(base::Bytes(str));
     }
@@ -329,7 +452,7 @@ T SerializationIArchive::deserialize()
         return T::deserialize(*this);
     }
     else {
-        return impl::global_deserialize<T>{}.deserialize(*this, _bytes, _index);
+        return impl::global_deserialize<T>{}.deserialize(*this);
     }
 }
 
@@ -350,7 +473,7 @@ void SerializationOArchive::serialize(const T& v)
         v.serialize(*this);
     }
     else {
-        impl::global_serialize<T>{}.serialize(*this, v, _bytes);
+        impl::global_serialize<T>{}.serialize(*this, v);
     }
 }
 
@@ -363,19 +486,42 @@ void SerializationOArchive::serialize(const std::pair<U, V>& p)
 }
 
 
+inline void SerializationOArchive::write(const Byte* data, std::size_t size)
+{
+    if (_mode == Mode::WRITE) {
+        _bytes.append(data, size);
+        return;
+    }
+    _counted_size += size;
+    if (_mode == Mode::HASH) {
+        writeToHasher(data, size);
+    }
+}
+
+
+template<typename T>
+std::size_t calcSerializedSize(const T& value, IntegerEncoding encoding)
+{
+    SerializationOArchive counter{ SerializationOArchive::Mode::COUNT, encoding };
+    counter.serialize(value);
+    return counter.size();
+}
+
+
 template<typename T>
-base::Bytes toBytes(const T& value)
+base::Bytes toBytes(const T& value, IntegerEncoding encoding)
 {
-    SerializationOArchive oa;
+    SerializationOArchive oa{ SerializationOArchive::Mode::WRITE, encoding };
+    oa.reserve(calcSerializedSize(value, encoding));
     oa.serialize(value);
     return std::move(std::move(oa).getBytes());
 }
 
 
 template<typename T>
-T fromBytes(const base::Bytes& bytes)
+T fromBytes(BytesView bytes, IntegerEncoding encoding)
 {
-    SerializationIArchive ia(bytes);
+    SerializationIArchive ia(bytes, encoding);
     T t = ia.deserialize<T>();
     return t;
 }
@@ -3,7 +3,13 @@
 #include <boost/preprocessor.hpp>
 #include <boost/type_index.hpp>
 
+#include <atomic>
 #include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
 
 namespace base
 {
@@ -48,6 +54,70 @@ class Observable
     std::size_t _next_id = 0;
 };
 
+/**
+ *  @brief Key-value container of bounded size, that evicts the least recently used element on overflow.
+ *
+ *  @note Lookup updates order of elements, so the class is not threadsafe even for reading.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>>
+class LruCache
+{
+  public:
+    //===================
+    explicit LruCache(std::size_t capacity);
+    //===================
+    std::optional<std::reference_wrapper<V>> find(const K& key);
+    void put(K key, V value);
+    bool erase(const K& key);
+    void clear();
+    //===================
+    std::size_t size() const noexcept;
+    std::size_t capacity() const noexcept;
+    //===================
+  private:
+    //===================
+    using ItemsList = std::list<std::pair<K, V>>;
+    //===================
+    std::size_t _capacity;
+    ItemsList _items; // the most recently used item is the first one
+    std::unordered_map<K, typename ItemsList::iterator, Hash> _index;
+    //===================
+};
+
+/**
+ *  @brief Value, that is computed on the first request and kept until reset. It is copied together with the
+ *         owning object.
+ *
+ *  @note Computation is threadsafe, so const objects can be shared between threads. Reset is not, it goes
+ *        with a change of the owning object.
+ */
+template<typename T>
+class Memoized
+{
+  public:
+    //===================
+    Memoized() = default;
+    Memoized(const Memoized& other);
+    // a moved object isn't shared with other threads, so moves take no locks and keep owners nothrow-movable
+    Memoized(Memoized&& other) noexcept;
+    Memoized& operator=(const Memoized& other);
+    Memoized& operator=(Memoized&& other) noexcept;
+    ~Memoized() = default;
+    //===================
+    template<typename F>
+    const T& get(F&& compute) const;
+    // returns nullptr if the value was not computed yet
+    const T* tryGet() const noexcept;
+    void reset() noexcept;
+    //===================
+  private:
+    //===================
+    mutable std::mutex _mutex;
+    mutable std::atomic<bool> _is_computed{ false };
+    mutable std::optional<T> _value;
+    //===================
+};
+
 #define TYPE_NAME(t) boost::typeindex::type_id<t>().pretty_name()
 
 } // namespace base
@@ -39,4 +39,151 @@ void Observable<Args...>::notify(Args... args)
     }
 }
 
-} // namespace base
\ No newline at end of file
+
+template<typename K, typename V, typename Hash>
+LruCache<K, V, Hash>::LruCache(std::size_t capacity)
+  : _capacity{ capacity }
+{}
+
+
+template<typename K, typename V, typename Hash>
+std::optional<std::reference_wrapper<V>> LruCache<K, V, Hash>::find(const K& key)
+{
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return std::nullopt;
+    }
+    _items.splice(_items.begin(), _items, it->second);
+    return it->second->second;
+}
+
+
+template<typename K, typename V, typename Hash>
+void LruCache<K, V, Hash>::put(K key, V value)
+{
+    if (_capacity == 0) {
+        return;
+    }
+
+    if (auto it = _index.find(key); it != _index.end()) {
+        it->second->second = std::move(value);
+        _items.splice(_items.begin(), _items, it->second);
+        return;
+    }
+
+    if (_items.size() == _capacity) {
+        _index.erase(_items.back().first);
+        _items.pop_back();
+    }
+    _items.emplace_front(std::move(key), std::move(value));
+    _index.insert({ _items.front().first, _items.begin() });
+}
+
+
+template<typename K, typename V, typename Hash>
+bool LruCache<K, V, Hash>::erase(const K& key)
+{
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return false;
+    }
+    _items.erase(it->second);
+    _index.erase(it);
+    return true;
+}
+
+
+template<typename K, typename V, typename Hash>
+void LruCache<K, V, Hash>::clear()
+{
+    _index.clear();
+    _items.clear();
+}
+
+
+template<typename K, typename V, typename Hash>
+std::size_t LruCache<K, V, Hash>::size() const noexcept
+{
+    return _items.size();
+}
+
+
+template<typename K, typename V, typename Hash>
+std::size_t LruCache<K, V, Hash>::capacity() const noexcept
+{
+    return _capacity;
+}
+
+template<typename T>
+Memoized<T>::Memoized(const Memoized& other)
+{
+    std::lock_guard lk(other._mutex);
+    _value = other._value;
+    _is_computed = _value.has_value();
+}
+
+
+template<typename T>
+Memoized<T>::Memoized(Memoized&& other) noexcept
+  : _is_computed{ other._is_computed.load(std::memory_order_relaxed) }
+  , _value{ std::move(other._value) }
+{
+    static_assert(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>);
+    other.reset();
+}
+
+
+template<typename T>
+Memoized<T>& Memoized<T>::operator=(const Memoized& other)
+{
+    if (this != &other) {
+        std::scoped_lock lk(_mutex, other._mutex);
+        _value = other._value;
+        _is_computed = _value.has_value();
+    }
+    return *this;
+}
+
+
+template<typename T>
+Memoized<T>& Memoized<T>::operator=(Memoized&& other) noexcept
+{
+    if (this != &other) {
+        _value = std::move(other._value);
+        _is_computed.store(_value.has_value(), std::memory_order_relaxed);
+        other.reset();
+    }
+    return *this;
+}
+
+
+template<typename T>
+template<typename F>
+const T& Memoized<T>::get(F&& compute) const
+{
+    if (!_is_computed.load(std::memory_order_acquire)) {
+        std::lock_guard lk(_mutex);
+        if (!_value) {
+            _value.emplace(std::forward<F>(compute)());
+            _is_computed.store(true, std::memory_order_release);
+        }
+    }
+    return *_value;
+}
+
+
+template<typename T>
+const T* Memoized<T>::tryGet() const noexcept
+{
+    return _is_computed.load(std::memory_order_acquire) ? &*_value : nullptr;
+}
+
+
+template<typename T>
+void Memoized<T>::reset() noexcept
+{
+    _value.reset();
+    _is_computed = false;
+}
+
+} // namespace base
@@ -22,6 +22,12 @@ Block::Block(bc::BlockDepth depth,
 
 void Block::serialize(base::SerializationOArchive& oa) const
 {
+    // the kept serialized form is the canonical one, that is hashed
+    const auto* serialized = _serialized.tryGet();
+    if (serialized && oa.getEncoding() == base::IntegerEncoding::FIXED) {
+        oa.write(serialized->getData(), serialized->size());
+        return;
+    }
     oa.serialize(_depth);
     oa.serialize(_nonce);
     oa.serialize(_prev_block_hash);
@@ -33,6 +39,7 @@ void Block::serialize(base::SerializationOArchive& oa) const
 
 Block Block::deserialize(base::SerializationIArchive& ia)
 {
+    auto begin_position = ia.getPosition();
     auto depth = ia.deserialize<BlockDepth>();
     auto nonce = ia.deserialize<NonceInt>();
     auto prev_block_hash = ia.deserialize<base::Sha256>();
@@ -41,6 +48,11 @@ Block Block::deserialize(base::SerializationIArchive& ia)
     auto txs = ia.deserialize<TransactionsSet>();
     Block ret{ depth, std::move(prev_block_hash), std::move(timestamp), std::move(coinbase), std::move(txs) };
     ret.setNonce(nonce);
+    // fixed encoding is canonical, so received bytes are the same as serialized ones
+    if (auto serialized = ia.takeSharedPart(begin_position);
+        serialized && ia.getEncoding() == base::IntegerEncoding::FIXED) {
+        ret._serialized.get([&serialized] { return std::move(*serialized); });
+    }
     return ret;
 }
 
@@ -69,15 +81,42 @@ NonceInt Block::getNonce() const noexcept
 }
 
 
+const base::SharedBytes& Block::getSerialized() const
+{
+    return _serialized.get([this] { return base::SharedBytes(base::toBytes(*this)); });
+}
+
+
+const base::Sha256& Block::getHash() const
+{
+    return _hash.get([this] {
+        if (const auto* serialized = _serialized.tryGet()) {
+            return base::Sha256::compute(*serialized);
+        }
+        // the miner hashes the block for every nonce, so encodings of candidates are never built
+        return base::Sha256::computeSerialized(*this);
+    });
+}
+
+
+void Block::resetSerialized() noexcept
+{
+    _serialized.reset();
+    _hash.reset();
+}
+
+
 void Block::setDepth(BlockDepth depth) noexcept
 {
     _depth = depth;
+    resetSerialized();
 }
 
 
 void Block::setNonce(NonceInt nonce) noexcept
 {
     _nonce = nonce;
+    resetSerialized();
 }
 
 
@@ -96,18 +135,21 @@ const bc::Address& Block::getCoinbase() const noexcept
 void Block::setPrevBlockHash(const base::Sha256& prev_block_hash)
 {
     _prev_block_hash = prev_block_hash;
+    resetSerialized();
 }
 
 
 void Block::setTransactions(TransactionsSet txs)
 {
     _txs = std::move(txs);
+    resetSerialized();
 }
 
 
 void Block::addTransaction(const Transaction& tx)
 {
     _txs.add(tx);
+    resetSerialized();
 }
 
 
@@ -127,7 +169,7 @@ bool operator!=(const bc::Block& a, const bc::Block& b)
 
 std::ostream& operator<<(std::ostream& os, const Block& block)
 {
-    return os << base::Sha256::compute(base::toBytes(block));
+    return os << block.getHash();
 }
 
 } // namespace bc
@@ -3,6 +3,7 @@
 #include "base/bytes.hpp"
 #include "base/hash.hpp"
 #include "base/serialization.hpp"
+#include "base/utility.hpp"
 #include "bc/transaction.hpp"
 #include "bc/transactions_set.hpp"
 #include "bc/types.hpp"
@@ -40,6 +41,11 @@ class Block
     const base::Time& getTimestamp() const noexcept;
     const bc::Address& getCoinbase() const noexcept;
     //=================
+    // canonical serialized form, that is hashed; it's computed once and reused by serialization, a block
+    // deserialized from SharedBytes keeps the received bytes instead
+    const base::SharedBytes& getSerialized() const;
+    const base::Sha256& getHash() const;
+    //=================
     void setDepth(BlockDepth depth) noexcept;
     void setNonce(NonceInt nonce) noexcept;
     void setPrevBlockHash(const base::Sha256& prev_block_hash);
@@ -49,12 +55,18 @@ class Block
   private:
     //=================
     bc::BlockDepth _depth;
-    NonceInt _nonce;
+    NonceInt _nonce{ 0 };
     base::Sha256 _prev_block_hash;
     base::Time _timestamp;
     bc::Address _coinbase;
     TransactionsSet _txs;
     //=================
+    // both are reset by every setter
+    base::Memoized<base::SharedBytes> _serialized;
+    base::Memoized<base::Sha256> _hash;
+    //=================
+    void resetSerialized() noexcept;
+    //=================
 };
 
 std::ostream& operator<<(std::ostream& os, const Block& block);
@@ -0,0 +1,223 @@
+#include "block_files.hpp"
+
+#include "base/config.hpp"
+#include "base/error.hpp"
+#include "base/log.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+
+#if defined(CONFIG_OS_FAMILY_WINDOWS)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+
+constexpr const char* FILE_NAME_PREFIX = "blocks_";
+constexpr const char* FILE_NAME_EXTENSION = ".dat";
+
+
+std::optional<std::uint32_t> parseFileIndex(const std::filesystem::path& path)
+{
+    auto name = path.stem().string();
+    if (path.extension() != FILE_NAME_EXTENSION || name.rfind(FILE_NAME_PREFIX, 0) != 0) {
+        return std::nullopt;
+    }
+    try {
+        return static_cast<std::uint32_t>(std::stoul(name.substr(std::char_traits<char>::length(FILE_NAME_PREFIX))));
+    }
+    catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+} // namespace
+
+namespace bc
+{
+
+void BlockFiles::Location::serialize(base::SerializationOArchive& oa) const
+{
+    oa.serialize(file_index);
+    oa.serialize(offset);
+    oa.serialize(length);
+}
+
+
+BlockFiles::Location BlockFiles::Location::deserialize(base::SerializationIArchive& ia)
+{
+    Location location;
+    location.file_index = ia.deserialize<std::uint32_t>();
+    location.offset = ia.deserialize<std::uint64_t>();
+    location.length = ia.deserialize<std::uint64_t>();
+    return location;
+}
+
+
+BlockFiles::View::View(std::shared_ptr<const boost::interprocess::mapped_region> region,
+                       const base::Byte* data,
+                       std::size_t size)
+  : _region{ std::move(region) }
+  , _data{ data }
+  , _size{ size }
+{}
+
+
+const base::Byte* BlockFiles::View::getData() const noexcept
+{
+    return _data;
+}
+
+
+std::size_t BlockFiles::View::size() const noexcept
+{
+    return _size;
+}
+
+
+base::Bytes BlockFiles::View::toBytes() const
+{
+    return base::Bytes(_data, _size);
+}
+
+
+base::BytesView BlockFiles::View::toBytesView() const noexcept
+{
+    return base::BytesView(_data, _size);
+}
+
+
+BlockFiles::BlockFiles(base::Directory directory, std::size_t max_file_size)
+  : _directory{ std::move(directory) }
+  , _max_file_size{ max_file_size }
+{
+    base::createIfNotExists(_directory);
+    for (const auto& entry : std::filesystem::directory_iterator(_directory)) {
+        if (auto file_index = parseFileIndex(entry.path()); file_index && *file_index > _last_file_index) {
+            _last_file_index = *file_index;
+        }
+    }
+    openLastFile();
+}
+
+
+BlockFiles::~BlockFiles()
+{
+    if (_last_file) {
+        std::fclose(_last_file);
+    }
+}
+
+
+BlockFiles::Location BlockFiles::append(base::BytesView record)
+{
+    std::lock_guard lk(_write_mutex);
+    if (!_last_file) {
+        openLastFile();
+    }
+    if (_last_file_size != 0 && _last_file_size + record.size() > _max_file_size) {
+        syncLastFile();
+        std::fclose(_last_file);
+        _last_file = nullptr;
+        ++_last_file_index;
+        openLastFile();
+    }
+
+    if (std::fwrite(record.getData(), 1, record.size(), _last_file) != record.size()) {
+        // a part of the record may be written, so the file is cut back to the size, that next records start at
+        std::fclose(_last_file);
+        _last_file = nullptr;
+        auto path = getFilePath(_last_file_index);
+        std::error_code ec;
+        std::filesystem::resize_file(path, _last_file_size, ec);
+        openLastFile();
+        RAISE_ERROR(base::InaccessibleFile, "failed to write to " + path.string());
+    }
+    Location location{ _last_file_index, _last_file_size, record.size() };
+    _last_file_size += record.size();
+    return location;
+}
+
+
+void BlockFiles::sync()
+{
+    std::lock_guard lk(_write_mutex);
+    syncLastFile();
+}
+
+
+std::optional<BlockFiles::View> BlockFiles::read(const Location& location) const
+{
+    auto end = location.offset + location.length;
+    std::lock_guard lk(_regions_mutex);
+    auto it = _regions.find(location.file_index);
+    if (it == _regions.end() || it->second->get_size() < end) {
+        auto path = getFilePath(location.file_index);
+        std::error_code ec;
+        if (auto file_size = std::filesystem::file_size(path, ec); ec || file_size < end || file_size == 0) {
+            return std::nullopt;
+        }
+        boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+        auto region =
+          std::make_shared<const boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+        it = _regions.insert_or_assign(location.file_index, std::move(region)).first;
+    }
+    const auto& region = it->second;
+    return View(region, static_cast<const base::Byte*>(region->get_address()) + location.offset, location.length);
+}
+
+
+void BlockFiles::removeFilesBefore(std::uint32_t file_index)
+{
+    std::lock_guard write_lk(_write_mutex);
+    std::lock_guard regions_lk(_regions_mutex);
+    _regions.erase(_regions.begin(), _regions.lower_bound(file_index));
+    for (const auto& entry : std::filesystem::directory_iterator(_directory)) {
+        if (auto index = parseFileIndex(entry.path()); index && *index < file_index && *index < _last_file_index) {
+            LOG_DEBUG << "Removing block file " << entry.path();
+            std::filesystem::remove(entry.path());
+        }
+    }
+}
+
+
+std::filesystem::path BlockFiles::getFilePath(std::uint32_t file_index) const
+{
+    std::ostringstream name;
+    name << FILE_NAME_PREFIX << std::setw(6) << std::setfill('0') << file_index << FILE_NAME_EXTENSION;
+    return _directory / name.str();
+}
+
+
+void BlockFiles::openLastFile()
+{
+    // records of a write, that was interrupted before sync, may be left at the end, they are never referenced
+    auto path = getFilePath(_last_file_index);
+    _last_file = std::fopen(path.string().c_str(), "ab");
+    if (!_last_file) {
+        RAISE_ERROR(base::InaccessibleFile, "failed to open " + path.string());
+    }
+    _last_file_size = std::filesystem::file_size(path);
+}
+
+
+void BlockFiles::syncLastFile()
+{
+    // appended data goes from the stream buffer to the system and then to the disk
+    bool is_synced = std::fflush(_last_file) == 0;
+#if defined(CONFIG_OS_FAMILY_WINDOWS)
+    is_synced = is_synced && _commit(_fileno(_last_file)) == 0;
+#else
+    is_synced = is_synced && fsync(fileno(_last_file)) == 0;
+#endif
+    if (!is_synced) {
+        RAISE_ERROR(base::SystemCallFailed, "failed to sync " + getFilePath(_last_file_index).string());
+    }
+}
+
+} // namespace bc
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "base/bytes.hpp"
+#include "base/directory.hpp"
+#include "base/serialization.hpp"
+
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace bc
+{
+
+/**
+ *  @brief Append-only storage of serialized blocks in segmented flat files, that are read through memory mapping.
+ *
+ *  Records are addressed by locations, which are kept by a caller. An appended record becomes durable
+ *  only after sync, so a location must not be published before that.
+ */
+class BlockFiles
+{
+  public:
+    //===================
+    struct Location
+    {
+        std::uint32_t file_index;
+        std::uint64_t offset;
+        std::uint64_t length;
+
+        void serialize(base::SerializationOArchive& oa) const;
+        static Location deserialize(base::SerializationIArchive& ia);
+    };
+    //===================
+    // read-only view of a record, that keeps its file mapped while the view is alive
+    class View
+    {
+      public:
+        const base::Byte* getData() const noexcept;
+        std::size_t size() const noexcept;
+        base::Bytes toBytes() const;
+        // the returned view is valid while this view is alive
+        base::BytesView toBytesView() const noexcept;
+
+      private:
+        friend class BlockFiles;
+
+        View(std::shared_ptr<const boost::interprocess::mapped_region> region,
+             const base::Byte* data,
+             std::size_t size);
+
+        std::shared_ptr<const boost::interprocess::mapped_region> _region;
+        const base::Byte* _data;
+        std::size_t _size;
+    };
+    //===================
+    BlockFiles(base::Directory directory, std::size_t max_file_size);
+    BlockFiles(const BlockFiles&) = delete;
+    BlockFiles(BlockFiles&&) = delete;
+    BlockFiles& operator=(const BlockFiles&) = delete;
+    BlockFiles& operator=(BlockFiles&&) = delete;
+    ~BlockFiles();
+    //===================
+    Location append(base::BytesView record);
+    // makes all appended records durable
+    void sync();
+    // returns std::nullopt if the location points out of the stored data
+    std::optional<View> read(const Location& location) const;
+    //===================
+    // files before a given one are removed, views of their records stay valid
+    void removeFilesBefore(std::uint32_t file_index);
+    //===================
+  private:
+    //===================
+    const base::Directory _directory;
+    const std::size_t _max_file_size;
+    //===================
+    std::uint32_t _last_file_index{ 0 };
+    std::uint64_t _last_file_size{ 0 };
+    std::FILE* _last_file{ nullptr };
+    std::mutex _write_mutex;
+    //===================
+    // a mapping covers a file as it was at mapping time, so it is remapped if a file grew since then
+    mutable std::map<std::uint32_t, std::shared_ptr<const boost::interprocess::mapped_region>> _regions;
+    mutable std::mutex _regions_mutex;
+    //===================
+    std::filesystem::path getFilePath(std::uint32_t file_index) const;
+    void openLastFile();
+    void syncLastFile();
+    //===================
+};
+
+} // namespace bc
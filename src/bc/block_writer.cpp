@@ -0,0 +1,177 @@
+#include "block_writer.hpp"
+
+#include "base/log.hpp"
+
+#include <algorithm>
+#include <exception>
+
+namespace bc
+{
+
+BlockWriter::BlockWriter(WriteHandler handler,
+                         CommitMode mode,
+                         std::chrono::milliseconds max_delay,
+                         std::size_t max_group_size,
+                         WrittenHandler written_handler)
+  : _handler{ std::move(handler) }
+  , _written_handler{ std::move(written_handler) }
+  , _mode{ mode }
+  , _max_delay{ max_delay }
+  , _max_group_size{ std::max<std::size_t>(max_group_size, 1) }
+{
+    std::promise<void> nothing_to_write;
+    nothing_to_write.set_value();
+    _last_group_written = nothing_to_write.get_future().share();
+
+    _worker_thread = std::thread(&BlockWriter::worker, this);
+}
+
+
+BlockWriter::~BlockWriter()
+{
+    {
+        std::lock_guard lk(_mutex);
+        _is_stopping = true;
+    }
+    _state_changed_cv.notify_all();
+    if (_worker_thread.joinable()) {
+        _worker_thread.join();
+    }
+}
+
+
+std::shared_future<void> BlockWriter::enqueue(const base::Sha256& block_hash, std::shared_ptr<const Block> block)
+{
+    std::shared_future<void> written;
+    {
+        std::lock_guard lk(_mutex);
+        // nothing is written after a failed write, so the chain on disk has no gaps
+        if (_failure) {
+            _pending_blocks.insert({ block_hash, std::move(block) });
+            return _last_group_written;
+        }
+        // groups in the queue are not taken by the worker yet, so the last one can be extended
+        if (_mode == CommitMode::STRICT || _groups.empty() || _groups.back().blocks.size() >= _max_group_size) {
+            auto& group = _groups.emplace_back();
+            auto delay = _mode == CommitMode::GROUP ? _max_delay : std::chrono::milliseconds::zero();
+            group.deadline = std::chrono::steady_clock::now() + delay;
+            _last_group_written = group.written.get_future().share();
+        }
+        _groups.back().blocks.emplace_back(block_hash, block);
+        _pending_blocks.insert({ block_hash, std::move(block) });
+        written = _last_group_written;
+    }
+    _state_changed_cv.notify_one();
+    return written;
+}
+
+
+std::shared_future<void> BlockWriter::flush()
+{
+    std::shared_future<void> written;
+    {
+        std::lock_guard lk(_mutex);
+        if (!_groups.empty()) {
+            _groups.back().deadline = std::chrono::steady_clock::now();
+        }
+        written = _last_group_written;
+    }
+    _state_changed_cv.notify_one();
+    return written;
+}
+
+
+std::shared_future<void> BlockWriter::getWritten() const
+{
+    std::lock_guard lk(_mutex);
+    return _last_group_written;
+}
+
+
+std::shared_ptr<const Block> BlockWriter::findPending(const base::Sha256& block_hash) const
+{
+    std::lock_guard lk(_mutex);
+    if (auto it = _pending_blocks.find(block_hash); it != _pending_blocks.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+
+void BlockWriter::checkFailure() const
+{
+    std::lock_guard lk(_mutex);
+    if (_failure) {
+        std::rethrow_exception(_failure);
+    }
+}
+
+
+BlockWriter::CommitMode BlockWriter::getCommitMode() const noexcept
+{
+    return _mode;
+}
+
+
+void BlockWriter::worker()
+{
+    std::unique_lock lk(_mutex);
+    while (true) {
+        _state_changed_cv.wait(lk, [this] { return _is_stopping || !_groups.empty(); });
+        if (_groups.empty()) {
+            break;
+        }
+
+        // the only group is still open for new blocks until its deadline
+        const auto& front = _groups.front();
+        if (!_is_stopping && _groups.size() == 1 && front.blocks.size() < _max_group_size &&
+            std::chrono::steady_clock::now() < front.deadline) {
+            _state_changed_cv.wait_until(lk, front.deadline);
+            continue;
+        }
+
+        auto group = std::move(_groups.front());
+        _groups.pop_front();
+        lk.unlock();
+
+        std::exception_ptr error;
+        try {
+            _handler(group.blocks);
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR << "Failed to write " << group.blocks.size() << " blocks: " << e.what();
+            error = std::current_exception();
+        }
+
+        lk.lock();
+        if (error) {
+            // blocks of the failed group and of the queued ones stay pending, so they can still be found
+            _failure = error;
+            group.written.set_exception(error);
+            for (auto& queued_group : _groups) {
+                queued_group.written.set_exception(error);
+            }
+            _groups.clear();
+            continue;
+        }
+        // blocks leave pending ones before waiters are notified, so a written block is found only in storage
+        for (const auto& [block_hash, block] : group.blocks) {
+            _pending_blocks.erase(block_hash);
+        }
+        group.written.set_value();
+
+        if (_written_handler) {
+            // waiters of the group may hold locks, that the handler takes, so they are released first
+            lk.unlock();
+            try {
+                _written_handler(group.blocks);
+            }
+            catch (const std::exception& e) {
+                LOG_ERROR << "Failed to handle " << group.blocks.size() << " written blocks: " << e.what();
+            }
+            lk.lock();
+        }
+    }
+}
+
+} // namespace bc
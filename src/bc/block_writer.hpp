@@ -0,0 +1,104 @@
+#pragma once
+
+#include "base/hash.hpp"
+
+#include "bc/block.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bc
+{
+
+/**
+ *  @brief Background stage, that writes accepted blocks to persistent storage.
+ *
+ *  Blocks are grouped and every group is passed to the write handler at once, so a single synced write
+ *  covers several blocks. Until a block is written it can be found by findPending.
+ *
+ *  If the handler fails, nothing is written after that: blocks of the failed group and of later ones stay
+ *  pending, their futures and futures of later enqueues and flushes hold the error, see checkFailure.
+ */
+class BlockWriter
+{
+  public:
+    //===================
+    enum class CommitMode
+    {
+        STRICT, // every block is written by a separate write
+        GROUP   // blocks, that come within a max delay, are written together
+    };
+    //===================
+    // blocks are shared with the chain in memory, so they are not copied on the way to disk
+    using Blocks = std::vector<std::pair<base::Sha256, std::shared_ptr<const Block>>>;
+    using WriteHandler = std::function<void(const Blocks&)>;
+    // called by the writer thread after a group is written and its waiters are notified, so it must be short
+    using WrittenHandler = std::function<void(const Blocks&)>;
+    //===================
+    BlockWriter(WriteHandler handler,
+                CommitMode mode,
+                std::chrono::milliseconds max_delay,
+                std::size_t max_group_size,
+                WrittenHandler written_handler = {});
+    BlockWriter(const BlockWriter&) = delete;
+    BlockWriter(BlockWriter&&) = delete;
+    BlockWriter& operator=(const BlockWriter&) = delete;
+    BlockWriter& operator=(BlockWriter&&) = delete;
+    // writes all pending blocks before return
+    ~BlockWriter();
+    //===================
+    // returned future gets ready after the block is written, or holds an exception if writing failed
+    std::shared_future<void> enqueue(const base::Sha256& block_hash, std::shared_ptr<const Block> block);
+    // returned future gets ready after all blocks enqueued by now are written
+    std::shared_future<void> flush();
+    // the same as flush, but blocks are written when their group is due
+    std::shared_future<void> getWritten() const;
+    //===================
+    // returns nullptr if the block is not pending
+    std::shared_ptr<const Block> findPending(const base::Sha256& block_hash) const;
+    // throws an error of the handler, if a write has failed
+    void checkFailure() const;
+    //===================
+    CommitMode getCommitMode() const noexcept;
+    //===================
+  private:
+    //===================
+    struct Group
+    {
+        Blocks blocks;
+        std::promise<void> written;
+        std::chrono::steady_clock::time_point deadline;
+    };
+    //===================
+    const WriteHandler _handler;
+    const WrittenHandler _written_handler;
+    const CommitMode _mode;
+    const std::chrono::milliseconds _max_delay;
+    const std::size_t _max_group_size;
+    //===================
+    mutable std::mutex _mutex;
+    std::condition_variable _state_changed_cv;
+    std::deque<Group> _groups;
+    std::unordered_map<base::Sha256, std::shared_ptr<const Block>> _pending_blocks;
+    std::shared_future<void> _last_group_written;
+    std::exception_ptr _failure;
+    bool _is_stopping{ false };
+    //===================
+    std::thread _worker_thread;
+    //===================
+    void worker();
+    //===================
+};
+
+} // namespace bc
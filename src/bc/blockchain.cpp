@@ -1,7 +1,9 @@
 #include "blockchain.hpp"
 
 #include "base/assert.hpp"
+#include "base/config.hpp"
 #include "base/log.hpp"
+#include "bc/database_keys.hpp"
 #include "net/host.hpp"
 
 #include <optional>
@@ -9,32 +11,99 @@
 namespace
 {
 
-enum class DataType
+const base::Bytes LAST_BLOCK_HASH_KEY{ bc::toDatabaseKey(bc::DataType::SYSTEM, base::Bytes("last_block_hash")) };
+
+const base::Bytes PRUNED_DEPTH_KEY{ bc::toDatabaseKey(bc::DataType::SYSTEM, base::Bytes("pruned_depth")) };
+
+const base::Bytes BLOCK_ENCODING_KEY{ bc::toDatabaseKey(bc::DataType::SYSTEM, base::Bytes("block_encoding")) };
+
+const base::Bytes BLOCK_STORAGE_KEY{ bc::toDatabaseKey(bc::DataType::SYSTEM, base::Bytes("block_storage")) };
+
+const base::Bytes BLOCK_LOCATION_PREFIX{ bc::toDatabaseKey(bc::DataType::BLOCK_LOCATION, base::Bytes{}) };
+
+const base::Bytes BLOCK_HASH_BY_DEPTH_PREFIX{ bc::toDatabaseKey(bc::DataType::BLOCK_HASH_BY_DEPTH, base::Bytes{}) };
+
+// depth is serialized as big-endian, so lexicographical order of keys matches order of blocks in chain
+base::Bytes toDepthKey(bc::BlockDepth depth)
+{
+    return bc::toDatabaseKey(bc::DataType::BLOCK_HASH_BY_DEPTH, base::toBytes(depth));
+}
+
+
+bc::Block toHeader(const bc::Block& block)
+{
+    bc::Block header{
+        block.getDepth(), block.getPrevBlockHash(), block.getTimestamp(), block.getCoinbase(), bc::TransactionsSet{}
+    };
+    header.setNonce(block.getNonce());
+    return header;
+}
+
+
+base::Bytes toBlockLocationKey(const base::Sha256& block_hash)
+{
+    return bc::toDatabaseKey(bc::DataType::BLOCK_LOCATION, block_hash.getBytes());
+}
+
+
+base::Bytes toTransactionLocationKey(const base::Sha256& tx_hash)
 {
-    SYSTEM = 1,
-    BLOCK = 2,
-    PREVIOUS_BLOCK_HASH = 3
-};
+    return bc::toDatabaseKey(bc::DataType::TRANSACTION_LOCATION, tx_hash.getBytes());
+}
+
 
-base::Bytes toBytes(DataType type, const base::Bytes& key)
+bc::BlockWriter::CommitMode calcCommitMode(const base::PropertyTree& config)
 {
-    base::Bytes data;
-    data.append(static_cast<base::Byte>(type));
-    data.append(key);
-    return data;
+    if (!config.hasKey("database.commit_mode")) {
+        return bc::BlockWriter::CommitMode::GROUP;
+    }
+    auto mode = config.get<std::string>("database.commit_mode");
+    if (mode == "strict") {
+        return bc::BlockWriter::CommitMode::STRICT;
+    }
+    else if (mode == "group") {
+        return bc::BlockWriter::CommitMode::GROUP;
+    }
+    else {
+        RAISE_ERROR(base::InvalidArgument, std::string{ "unknown database.commit_mode: " } + mode);
+    }
 }
 
 
-template<std::size_t S>
-base::Bytes toBytes(DataType type, const base::FixedBytes<S>& key)
+bool calcIsBlockFilesMode(const base::PropertyTree& config)
 {
-    base::Bytes data;
-    data.append(static_cast<base::Byte>(type));
-    data.append(key.getData(), S);
-    return data;
+    if (!config.hasKey("blockchain.block_storage")) {
+        return false;
+    }
+    auto storage = config.get<std::string>("blockchain.block_storage");
+    if (storage == "files") {
+        return true;
+    }
+    else if (storage == "database") {
+        return false;
+    }
+    else {
+        RAISE_ERROR(base::InvalidArgument, std::string{ "unknown blockchain.block_storage: " } + storage);
+    }
 }
 
-const base::Bytes LAST_BLOCK_HASH_KEY{ toBytes(DataType::SYSTEM, base::Bytes("last_block_hash")) };
+
+base::IntegerEncoding calcBlockEncoding(const base::PropertyTree& config)
+{
+    if (!config.hasKey("blockchain.block_encoding")) {
+        return base::IntegerEncoding::FIXED;
+    }
+    auto encoding = config.get<std::string>("blockchain.block_encoding");
+    if (encoding == "fixed") {
+        return base::IntegerEncoding::FIXED;
+    }
+    else if (encoding == "compact") {
+        return base::IntegerEncoding::COMPACT;
+    }
+    else {
+        RAISE_ERROR(base::InvalidArgument, std::string{ "unknown blockchain.block_encoding: " } + encoding);
+    }
+}
 
 } // namespace
 
@@ -44,7 +113,19 @@ namespace bc
 
 Blockchain::Blockchain(const base::PropertyTree& config)
   : _config{ config }
+  , _top_blocks_cache_size{ std::max<std::size_t>(
+      config.get<std::size_t>("blockchain.top_blocks_cache_size", base::config::BC_TOP_BLOCKS_CACHE_SIZE), 1) }
+  , _prune_depth{ config.get<std::size_t>("blockchain.prune_depth", base::config::BC_PRUNE_DEPTH) }
   , _top_level_block_hash(base::Bytes(32))
+  , _recent_blocks{ config.get<std::size_t>("blockchain.recent_blocks_cache_size",
+                                            base::config::BC_RECENT_BLOCKS_CACHE_SIZE) }
+  , _block_writer{ [this](const BlockWriter::Blocks& blocks) { pushForwardToPersistentStorage(blocks); },
+                   calcCommitMode(config),
+                   std::chrono::milliseconds{ config.get<std::size_t>("database.group_commit_max_delay",
+                                                                      base::config::DATABASE_GROUP_COMMIT_MAX_DELAY) },
+                   config.get<std::size_t>("database.group_commit_max_blocks",
+                                           base::config::DATABASE_GROUP_COMMIT_MAX_BLOCKS),
+                   [this](const BlockWriter::Blocks& blocks) { notifyBlocksWritten(blocks); } }
 {
     auto database_path = config.get<std::string>("database.path");
     if (config.get<bool>("database.clean")) {
@@ -55,78 +136,269 @@ Blockchain::Blockchain(const base::PropertyTree& config)
         _database = base::createDefaultDatabaseInstance(base::Directory(database_path));
         LOG_INFO << "Loaded database by path: " << database_path;
     }
+
+    // locations of blocks are useless without block files, so the storage is chosen once for a database
+    bool is_block_files_mode = calcIsBlockFilesMode(config);
+    if (auto storage_data = _database.get(BLOCK_STORAGE_KEY); storage_data) {
+        is_block_files_mode = base::fromBytes<bool>(*storage_data);
+    }
+    else {
+        // a database, that was created before the storage was kept, uses files if any block is in them
+        if (_database.createIterator(BLOCK_LOCATION_PREFIX).isValid()) {
+            is_block_files_mode = true;
+        }
+        base::Database::WriteBatch batch;
+        batch.put(BLOCK_STORAGE_KEY, base::toBytes(is_block_files_mode));
+        _database.write(batch);
+    }
+    if (is_block_files_mode != calcIsBlockFilesMode(config)) {
+        LOG_WARNING << "blockchain.block_storage is ignored, blocks are kept in the storage of the database";
+    }
+    if (is_block_files_mode) {
+        _block_files = std::make_unique<BlockFiles>(
+          base::Directory(std::filesystem::path(database_path) / "blocks"),
+          config.get<std::size_t>("blockchain.block_file_max_size", base::config::BC_BLOCK_FILE_MAX_SIZE));
+        LOG_INFO << "Blocks are kept in files";
+    }
+
+    if (auto encoding_data = _database.get(BLOCK_ENCODING_KEY); encoding_data) {
+        _block_encoding = base::fromBytes<base::IntegerEncoding>(*encoding_data);
+    }
+    else if (!_database.exists(LAST_BLOCK_HASH_KEY)) {
+        _block_encoding = calcBlockEncoding(config);
+        base::Database::WriteBatch batch;
+        batch.put(BLOCK_ENCODING_KEY, base::toBytes(_block_encoding));
+        _database.write(batch);
+    }
+    // otherwise blocks were written before the encoding became selectable, so they have the fixed one
+    if (_block_encoding != calcBlockEncoding(config)) {
+        LOG_WARNING << "blockchain.block_encoding is ignored, blocks are kept in the encoding of the database";
+    }
+
+    if (_prune_depth != 0) {
+        _pruning_thread = std::thread(&Blockchain::pruner, this);
+    }
+}
+
+
+Blockchain::~Blockchain()
+{
+    {
+        std::lock_guard lk(_pruning_mutex);
+        _is_pruning_stopping = true;
+    }
+    _pruning_cv.notify_all();
+    if (_pruning_thread.joinable()) {
+        _pruning_thread.join();
+    }
 }
 
 
 void Blockchain::load()
 {
-    for (const auto& block_hash : createAllBlockHashesListAtPersistentStorage()) {
+    auto all_blocks_hashes = createAllBlockHashesListAtPersistentStorage();
+    if (all_blocks_hashes.empty()) {
+        // database was created before blocks got indexed by depth
+        all_blocks_hashes = createAllBlockHashesListByPreviousHashesAtPersistentStorage();
+        if (!all_blocks_hashes.empty()) {
+            LOG_INFO << "Building index of blocks by depth";
+            base::Database::WriteBatch batch;
+            for (bc::BlockDepth depth = 0; depth < all_blocks_hashes.size(); ++depth) {
+                batch.put(toDepthKey(depth), all_blocks_hashes[depth].getBytes());
+            }
+            std::lock_guard lk(_database_rw_mutex);
+            _database.write(batch);
+        }
+    }
+    if (all_blocks_hashes.empty()) {
+        return;
+    }
+
+    // only top blocks are read, deeper ones are read on demand and their transactions are found by the index on disk
+    bc::BlockDepth top_begin_depth =
+      all_blocks_hashes.size() > _top_blocks_cache_size ? all_blocks_hashes.size() - _top_blocks_cache_size : 0;
+    std::vector<std::shared_ptr<const Block>> top_blocks;
+    for (auto depth = top_begin_depth; depth < all_blocks_hashes.size(); ++depth) {
+        const auto& block_hash = all_blocks_hashes[depth];
         LOG_DEBUG << "Loading block " << block_hash << " from database";
         auto current_block = findBlockAtPersistentStorage(block_hash);
+        if (!current_block) {
+            current_block = findBlockHeaderAtPersistentStorage(block_hash);
+        }
         ASSERT(current_block);
-        tryAddBlock(current_block.value());
+        top_blocks.push_back(std::make_shared<const Block>(std::move(current_block.value())));
+    }
+
+    {
+        std::lock_guard lk(_blocks_mutex);
+        // blocks, that were added before loading, e.g. the genesis, must be the first ones of the chain on disk
+        for (const auto& [depth, block_hash] : _blocks_by_depth) {
+            if (depth < all_blocks_hashes.size() && all_blocks_hashes[depth] != block_hash) {
+                RAISE_ERROR(base::LogicError, "database keeps another chain");
+            }
+            // such blocks are on disk, so they leave memory, if they are under the top
+            if (auto it = _blocks.find(block_hash); it != _blocks.end() && depth < top_begin_depth) {
+                removeTransactionsLocations(it->first, *it->second);
+                _blocks.erase(it);
+            }
+        }
+        for (bc::BlockDepth depth = 0; depth < all_blocks_hashes.size(); ++depth) {
+            _blocks_by_depth.insert({ depth, all_blocks_hashes[depth] });
+        }
+        if (!_last_written_depth || *_last_written_depth < all_blocks_hashes.size() - 1) {
+            _last_written_depth = all_blocks_hashes.size() - 1;
+        }
+        for (const auto& block : top_blocks) {
+            const auto& block_hash = all_blocks_hashes[block->getDepth()];
+            if (_blocks.insert({ block_hash, block }).second) {
+                addTransactionsLocations(block_hash, *block);
+            }
+        }
+        if (_blocks_by_depth.rbegin()->first + 1 == all_blocks_hashes.size()) {
+            _top_level_block_hash = all_blocks_hashes.back();
+        }
+    }
+
+    for (const auto& block : top_blocks) {
+        _block_added.notify(*block);
     }
 }
 
 
 void Blockchain::addGenesisBlock(const Block& block)
 {
-    auto hash = base::Sha256::compute(base::toBytes(block));
+    auto shared_block = std::make_shared<const Block>(block);
+    auto hash = block.getHash();
 
-    std::lock_guard lk(_blocks_mutex);
-    if (!_blocks.empty()) {
-        RAISE_ERROR(base::LogicError, "cannot add genesis to non-empty chain");
-    }
+    {
+        std::lock_guard lk(_blocks_mutex);
+        if (!_blocks_by_depth.empty()) {
+            RAISE_ERROR(base::LogicError, "cannot add genesis to non-empty chain");
+        }
 
-    auto inserted_block = _blocks.insert({ hash, block }).first;
-    pushForwardToPersistentStorage(hash, block);
-    _top_level_block_hash = hash;
+        _blocks.insert({ hash, shared_block });
+        _blocks_by_depth.insert({ block.getDepth(), hash });
+        addTransactionsLocations(hash, block);
+        _block_writer.enqueue(hash, std::move(shared_block));
+        _top_level_block_hash = hash;
+    }
 
     LOG_DEBUG << "Adding genesis block. Block hash = " << hash;
-    _block_added.notify(inserted_block->second);
+    _block_added.notify(block);
 }
 
 
 bool Blockchain::tryAddBlock(const Block& block)
 {
-    auto hash = base::Sha256::compute(base::toBytes(block));
+    return tryAddBlock(std::make_shared<const Block>(block));
+}
 
-    decltype(_blocks)::iterator inserted_block;
+
+bool Blockchain::tryAddBlock(std::shared_ptr<const Block> block)
+{
+    auto hash = block->getHash();
+
+    std::shared_future<void> written;
     {
         std::lock_guard lk(_blocks_mutex);
-        if (!_blocks.empty() && _blocks.find(hash) != _blocks.end()) {
-            return false;
-        }
-        else if (!_blocks.empty() && _top_level_block_hash != block.getPrevBlockHash()) {
-            return false;
-        }
-        else if (_blocks.size() != block.getDepth()) {
+        // a block, that is accepted after a failed write, would never reach the disk
+        _block_writer.checkFailure();
+        if (!tryAddBlockToMemory(hash, block)) {
             return false;
         }
-        else {
-            inserted_block = _blocks.insert({ hash, block }).first;
-            _blocks_by_depth.insert({ block.getDepth(), hash });
-            pushForwardToPersistentStorage(hash, block);
-            _top_level_block_hash = hash;
-        }
+        // enqueued under the lock, so blocks are written in the order of addition
+        written = _block_writer.enqueue(hash, block);
     }
 
     LOG_DEBUG << "Adding block. Block hash = " << hash;
-    _block_added.notify(inserted_block->second);
+    _block_added.notify(*block);
+
+    if (_block_writer.getCommitMode() == BlockWriter::CommitMode::STRICT) {
+        written.get();
+    }
 
     return true;
 }
 
 
-std::optional<Block> Blockchain::findBlock(const base::Sha256& block_hash) const
+bool Blockchain::tryImportBlocks(const BlockWriter::Blocks& blocks)
 {
-    std::shared_lock lk(_blocks_mutex);
-    if (auto it = _blocks.find(block_hash); it != _blocks.end()) {
-        return it->second;
+    // blocks, that were added before, go to disk first, so the chain on disk has no gaps
+    _block_writer.flush().get();
+
+    BlockWriter::Blocks added_blocks;
+    {
+        std::lock_guard lk(_blocks_mutex);
+        for (const auto& [block_hash, block] : blocks) {
+            if (!tryAddBlockToMemory(block_hash, block)) {
+                break;
+            }
+            added_blocks.emplace_back(block_hash, block);
+        }
+    }
+    pushForwardToPersistentStorage(added_blocks);
+
+    for (const auto& [block_hash, block] : added_blocks) {
+        _block_added.notify(*block);
+    }
+    return added_blocks.size() == blocks.size();
+}
+
+
+bool Blockchain::tryAddBlockToMemory(const base::Sha256& block_hash, const std::shared_ptr<const Block>& block)
+{
+    if (!_blocks_by_depth.empty() && _blocks.find(block_hash) != _blocks.end()) {
+        return false;
+    }
+    else if (!_blocks_by_depth.empty() && _top_level_block_hash != block->getPrevBlockHash()) {
+        return false;
+    }
+    else if (_blocks_by_depth.size() != block->getDepth()) {
+        return false;
     }
     else {
-        return std::nullopt;
+        _blocks.insert({ block_hash, block });
+        _blocks_by_depth.insert({ block->getDepth(), block_hash });
+        addTransactionsLocations(block_hash, *block);
+        _top_level_block_hash = block_hash;
+        evictBlocksOutOfTop();
+        return true;
+    }
+}
+
+
+std::shared_ptr<const Block> Blockchain::findBlock(const base::Sha256& block_hash) const
+{
+    {
+        std::shared_lock lk(_blocks_mutex);
+        if (auto it = _blocks.find(block_hash); it != _blocks.end()) {
+            ++_blocks_cache_hits;
+            return it->second;
+        }
+    }
+
+    {
+        std::lock_guard lk(_recent_blocks_mutex);
+        if (auto block = _recent_blocks.find(block_hash); block) {
+            ++_blocks_cache_hits;
+            return block->get();
+        }
+    }
+
+    if (auto block = _block_writer.findPending(block_hash); block) {
+        ++_blocks_cache_hits;
+        return block;
+    }
+
+    ++_blocks_cache_misses;
+    auto block = findBlockAtPersistentStorage(block_hash);
+    if (!block) {
+        return nullptr;
     }
+    auto shared_block = std::make_shared<const Block>(std::move(*block));
+    std::lock_guard lk(_recent_blocks_mutex);
+    _recent_blocks.put(block_hash, shared_block);
+    return shared_block;
 }
 
 
@@ -144,19 +416,56 @@ std::optional<base::Sha256> Blockchain::findBlockHashByDepth(bc::BlockDepth dept
 
 std::optional<bc::Transaction> Blockchain::findTransaction(const base::Sha256& tx_hash) const
 {
-    std::shared_lock lk(_blocks_mutex);
-    for (const auto& block : _blocks) {
-        for (const auto& tx : block.second.getTransactions()) {
-            if (base::Sha256::compute(base::toBytes(tx)) == tx_hash) {
-                return tx;
+    std::optional<std::pair<base::Sha256, std::size_t>> location;
+    {
+        std::shared_lock lk(_blocks_mutex);
+        if (auto location_it = _transactions_locations.find(tx_hash); location_it != _transactions_locations.end()) {
+            const auto& [block_hash, tx_index] = location_it->second;
+            if (auto block_it = _blocks.find(block_hash); block_it != _blocks.end()) {
+                return *std::next(block_it->second->getTransactions().begin(), tx_index);
             }
+            location = location_it->second;
         }
     }
-    return std::nullopt;
+
+    if (!location) {
+        location = findTransactionLocationAtPersistentStorage(tx_hash);
+        if (!location) {
+            return std::nullopt;
+        }
+    }
+
+    auto block = findBlock(location->first);
+    if (!block || location->second >= block->getTransactions().size()) {
+        return std::nullopt;
+    }
+    return *std::next(block->getTransactions().begin(), location->second);
 }
 
 
-const Block& Blockchain::getTopBlock() const
+bool Blockchain::hasTransaction(const base::Sha256& tx_hash) const
+{
+    {
+        std::shared_lock lk(_blocks_mutex);
+        if (_transactions_locations.find(tx_hash) != _transactions_locations.end()) {
+            return true;
+        }
+    }
+    return findTransactionLocationAtPersistentStorage(tx_hash).has_value();
+}
+
+
+std::optional<Block> Blockchain::findBlockHeader(const base::Sha256& block_hash) const
+{
+    // the block of a given hash is still in memory or on disk, if it isn't pruned yet
+    if (auto block = findBlock(block_hash); block) {
+        return toHeader(*block);
+    }
+    return findBlockHeaderAtPersistentStorage(block_hash);
+}
+
+
+std::shared_ptr<const Block> Blockchain::getTopBlock() const
 {
     std::shared_lock lk(_blocks_mutex);
     auto it = _blocks.find(_top_level_block_hash);
@@ -165,58 +474,360 @@ const Block& Blockchain::getTopBlock() const
 }
 
 
-void Blockchain::pushForwardToPersistentStorage(const base::Sha256& block_hash, const Block& block)
+Blockchain::CacheStatistics Blockchain::getBlocksCacheStatistics() const noexcept
+{
+    return CacheStatistics{ _blocks_cache_hits.load(), _blocks_cache_misses.load() };
+}
+
+
+void Blockchain::evictBlocksOutOfTop()
+{
+    auto top_depth = _blocks_by_depth.rbegin()->first;
+    if (top_depth < _top_blocks_cache_size) {
+        return;
+    }
+    // a single block leaves the top after an addition, several ones do after loading
+    for (auto depth = top_depth - _top_blocks_cache_size + 1; depth-- > 0;) {
+        auto it = _blocks.find(_blocks_by_depth.at(depth));
+        if (it == _blocks.end()) {
+            break;
+        }
+        // transactions of a block, that is not written yet, are removed after its write
+        if (_last_written_depth && depth <= *_last_written_depth) {
+            removeTransactionsLocations(it->first, *it->second);
+        }
+        _blocks.erase(it);
+    }
+}
+
+
+void Blockchain::addTransactionsLocations(const base::Sha256& block_hash, const Block& block)
+{
+    block.getTransactions().computeHashes();
+    std::size_t tx_index = 0;
+    for (const auto& tx : block.getTransactions()) {
+        _transactions_locations.insert({ tx.getHash(), { block_hash, tx_index++ } });
+    }
+}
+
+
+void Blockchain::removeTransactionsLocations(const base::Sha256& block_hash, const Block& block)
+{
+    for (const auto& tx : block.getTransactions()) {
+        if (auto it = _transactions_locations.find(tx.getHash());
+            it != _transactions_locations.end() && it->second.first == block_hash) {
+            _transactions_locations.erase(it);
+        }
+    }
+}
+
+
+std::shared_future<void> Blockchain::flush()
+{
+    return _block_writer.flush();
+}
+
+
+std::shared_future<void> Blockchain::getWritten() const
+{
+    return _block_writer.getWritten();
+}
+
+
+void Blockchain::setBlocksWrittenCallback(std::function<void(bc::BlockDepth)> callback)
+{
+    std::lock_guard lk(_blocks_written_mutex);
+    _blocks_written_callback = std::move(callback);
+}
+
+
+void Blockchain::notifyBlocksWritten(const BlockWriter::Blocks& blocks)
+{
+    // the callback is called under the lock, so it isn't unset while it runs
+    std::lock_guard lk(_blocks_written_mutex);
+    if (_blocks_written_callback && !blocks.empty()) {
+        _blocks_written_callback(blocks.back().second->getDepth());
+    }
+}
+
+
+void Blockchain::setPruningLimit(bc::BlockDepth depth)
+{
+    requestPruning(std::nullopt, depth);
+}
+
+
+base::Database& Blockchain::getDatabase() noexcept
+{
+    return _database;
+}
+
+
+const base::Database& Blockchain::getDatabase() const noexcept
+{
+    return _database;
+}
+
+
+void Blockchain::pushForwardToPersistentStorage(const BlockWriter::Blocks& blocks)
 {
-    auto block_data = base::toBytes(block);
+    // the chain has no forks, so blocks up to the last written one are on disk, and a block is looked up on disk
+    // only while the top on disk is unknown, e.g. the genesis, that is added before the chain is loaded
+    std::optional<bc::BlockDepth> last_written_depth;
     {
+        std::shared_lock lk(_blocks_mutex);
+        last_written_depth = _last_written_depth;
+    }
+
+    {
+        // all records of blocks go to disk together, so LAST_BLOCK_HASH never points to a missing block
+        base::Database::WriteBatch batch;
         std::lock_guard lk(_database_rw_mutex);
-        if (_database.exists(toBytes(DataType::BLOCK, block_hash.getBytes()))) {
-            return;
+        for (const auto& [block_hash, block] : blocks) {
+            if (last_written_depth ? block->getDepth() <= *last_written_depth
+                                   : hasBlockAtPersistentStorage(block_hash)) {
+                continue;
+            }
+            // the canonical form is kept by the block, so a received block goes to disk without serialization
+            auto block_bytes = _block_encoding == base::IntegerEncoding::FIXED
+                                 ? block->getSerialized()
+                                 : base::SharedBytes(base::toBytes(*block, _block_encoding));
+            if (_block_files) {
+                batch.put(toBlockLocationKey(block_hash), base::toBytes(_block_files->append(block_bytes)));
+            }
+            else {
+                batch.put(toDatabaseKey(DataType::BLOCK, block_hash.getBytes()), block_bytes);
+            }
+            batch.put(toDatabaseKey(DataType::PREVIOUS_BLOCK_HASH, block_hash.getBytes()),
+                      block->getPrevBlockHash().getBytes());
+            batch.put(toDepthKey(block->getDepth()), block_hash.getBytes());
+            std::size_t tx_index = 0;
+            for (const auto& tx : block->getTransactions()) {
+                auto tx_hash = tx.getHash();
+                batch.put(toTransactionLocationKey(tx_hash), base::toBytes(std::pair{ block_hash, tx_index++ }));
+            }
+            batch.put(LAST_BLOCK_HASH_KEY, block_hash.getBytes());
+        }
+        // locations of blocks are written only after the blocks themselves are on disk
+        if (_block_files) {
+            _block_files->sync();
         }
-        _database.put(toBytes(DataType::BLOCK, block_hash.getBytes()), block_data);
-        _database.put(toBytes(DataType::PREVIOUS_BLOCK_HASH, block_hash.getBytes()),
-                      block.getPrevBlockHash().getBytes());
-        _database.put(LAST_BLOCK_HASH_KEY, block_hash.getBytes());
+        _database.write(batch);
+    }
+
+    {
+        // transactions of blocks, that left the top before they were written, are found on disk from now on
+        std::lock_guard lk(_blocks_mutex);
+        for (const auto& [block_hash, block] : blocks) {
+            if (!_last_written_depth || *_last_written_depth < block->getDepth()) {
+                _last_written_depth = block->getDepth();
+            }
+            if (_blocks.find(block_hash) == _blocks.end()) {
+                removeTransactionsLocations(block_hash, *block);
+            }
+        }
+    }
+
+    if (_prune_depth != 0 && !blocks.empty()) {
+        requestPruning(blocks.back().second->getDepth(), std::nullopt);
     }
 }
 
 
-std::optional<base::Sha256> Blockchain::getLastBlockHashAtPersistentStorage() const
+void Blockchain::requestPruning(std::optional<bc::BlockDepth> written_top_depth, std::optional<bc::BlockDepth> limit)
+{
+    {
+        std::lock_guard lk(_pruning_mutex);
+        if (written_top_depth) {
+            _written_top_depth = std::max(_written_top_depth, *written_top_depth);
+        }
+        if (limit) {
+            _pruning_limit = limit;
+        }
+        _is_pruning_requested = true;
+    }
+    _pruning_cv.notify_one();
+}
+
+
+void Blockchain::pruner()
+{
+    std::unique_lock lk(_pruning_mutex);
+    while (true) {
+        _pruning_cv.wait(lk, [this] { return _is_pruning_stopping || _is_pruning_requested; });
+        if (_is_pruning_stopping) {
+            break;
+        }
+        _is_pruning_requested = false;
+        if (_written_top_depth <= _prune_depth) {
+            continue;
+        }
+        auto end_depth = _written_top_depth - _prune_depth + 1;
+        if (_pruning_limit) {
+            end_depth = std::min(end_depth, *_pruning_limit + 1);
+        }
+        lk.unlock();
+
+        bool is_pruned = true;
+        try {
+            is_pruned = pruneBlocksAtPersistentStorage(end_depth);
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR << "Failed to prune blocks: " << e.what();
+        }
+
+        lk.lock();
+        // a pass is bounded, so the rest of blocks is pruned by next passes
+        if (!is_pruned) {
+            _is_pruning_requested = true;
+        }
+    }
+}
+
+
+bool Blockchain::pruneBlocksAtPersistentStorage(bc::BlockDepth end_depth)
 {
-    if (_database.exists(LAST_BLOCK_HASH_KEY)) {
-        auto hash_data = _database.get(LAST_BLOCK_HASH_KEY);
-        if (hash_data) {
-            return base::Sha256(std::move(hash_data.value()));
+    bc::BlockDepth begin_depth = 0;
+    if (auto pruned_depth_data = _database.get(PRUNED_DEPTH_KEY); pruned_depth_data) {
+        begin_depth = base::fromBytes<bc::BlockDepth>(*pruned_depth_data) + 1;
+    }
+    auto pass_end_depth = std::min<bc::BlockDepth>(end_depth, begin_depth + base::config::BC_PRUNE_MAX_BLOCKS_PER_PASS);
+    if (begin_depth >= pass_end_depth) {
+        return true;
+    }
+
+    // bodies are removed only by this thread, so they are read without the lock, that the writer takes
+    base::Database::WriteBatch batch;
+    for (auto depth = begin_depth; depth < pass_end_depth; ++depth) {
+        auto hash_data = _database.get(toDepthKey(depth));
+        ASSERT(hash_data);
+        base::Sha256 block_hash{ std::move(*hash_data) };
+        if (auto block = loadBlockAtPersistentStorage(block_hash); block) {
+            batch.put(toDatabaseKey(DataType::BLOCK_HEADER, block_hash.getBytes()),
+                      base::toBytes(toHeader(*block), _block_encoding));
+            batch.remove(toDatabaseKey(DataType::BLOCK, block_hash.getBytes()));
+            batch.remove(toBlockLocationKey(block_hash));
+        }
+    }
+    batch.put(PRUNED_DEPTH_KEY, base::toBytes(pass_end_depth - 1));
+    _database.write(batch);
+    LOG_DEBUG << "Pruned bodies of blocks from #" << begin_depth << " to #" << pass_end_depth - 1;
+
+    // blocks are appended in order of depth, so files before the first kept block hold only pruned blocks
+    if (auto first_kept_hash = _database.get(toDepthKey(pass_end_depth)); _block_files && first_kept_hash) {
+        if (auto location = findBlockLocationAtPersistentStorage(base::Sha256(std::move(*first_kept_hash))); location) {
+            // readers map a file after they find a location of a block in it, so they are not given removed files
+            std::lock_guard lk(_database_rw_mutex);
+            _block_files->removeFilesBefore(location->file_index);
         }
     }
+    return pass_end_depth == end_depth;
+}
+
+
+std::optional<base::Sha256> Blockchain::getLastBlockHashAtPersistentStorage() const
+{
+    if (auto hash_data = _database.get(LAST_BLOCK_HASH_KEY); hash_data) {
+        return base::Sha256(std::move(hash_data.value()));
+    }
     return std::nullopt;
 }
 
 
+bool Blockchain::hasBlockAtPersistentStorage(const base::Sha256& block_hash) const
+{
+    // unlike a body, the previous hash is small, it's written by every version and is kept after pruning
+    return _database.exists(toDatabaseKey(DataType::PREVIOUS_BLOCK_HASH, block_hash.getBytes()));
+}
+
+
 std::optional<Block> Blockchain::findBlockAtPersistentStorage(const base::Sha256& block_hash) const
 {
     std::shared_lock lk(_database_rw_mutex);
-    auto block_data = _database.get(toBytes(DataType::BLOCK, block_hash.getBytes()));
+    return loadBlockAtPersistentStorage(block_hash);
+}
+
+
+std::optional<Block> Blockchain::loadBlockAtPersistentStorage(const base::Sha256& block_hash) const
+{
+    // blocks, that were written before block files were turned on, stay in the database
+    if (auto location = findBlockLocationAtPersistentStorage(block_hash); location) {
+        ASSERT(_block_files);
+        auto block_view = _block_files->read(*location);
+        if (!block_view) {
+            RAISE_ERROR(base::DatabaseError, "block file doesn't contain a block with a stored location");
+        }
+        // a block is decoded right from the mapped file
+        return base::fromBytes<Block>(block_view->toBytesView(), _block_encoding);
+    }
+    auto block_data = _database.get(toDatabaseKey(DataType::BLOCK, block_hash.getBytes()));
     if (!block_data) {
         return std::nullopt;
     }
-    base::SerializationIArchive ia(block_data.value());
+    // the block keeps read bytes as its serialized form, if they are canonical
+    base::SerializationIArchive ia(base::SharedBytes(std::move(block_data.value())), _block_encoding);
     return bc::Block::deserialize(ia);
 }
 
 
+std::optional<BlockFiles::Location> Blockchain::findBlockLocationAtPersistentStorage(
+  const base::Sha256& block_hash) const
+{
+    if (auto location_data = _database.get(toBlockLocationKey(block_hash)); location_data) {
+        return base::fromBytes<BlockFiles::Location>(*location_data);
+    }
+    return std::nullopt;
+}
+
+
+std::optional<Block> Blockchain::findBlockHeaderAtPersistentStorage(const base::Sha256& block_hash) const
+{
+    std::shared_lock lk(_database_rw_mutex);
+    auto header_data = _database.get(toDatabaseKey(DataType::BLOCK_HEADER, block_hash.getBytes()));
+    if (!header_data) {
+        return std::nullopt;
+    }
+    return base::fromBytes<Block>(*header_data, _block_encoding);
+}
+
+
+std::optional<std::pair<base::Sha256, std::size_t>> Blockchain::findTransactionLocationAtPersistentStorage(
+  const base::Sha256& tx_hash) const
+{
+    std::shared_lock lk(_database_rw_mutex);
+    auto location_data = _database.get(toTransactionLocationKey(tx_hash));
+    if (!location_data) {
+        return std::nullopt;
+    }
+    base::SerializationIArchive ia(location_data.value());
+    return ia.deserialize<base::Sha256, std::size_t>();
+}
+
+
 std::vector<base::Sha256> Blockchain::createAllBlockHashesListAtPersistentStorage() const
+{
+    std::vector<base::Sha256> all_blocks_hashes{};
+
+    // the iterator reads an implicit snapshot, so concurrent writers don't need to be blocked
+    for (auto it = _database.createIterator(BLOCK_HASH_BY_DEPTH_PREFIX); it.isValid(); it.next()) {
+        all_blocks_hashes.emplace_back(it.value());
+    }
+    return all_blocks_hashes;
+}
+
+
+std::vector<base::Sha256> Blockchain::createAllBlockHashesListByPreviousHashesAtPersistentStorage() const
 {
     std::vector<base::Sha256> all_blocks_hashes{};
     auto last_block_hash = getLastBlockHashAtPersistentStorage();
     if (last_block_hash) {
         base::Sha256 current_block_hash = last_block_hash.value();
 
-        std::shared_lock lk(_database_rw_mutex);
+        auto snapshot = _database.createSnapshot();
         while (current_block_hash != base::Bytes(32)) {
             all_blocks_hashes.push_back(current_block_hash);
             auto previous_block_hash_data =
-              _database.get(toBytes(DataType::PREVIOUS_BLOCK_HASH, current_block_hash.getBytes()));
+              _database.get(toDatabaseKey(DataType::PREVIOUS_BLOCK_HASH, current_block_hash.getBytes()), snapshot);
             ASSERT(previous_block_hash_data);
             current_block_hash = base::Sha256(std::move(previous_block_hash_data.value()));
         }
@@ -5,10 +5,20 @@
 #include "base/utility.hpp"
 
 #include "bc/block.hpp"
+#include "bc/block_files.hpp"
+#include "bc/block_writer.hpp"
 #include "bc/transaction.hpp"
 #include "bc/transactions_set.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <thread>
 #include <unordered_map>
 
 namespace bc
@@ -17,21 +27,59 @@ namespace bc
 class Blockchain
 {
   public:
+    //===================
+    struct CacheStatistics
+    {
+        std::uint64_t hits{ 0 };
+        std::uint64_t misses{ 0 };
+    };
     //===================
     Blockchain(const base::PropertyTree& config);
     Blockchain(const Blockchain&) = delete;
     Blockchain(Blockchain&&) = delete;
-    ~Blockchain() = default;
+    // stops pruning, pending blocks are written
+    ~Blockchain();
     //===================
+    // reads depths of all blocks, but only top blocks are read into memory and notified as added,
+    // deeper blocks are read from disk on demand
     void load();
     //===================
     void addGenesisBlock(const Block& block);
+    // in group commit mode a block is visible right after addition, but is written to disk later, see flush
     bool tryAddBlock(const Block& block);
+    // the block is kept in memory and written to disk without copying
+    bool tryAddBlock(std::shared_ptr<const Block> block);
+    // adds blocks with hashes computed by a caller and writes them to disk with a single write, bypassing
+    // the writer queue; blocks are added until the first one, that doesn't continue the chain
+    bool tryImportBlocks(const BlockWriter::Blocks& blocks);
     std::optional<base::Sha256> findBlockHashByDepth(bc::BlockDepth depth) const;
-    std::optional<bc::Block> findBlock(const base::Sha256& block_hash) const;
+    // returned block is shared with the chain, nullptr is returned if there is no block with a given hash
+    std::shared_ptr<const bc::Block> findBlock(const base::Sha256& block_hash) const;
     std::optional<bc::Transaction> findTransaction(const base::Sha256& tx_hash) const;
+    // unlike findTransaction, finds transactions of pruned blocks as well
+    bool hasTransaction(const base::Sha256& tx_hash) const;
+    // transactions of a returned block are empty, headers are kept for pruned blocks too
+    std::optional<bc::Block> findBlockHeader(const base::Sha256& block_hash) const;
+    //===================
+    // the block is shared, so it stays valid after it leaves the top
+    std::shared_ptr<const bc::Block> getTopBlock() const;
+    //===================
+    CacheStatistics getBlocksCacheStatistics() const noexcept;
+    //===================
+    // returned future gets ready after all blocks added by now are written to disk
+    std::shared_future<void> flush();
+    // the same as flush, but blocks are written at the time, that the commit mode sets
+    std::shared_future<void> getWritten() const;
+    // the callback is called by the writer thread with the depth of the last written block, when blocks are on disk;
+    // an empty callback unsets it, and the previous one is not running after return
+    void setBlocksWrittenCallback(std::function<void(bc::BlockDepth)> callback);
+    //===================
+    // bodies of blocks after a given depth are not pruned, so a caller is able to apply them again after restart
+    void setPruningLimit(bc::BlockDepth depth);
     //===================
-    const bc::Block& getTopBlock() const;
+    // the same database is used by other components of a node to store their records, see bc::DataType
+    base::Database& getDatabase() noexcept;
+    const base::Database& getDatabase() const noexcept;
     //===================
 
     //===================
@@ -40,20 +88,71 @@ class Blockchain
     const base::PropertyTree& _config;
     bool _is_loaded;
     //===================
-    std::unordered_map<base::Sha256, Block> _blocks;
+    // only top blocks are kept here, other blocks are loaded from database on demand
+    const std::size_t _top_blocks_cache_size;
+    // bodies of blocks, that are deeper under the top, are replaced by headers on disk, 0 disables pruning
+    const std::size_t _prune_depth;
+    std::unordered_map<base::Sha256, std::shared_ptr<const Block>> _blocks;
+    // depths of all blocks are kept, since they are small, unlike bodies
     std::map<bc::BlockDepth, base::Sha256> _blocks_by_depth;
     base::Sha256 _top_level_block_hash;
+    // transaction hash -> hash of block with the transaction and index of the transaction in the block, only
+    // transactions of top blocks and of blocks, that are not written yet, are here, others are found on disk
+    std::unordered_map<base::Sha256, std::pair<base::Sha256, std::size_t>> _transactions_locations;
+    std::optional<bc::BlockDepth> _last_written_depth;
     mutable std::shared_mutex _blocks_mutex;
     //===================
+    mutable base::LruCache<base::Sha256, std::shared_ptr<const Block>> _recent_blocks;
+    mutable std::mutex _recent_blocks_mutex;
+    mutable std::atomic<std::uint64_t> _blocks_cache_hits{ 0 };
+    mutable std::atomic<std::uint64_t> _blocks_cache_misses{ 0 };
+    //===================
     base::Database _database;
+    // if set, blocks are kept in flat files and the database keeps only their locations
+    std::unique_ptr<BlockFiles> _block_files;
+    // encoding of stored blocks and headers, it's chosen when the database is created and is kept in it
+    base::IntegerEncoding _block_encoding{ base::IntegerEncoding::FIXED };
     mutable std::shared_mutex _database_rw_mutex;
     //===================
+    // blocks, that are loaded from disk below the top, are not notified, see load
     base::Observable<const bc::Block&> _block_added;
     //===================
-    void pushForwardToPersistentStorage(const base::Sha256& block_hash, const bc::Block& block);
+    // pruning goes in its own thread, so neither the writer nor readers of blocks wait for it
+    std::optional<bc::BlockDepth> _pruning_limit;
+    bc::BlockDepth _written_top_depth{ 0 };
+    bool _is_pruning_requested{ false };
+    bool _is_pruning_stopping{ false };
+    std::mutex _pruning_mutex;
+    std::condition_variable _pruning_cv;
+    std::thread _pruning_thread;
+    //===================
+    std::function<void(bc::BlockDepth)> _blocks_written_callback;
+    std::mutex _blocks_written_mutex;
+    //===================
+    // declared last, so pending blocks are written before other members are destroyed
+    BlockWriter _block_writer;
+    //===================
+    bool tryAddBlockToMemory(const base::Sha256& block_hash, const std::shared_ptr<const Block>& block);
+    void addTransactionsLocations(const base::Sha256& block_hash, const bc::Block& block);
+    void removeTransactionsLocations(const base::Sha256& block_hash, const bc::Block& block);
+    void evictBlocksOutOfTop();
+    void pushForwardToPersistentStorage(const BlockWriter::Blocks& blocks);
+    void notifyBlocksWritten(const BlockWriter::Blocks& blocks);
+    void requestPruning(std::optional<bc::BlockDepth> written_top_depth, std::optional<bc::BlockDepth> limit);
+    void pruner();
+    // prunes a bounded number of blocks before a given depth, returns true if all of them are pruned
+    bool pruneBlocksAtPersistentStorage(bc::BlockDepth end_depth);
     std::optional<base::Sha256> getLastBlockHashAtPersistentStorage() const;
+    bool hasBlockAtPersistentStorage(const base::Sha256& block_hash) const;
     std::optional<bc::Block> findBlockAtPersistentStorage(const base::Sha256& block_hash) const;
+    // the same as findBlockAtPersistentStorage, but the database lock must be held by a caller
+    std::optional<bc::Block> loadBlockAtPersistentStorage(const base::Sha256& block_hash) const;
+    std::optional<BlockFiles::Location> findBlockLocationAtPersistentStorage(const base::Sha256& block_hash) const;
+    std::optional<bc::Block> findBlockHeaderAtPersistentStorage(const base::Sha256& block_hash) const;
+    std::optional<std::pair<base::Sha256, std::size_t>> findTransactionLocationAtPersistentStorage(
+      const base::Sha256& tx_hash) const;
     std::vector<base::Sha256> createAllBlockHashesListAtPersistentStorage() const;
+    std::vector<base::Sha256> createAllBlockHashesListByPreviousHashesAtPersistentStorage() const;
     //===================
 };
 
@@ -0,0 +1,29 @@
+#include "database_keys.hpp"
+
+#include "base/serialization.hpp"
+
+namespace bc
+{
+
+base::Bytes toDatabaseKey(DataType type, const base::Bytes& key)
+{
+    base::Bytes data;
+    data.reserve(1 + key.size());
+    data.append(static_cast<base::Byte>(type));
+    data.append(key);
+    return data;
+}
+
+
+base::Bytes getStateDepthKey()
+{
+    return toDatabaseKey(DataType::SYSTEM, base::Bytes("state_depth"));
+}
+
+
+base::Bytes toStateRootKey(BlockDepth depth)
+{
+    return toDatabaseKey(DataType::STATE_ROOT, base::toBytes(depth));
+}
+
+} // namespace bc
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "base/bytes.hpp"
+#include "bc/types.hpp"
+
+namespace bc
+{
+
+// every key of the node database starts with one of these bytes, so that different kinds of records never collide
+enum class DataType : base::Byte
+{
+    SYSTEM = 1,
+    BLOCK = 2,
+    PREVIOUS_BLOCK_HASH = 3,
+    BLOCK_HASH_BY_DEPTH = 4,
+    TRANSACTION_LOCATION = 6,
+    ACCOUNT = 7,
+    ACCOUNT_STORAGE = 8,
+    CONTRACT_CODE = 9,
+    STATE_TREE_NODE = 10,
+    STATE_ROOT = 11,
+    TRANSACTION_OUTPUT = 12,
+    TRANSACTION_OUTPUT_BY_DEPTH = 13,
+    BLOCK_HEADER = 14,
+    BLOCK_LOCATION = 15
+};
+
+
+base::Bytes toDatabaseKey(DataType type, const base::Bytes& key);
+
+template<std::size_t S>
+base::Bytes toDatabaseKey(DataType type, const base::FixedBytes<S>& key);
+
+// depth of the block, whose state is the last one written to the database
+base::Bytes getStateDepthKey();
+
+// root of the state tree as of a block of a given depth
+base::Bytes toStateRootKey(BlockDepth depth);
+
+} // namespace bc
+
+#include "database_keys.tpp"
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "database_keys.hpp"
+
+namespace bc
+{
+
+template<std::size_t S>
+base::Bytes toDatabaseKey(DataType type, const base::FixedBytes<S>& key)
+{
+    base::Bytes data;
+    data.reserve(1 + S);
+    data.append(static_cast<base::Byte>(type));
+    data.append(key.getData(), S);
+    return data;
+}
+
+} // namespace bc
@@ -50,6 +50,10 @@ void Sign::serialize(base::SerializationOArchive& oa) const
 Sign Sign::deserialize(base::SerializationIArchive& ia)
 {
     auto flag = ia.deserialize<base::Byte>();
+    // any other value would be serialized back differently, so received bytes would not be canonical
+    if (flag > 1) {
+        RAISE_ERROR(base::InvalidArgument, "invalid flag of bc::Sign");
+    }
     if (flag) {
         auto sender_rsa_public_key = base::RsaPublicKey::deserialize(ia);
         auto rsa_encrypted_hash = ia.deserialize<base::Bytes>();
@@ -161,6 +165,8 @@ void Transaction::sign(base::RsaPublicKey pub, const base::RsaPrivateKey& priv)
     // TODO: do a better elliptic curve signature
     base::Bytes rsa_encrypted_hash = priv.encrypt(hash.getBytes().toBytes());
     _sign = Sign{ std::move(pub), rsa_encrypted_hash };
+    _serialized.reset();
+    _hash.reset();
 }
 
 
@@ -191,11 +197,42 @@ const Sign& Transaction::getSign() const noexcept
 }
 
 
+const base::Sha256& Transaction::getHash() const
+{
+    return _hash.get([this] { return base::Sha256::compute(getSerialized()); });
+}
+
+
+void Transaction::computeHashes(const std::vector<Transaction>& txs)
+{
+    std::vector<const Transaction*> not_hashed;
+    std::vector<base::BytesView> serialized;
+    for (const auto& tx : txs) {
+        if (!tx._hash.tryGet()) {
+            not_hashed.push_back(&tx);
+            serialized.emplace_back(tx.getSerialized());
+        }
+    }
+
+    auto hashes = base::Sha256::computeMany(serialized);
+    for (std::size_t i = 0; i < not_hashed.size(); ++i) {
+        not_hashed[i]->_hash.get([&hash = hashes[i]] { return std::move(hash); });
+    }
+}
+
+
+const base::SharedBytes& Transaction::getSerialized() const
+{
+    return _serialized.get([this] { return base::SharedBytes(base::toBytes(*this)); });
+}
+
+
 base::Sha256 Transaction::hashOfTxData() const
 {
-    base::SerializationOArchive oa;
+    base::Sha256Hasher hasher;
+    base::SerializationOArchive oa{ hasher };
     serializeHeader(oa);
-    return base::Sha256::compute(std::move(oa).getBytes());
+    return hasher.finalize();
 }
 
 
@@ -213,6 +250,7 @@ void Transaction::serializeHeader(base::SerializationOArchive& oa) const
 
 Transaction Transaction::deserialize(base::SerializationIArchive& ia)
 {
+    auto begin_position = ia.getPosition();
     auto from = ia.deserialize<bc::Address>();
     auto to = ia.deserialize<bc::Address>();
     auto amount = ia.deserialize<bc::Balance>();
@@ -221,12 +259,26 @@ Transaction Transaction::deserialize(base::SerializationIArchive& ia)
     auto tx_type = ia.deserialize<Type>();
     auto data = ia.deserialize<base::Bytes>();
     auto sign = ia.deserialize<bc::Sign>();
-    return { std::move(from), std::move(to), amount, fee, timestamp, tx_type, std::move(data), std::move(sign) };
+    Transaction ret{
+        std::move(from), std::move(to), amount, fee, timestamp, tx_type, std::move(data), std::move(sign)
+    };
+    // fixed encoding is canonical, so received bytes are the same as serialized ones
+    if (auto serialized = ia.takeSharedPart(begin_position);
+        serialized && ia.getEncoding() == base::IntegerEncoding::FIXED) {
+        ret._serialized.get([&serialized] { return std::move(*serialized); });
+    }
+    return ret;
 }
 
 
 void Transaction::serialize(base::SerializationOArchive& oa) const
 {
+    // the kept serialized form is the canonical one, that is hashed
+    const auto* serialized = _serialized.tryGet();
+    if (serialized && oa.getEncoding() == base::IntegerEncoding::FIXED) {
+        oa.write(serialized->getData(), serialized->size());
+        return;
+    }
     serializeHeader(oa);
     oa.serialize(_sign);
 }
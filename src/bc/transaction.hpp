@@ -3,10 +3,13 @@
 #include "base/crypto.hpp"
 #include "base/serialization.hpp"
 #include "base/time.hpp"
+#include "base/utility.hpp"
 
 #include "bc/address.hpp"
 #include "bc/types.hpp"
 
+#include <vector>
+
 namespace bc
 {
 
@@ -76,6 +79,11 @@ class Transaction
     bool checkSign() const;
     const bc::Sign& getSign() const noexcept;
     //=================
+    // computed once together with serialized form of the transaction, which is then reused by serialization
+    const base::Sha256& getHash() const;
+    // computes hashes, that were not computed yet, in one batch, so SIMD lanes hash several transactions at once
+    static void computeHashes(const std::vector<Transaction>& txs);
+    //=================
     bool operator==(const Transaction& other) const;
     bool operator!=(const Transaction& other) const;
 
@@ -94,6 +102,12 @@ class Transaction
     base::Bytes _data;
     bc::Sign _sign;
     //=================
+    // both are reset on every change of the transaction
+    base::Memoized<base::SharedBytes> _serialized;
+    base::Memoized<base::Sha256> _hash;
+    //=================
+    // canonical serialized form, that is hashed; a transaction deserialized from SharedBytes keeps received bytes
+    const base::SharedBytes& getSerialized() const;
     void serializeHeader(base::SerializationOArchive& oa) const;
     base::Sha256 hashOfTxData() const;
     //=================
@@ -23,8 +23,7 @@ bool TransactionsSet::find(const bc::Transaction& tx) const
 
 std::optional<Transaction> TransactionsSet::find(const base::Sha256& hash) const
 {
-    auto it = std::find_if(
-      _txs.begin(), _txs.end(), [&hash](const auto& tx) { return base::Sha256::compute(base::toBytes(tx)) == hash; });
+    auto it = std::find_if(_txs.begin(), _txs.end(), [&hash](const auto& tx) { return tx.getHash() == hash; });
 
     if (it == _txs.end()) {
         return std::nullopt;
@@ -58,6 +57,12 @@ bool TransactionsSet::isEmpty() const
 }
 
 
+void TransactionsSet::computeHashes() const
+{
+    Transaction::computeHashes(_txs);
+}
+
+
 std::size_t TransactionsSet::size() const
 {
     return _txs.size();
@@ -20,6 +20,8 @@ class TransactionsSet
     bool isEmpty() const;
 
     std::size_t size() const;
+    // see Transaction::computeHashes
+    void computeHashes() const;
 
     std::vector<Transaction>::const_iterator begin() const;
     std::vector<Transaction>::const_iterator end() const;
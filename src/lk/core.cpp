@@ -1,12 +1,14 @@
 #include "core.hpp"
 
+#include "base/config.hpp"
 #include "base/log.hpp"
+#include "bc/database_keys.hpp"
 #include "vm/tools.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 
-
 namespace lk
 {
 
@@ -14,19 +16,102 @@ Core::Core(const base::PropertyTree& config, const base::KeyVault& key_vault)
   : _config{ config }
   , _vault{ key_vault }
   , _this_node_address{ _vault.getPublicKey() }
+  , _max_uncommitted_blocks{ std::max<std::size_t>(
+      _config.get<std::size_t>("database.group_commit_max_blocks", base::config::DATABASE_GROUP_COMMIT_MAX_BLOCKS),
+      1) }
   , _blockchain{ _config }
+  , _account_manager{ _blockchain.getDatabase(),
+                      _config.get<std::size_t>("state.accounts_cache_size", base::config::STATE_ACCOUNTS_CACHE_SIZE),
+                      _config.get<std::size_t>("state.storage_values_cache_size",
+                                               base::config::STATE_STORAGE_VALUES_CACHE_SIZE) }
+  , _code_manager{ _blockchain.getDatabase(),
+                   _config.get<std::size_t>("state.codes_cache_size", base::config::STATE_CODES_CACHE_SIZE) }
+  , _output_manager{ _blockchain.getDatabase(),
+                     _config.get<std::size_t>("state.outputs_cache_size", base::config::STATE_OUTPUTS_CACHE_SIZE),
+                     _config.get<std::size_t>("state.outputs_retention_depth",
+                                              base::config::STATE_OUTPUTS_RETENTION_DEPTH) }
   , _network{ _config, *this }
   , _eth_adapter{ *this, _account_manager, _code_manager }
 {
+    // bodies of blocks are kept until their state is committed, so they can be applied again after a crash
+    _blockchain.setPruningLimit(0);
     [[maybe_unused]] bool result = _blockchain.tryAddBlock(getGenesisBlock());
     ASSERT(result);
-    _account_manager.updateFromGenesis(getGenesisBlock());
-    _is_account_manager_updated = true;
 
     _blockchain.load();
-    for (bc::BlockDepth d = 1; d <= _blockchain.getTopBlock().getDepth(); ++d) {
-        auto block = *_blockchain.findBlock(*_blockchain.findBlockHashByDepth(d));
-        _account_manager.update(block);
+    // state is written only after its blocks, so the genesis goes to disk first
+    _blockchain.flush().get();
+
+    // state is ahead of the chain only in a database, that was written by an older version
+    auto top_depth = _blockchain.getTopBlock()->getDepth();
+    auto state_depth = getCommittedStateDepth();
+    if (state_depth && *state_depth > top_depth) {
+        LOG_WARNING << "State of block #" << *state_depth << " is ahead of the chain top #" << top_depth
+                    << ", rebuilding it";
+        state_depth = std::nullopt;
+    }
+    else if (state_depth && !findStateRoot(*state_depth)) {
+        LOG_WARNING << "State of block #" << *state_depth << " was written without a state root, rebuilding it";
+        state_depth = std::nullopt;
+    }
+    if (!state_depth) {
+        // records of state may be left without a committed depth, e.g. by an interrupted import of a snapshot
+        _account_manager.clear();
+        _code_manager.clear();
+        _account_manager.updateFromGenesis(getGenesisBlock());
+        commitState(0);
+        state_depth = 0;
+    }
+    _is_account_manager_updated = true;
+    _applied_depth = *state_depth;
+    _blockchain.setPruningLimit(*state_depth);
+
+    // only blocks after the committed state are applied again, they are on disk already
+    LOG_INFO << "Applying blocks from #" << *state_depth + 1 << " to #" << top_depth;
+    for (bc::BlockDepth d = *state_depth + 1; d <= top_depth; ++d) {
+        auto block = _blockchain.findBlock(*_blockchain.findBlockHashByDepth(d));
+        if (!block) {
+            RAISE_ERROR(base::LogicError,
+                        "body of block #" + std::to_string(d) + " is pruned, so the state cannot be rebuilt");
+        }
+        applyBlockTransactions(*block);
+        _applied_depth = d;
+        if (++_uncommitted_blocks_count >= _max_uncommitted_blocks) {
+            commitState(_applied_depth);
+        }
+    }
+    if (_uncommitted_blocks_count != 0) {
+        commitState(_applied_depth);
+    }
+
+    _committer_thread = std::thread(&Core::committer, this);
+    _blockchain.setBlocksWrittenCallback([this](bc::BlockDepth depth) { onBlocksWritten(depth); });
+}
+
+
+Core::~Core()
+{
+    _blockchain.setBlocksWrittenCallback({});
+    {
+        std::lock_guard lk(_committer_mutex);
+        _is_committer_stopping = true;
+    }
+    _committer_cv.notify_all();
+    if (_committer_thread.joinable()) {
+        _committer_thread.join();
+    }
+
+    // state of blocks, that are written on shutdown, is kept, so they are not applied again on the next start
+    std::unique_lock lk(_state_mutex);
+    if (_uncommitted_blocks_count == 0) {
+        return;
+    }
+    try {
+        _blockchain.flush().get();
+        commitState(_applied_depth);
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR << "Failed to write state of block #" << _applied_depth << ": " << e.what();
     }
 }
 
@@ -95,11 +180,10 @@ void Core::addPendingTransactionAndWait(const bc::Transaction& tx)
 }
 
 
-base::Bytes Core::getTransactionOutput(const base::Sha256& tx)
+base::Bytes Core::getTransactionOutput(const base::Sha256& tx) const
 {
-    std::shared_lock lk(_tx_outputs_mutex);
-    if (auto it = _tx_outputs.find(tx); it != _tx_outputs.end()) {
-        return it->second;
+    if (auto output = _output_manager.getOutput(tx); output) {
+        return std::move(*output);
     }
     else {
         return {};
@@ -109,23 +193,35 @@ base::Bytes Core::getTransactionOutput(const base::Sha256& tx)
 
 bool Core::tryAddBlock(const bc::Block& b)
 {
-    if (checkBlock(b) && _blockchain.tryAddBlock(b)) {
+    return tryAddBlock(std::make_shared<const bc::Block>(b));
+}
+
+
+bool Core::tryAddBlock(std::shared_ptr<const bc::Block> b)
+{
+    {
+        // the block is checked against the same state it is applied to
+        std::unique_lock lk(_state_mutex);
+        if (!checkBlock(*b) || !_blockchain.tryAddBlock(b)) {
+            return false;
+        }
         {
-            std::shared_lock lk(_pending_transactions_mutex);
-            _pending_transactions.remove(b.getTransactions());
+            std::unique_lock pending_lk(_pending_transactions_mutex);
+            _pending_transactions.remove(b->getTransactions());
         }
-        LOG_DEBUG << "Applying transactions from block #" << b.getDepth();
-        applyBlockTransactions(b);
-        _event_block_added.notify(b);
-        return true;
-    }
-    else {
-        return false;
+        LOG_DEBUG << "Applying transactions from block #" << b->getDepth();
+        applyBlockTransactions(*b);
+        _applied_depth = b->getDepth();
+        ++_uncommitted_blocks_count;
+        commitStateOfWrittenBlocks();
     }
+    // subscribers may call the core back, so they are notified without the lock
+    _event_block_added.notify(*b);
+    return true;
 }
 
 
-std::optional<bc::Block> Core::findBlock(const base::Sha256& hash) const
+std::shared_ptr<const bc::Block> Core::findBlock(const base::Sha256& hash) const
 {
     return _blockchain.findBlock(hash);
 }
@@ -139,10 +235,11 @@ std::optional<base::Sha256> Core::findBlockHash(const bc::BlockDepth& depth) con
 
 bool Core::checkBlock(const bc::Block& b) const
 {
-    if (_blockchain.findBlock(base::Sha256::compute(base::toBytes(b)))) {
+    if (_blockchain.findBlock(b.getHash())) {
         return false;
     }
 
+    b.getTransactions().computeHashes();
     // FIXME: this works wrong if two transactions are both valid, but together are not
     for (const auto& tx : b.getTransactions()) {
         if (!_account_manager.checkTransaction(tx)) {
@@ -161,7 +258,7 @@ bool Core::checkTransaction(const bc::Transaction& tx) const
         return false;
     }
 
-    if (_blockchain.findTransaction(base::Sha256::compute(base::toBytes(tx)))) {
+    if (_blockchain.hasTransaction(tx.getHash())) {
         return false;
     }
 
@@ -175,6 +272,7 @@ bool Core::checkTransaction(const bc::Transaction& tx) const
         current_pending_balance = bc::calcBalance(_pending_transactions);
     }
 
+    std::shared_lock lk(_state_mutex);
     auto pending_from_account_balance = current_pending_balance.find(tx.getFrom());
     if (pending_from_account_balance != current_pending_balance.end()) {
         auto current_from_account_balance = _account_manager.getBalance(tx.getFrom());
@@ -188,9 +286,9 @@ bool Core::checkTransaction(const bc::Transaction& tx) const
 
 bc::Block Core::getBlockTemplate() const
 {
-    const auto& top_block = _blockchain.getTopBlock();
-    bc::BlockDepth depth = top_block.getDepth() + 1;
-    auto prev_hash = base::Sha256::compute(base::toBytes(top_block));
+    auto top_block = _blockchain.getTopBlock();
+    bc::BlockDepth depth = top_block->getDepth() + 1;
+    auto prev_hash = top_block->getHash();
     std::shared_lock lk(_pending_transactions_mutex);
     return bc::Block{ depth, prev_hash, base::Time::now(), getThisNodeAddress(), _pending_transactions };
 }
@@ -198,16 +296,34 @@ bc::Block Core::getBlockTemplate() const
 
 bc::Balance Core::getBalance(const bc::Address& address) const
 {
+    std::shared_lock lk(_state_mutex);
     return _account_manager.getBalance(address);
 }
 
 
-const bc::Block& Core::getTopBlock() const
+std::shared_ptr<const bc::Block> Core::getTopBlock() const
 {
     return _blockchain.getTopBlock();
 }
 
 
+std::optional<base::Sha256> Core::findStateRoot(bc::BlockDepth depth) const
+{
+    std::shared_lock lk(_state_mutex);
+    if (auto it = _uncommitted_state_roots.find(depth); it != _uncommitted_state_roots.end()) {
+        return it->second;
+    }
+    // roots above the committed state may be left from blocks, that were lost before they were written
+    if (auto state_depth = getCommittedStateDepth(); !state_depth || *state_depth < depth) {
+        return std::nullopt;
+    }
+    if (auto root_data = _blockchain.getDatabase().get(bc::toStateRootKey(depth)); root_data) {
+        return base::Sha256(*root_data);
+    }
+    return std::nullopt;
+}
+
+
 const bc::Address& Core::getThisNodeAddress() const noexcept
 {
     return _this_node_address;
@@ -227,12 +343,99 @@ void Core::applyBlockTransactions(const bc::Block& block)
         constexpr bc::Balance EMISSION_VALUE = 1000;
         _account_manager.getAccount(block.getCoinbase()).addBalance(EMISSION_VALUE);
     }
+    _uncommitted_state_roots.insert_or_assign(block.getDepth(), _account_manager.updateStateRoot());
+}
+
+
+void Core::commitStateOfWrittenBlocks()
+{
+    auto written = _blockchain.getWritten();
+    if (_uncommitted_blocks_count >= _max_uncommitted_blocks) {
+        // state of too many blocks is kept in memory, so writing of the blocks is hurried
+        written = _blockchain.flush();
+    }
+    else if (written.wait_for(std::chrono::seconds::zero()) != std::future_status::ready) {
+        // state is written with a later block, a crash before that makes the node apply the blocks again
+        return;
+    }
+    written.get();
+    commitState(_applied_depth);
+}
+
+
+void Core::onBlocksWritten(bc::BlockDepth depth)
+{
+    {
+        std::lock_guard lk(_committer_mutex);
+        _written_depth = depth;
+    }
+    _committer_cv.notify_one();
+}
+
+
+void Core::committer()
+{
+    std::unique_lock lk(_committer_mutex);
+    while (true) {
+        _committer_cv.wait(lk, [this] { return _is_committer_stopping || _written_depth; });
+        if (_is_committer_stopping) {
+            break;
+        }
+        auto written_depth = *_written_depth;
+        _written_depth.reset();
+        lk.unlock();
+
+        {
+            std::unique_lock state_lk(_state_mutex);
+            // blocks, that were applied after the written ones, are committed after their own group is written
+            if (_uncommitted_blocks_count != 0 && _applied_depth <= written_depth) {
+                try {
+                    commitState(_applied_depth);
+                }
+                catch (const std::exception& e) {
+                    LOG_ERROR << "Failed to write state of block #" << _applied_depth << ": " << e.what();
+                }
+            }
+        }
+
+        lk.lock();
+    }
+}
+
+
+void Core::commitState(bc::BlockDepth depth)
+{
+    // state depth is written together with the state, so they never mismatch on disk
+    base::Database::WriteBatch batch;
+    _code_manager.flush(batch);
+    _output_manager.flush(batch, depth);
+    auto state_root = _account_manager.flush(batch);
+    for (const auto& [root_depth, root] : _uncommitted_state_roots) {
+        batch.put(bc::toStateRootKey(root_depth), root.getBytes());
+    }
+    batch.put(bc::toStateRootKey(depth), state_root.getBytes());
+    batch.put(bc::getStateDepthKey(), base::toBytes(depth));
+    // the state is applied again from blocks, if it's lost, so it doesn't cost a sync in addition to the blocks
+    _blockchain.getDatabase().writeUnsynced(batch);
+    _blockchain.setPruningLimit(depth);
+    _account_manager.shrink();
+    _uncommitted_state_roots.clear();
+    _uncommitted_blocks_count = 0;
+}
+
+
+std::optional<bc::BlockDepth> Core::getCommittedStateDepth() const
+{
+    if (auto depth_data = _blockchain.getDatabase().get(bc::getStateDepthKey()); depth_data) {
+        return base::fromBytes<bc::BlockDepth>(*depth_data);
+    }
+    return std::nullopt;
 }
 
 
 bool Core::tryPerformTransaction(const bc::Transaction& tx, const bc::Block& block_where_tx)
 {
-    auto hash = base::Sha256::compute(base::toBytes(tx));
+    auto hash = tx.getHash();
     if (tx.getType() == bc::Transaction::Type::CONTRACT_CREATION) {
         try {
             _account_manager.getAccount(tx.getFrom()).subBalance(tx.getFee());
@@ -243,10 +446,7 @@ bool Core::tryPerformTransaction(const bc::Transaction& tx, const bc::Block& blo
             oa.serialize(address);
             oa.serialize(result);
             oa.serialize(gas_left);
-            {
-                std::unique_lock lk(_tx_outputs_mutex);
-                _tx_outputs[hash] = std::move(oa).getBytes();
-            }
+            _output_manager.saveOutput(hash, block_where_tx.getDepth(), std::move(oa).getBytes());
             _account_manager.getAccount(block_where_tx.getCoinbase()).addBalance(tx.getFee() - gas_left);
             _account_manager.getAccount(tx.getFrom()).addBalance(gas_left);
         }
@@ -264,10 +464,7 @@ bool Core::tryPerformTransaction(const bc::Transaction& tx, const bc::Block& blo
             oa.serialize(true);
             oa.serialize(result.toOutputData());
             oa.serialize(result.gasLeft());
-            {
-                std::unique_lock lk(_tx_outputs_mutex);
-                _tx_outputs[hash] = std::move(oa).getBytes();
-            }
+            _output_manager.saveOutput(hash, block_where_tx.getDepth(), std::move(oa).getBytes());
             _account_manager.getAccount(block_where_tx.getCoinbase()).addBalance(tx.getFee() - result.gasLeft());
             _account_manager.getAccount(tx.getFrom()).addBalance(result.gasLeft());
             return true;
@@ -10,7 +10,11 @@
 #include "lk/protocol.hpp"
 #include "net/host.hpp"
 
+#include <condition_variable>
+#include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <thread>
 
 namespace lk
 {
@@ -28,7 +32,7 @@ class Core
      *
      *  @threadsafe
      */
-    ~Core() = default;
+    ~Core();
     //==================
     /**
      *  @brief Loads blockchain from disk and runs networking.
@@ -42,17 +46,27 @@ class Core
     //==================
     bool addPendingTransaction(const bc::Transaction& tx);
     void addPendingTransactionAndWait(const bc::Transaction& tx);
-    base::Bytes getTransactionOutput(const base::Sha256& tx_hash);
+    // returns empty bytes if a transaction was not executed or its output was pruned
+    base::Bytes getTransactionOutput(const base::Sha256& tx_hash) const;
     //==================
     bool tryAddBlock(const bc::Block& b);
-    std::optional<bc::Block> findBlock(const base::Sha256& hash) const;
+    // the block is shared with the blockchain, so it isn't copied
+    bool tryAddBlock(std::shared_ptr<const bc::Block> b);
+    // returns nullptr if there is no block with a given hash
+    std::shared_ptr<const bc::Block> findBlock(const base::Sha256& hash) const;
     std::optional<base::Sha256> findBlockHash(const bc::BlockDepth& depth) const;
-    const bc::Block& getTopBlock() const;
+    std::shared_ptr<const bc::Block> getTopBlock() const;
+    //==================
+    // root of the state tree after a block with given depth is applied
+    std::optional<base::Sha256> findStateRoot(bc::BlockDepth depth) const;
     //==================
     bc::Block getBlockTemplate() const;
     //==================
     const bc::Address& getThisNodeAddress() const noexcept;
     //==================
+    // every chain of this network starts with it
+    static const bc::Block& getGenesisBlock();
+    //==================
   private:
     //==================
     friend class lk::EthAdapter;
@@ -64,23 +78,48 @@ class Core
     base::Observable<const bc::Block&> _event_block_added;
     base::Observable<const bc::Transaction&> _event_new_pending_transaction;
     //==================
+    // blocks are applied and their state is committed one at a time, readers of accounts share the lock; references
+    // to accounts, that AccountManager returns, and the counters below are used only under it
+    mutable std::shared_mutex _state_mutex;
     bool _is_account_manager_updated{ false };
+    // state of applied blocks is written only after the blocks are on disk, so it is never ahead of the chain;
+    // applying blocks waits for their writing, if state of this many blocks is not committed
+    const std::size_t _max_uncommitted_blocks;
+    std::size_t _uncommitted_blocks_count{ 0 };
+    bc::BlockDepth _applied_depth{ 0 };
+    // roots of applied blocks are known before their state is committed, they are written with it
+    std::map<bc::BlockDepth, base::Sha256> _uncommitted_state_roots;
+    // state is kept in the blockchain database, so the blockchain goes first
+    bc::Blockchain _blockchain;
     AccountManager _account_manager;
     CodeManager _code_manager;
-    bc::Blockchain _blockchain;
+    OutputManager _output_manager;
     lk::Network _network;
     //==================
     lk::EthAdapter _eth_adapter;
     //==================
-    std::unordered_map<base::Sha256, base::Bytes> _tx_outputs;
-    mutable std::shared_mutex _tx_outputs_mutex;
-    //==================
     bc::TransactionsSet _pending_transactions;
     mutable std::shared_mutex _pending_transactions_mutex;
     //==================
-    static const bc::Block& getGenesisBlock();
+    // state of written blocks is committed in its own thread, so the writer of blocks never waits for the state lock
+    std::optional<bc::BlockDepth> _written_depth;
+    bool _is_committer_stopping{ false };
+    std::mutex _committer_mutex;
+    std::condition_variable _committer_cv;
+    std::thread _committer_thread;
+    //==================
     void applyBlockTransactions(const bc::Block& block);
     //==================
+    // commits state of applied blocks, if they are written already or too many of them are not committed
+    void commitStateOfWrittenBlocks();
+    void onBlocksWritten(bc::BlockDepth depth);
+    void committer();
+    // writes accounts, codes of contracts, outputs of transactions and state roots of blocks up to given depth to
+    // database, the blocks must be on disk
+    void commitState(bc::BlockDepth depth);
+    // depth of the last block, which state was written to database
+    std::optional<bc::BlockDepth> getCommittedStateDepth() const;
+    //==================
     bool checkBlock(const bc::Block& block) const;
     bool checkTransaction(const bc::Transaction& tx) const;
     //==================
@@ -59,31 +59,28 @@ class EthAdapter::EthHost : public evmc::Host
         auto key = base::Sha256(base::Bytes(ekey.bytes, 32));
         base::Bytes new_value(evalue.bytes, 32);
 
-        auto& account_state = _account_manager.getAccount(address);
-
-        if (!account_state.checkStorageValue(key)) {
-            if (new_value == NULL_VALUE) {
-                return evmc_storage_status::EVMC_STORAGE_UNCHANGED;
-            }
-            else {
-                account_state.setStorageValue(key, new_value);
-                return evmc_storage_status::EVMC_STORAGE_ADDED;
-            }
+        // the account is looked up for every access instead of keeping a reference to it: references to accounts
+        // are valid only until AccountManager::shrink
+        std::optional<base::Bytes> old_value;
+        if (_account_manager.getAccount(address).checkStorageValue(key)) {
+            old_value = _account_manager.getAccount(address).getStorageValue(key).data;
+        }
+        if (!old_value && new_value == NULL_VALUE) {
+            return evmc_storage_status::EVMC_STORAGE_UNCHANGED;
+        }
+
+        _account_manager.getAccount(address).setStorageValue(key, new_value);
+        if (!old_value) {
+            return evmc_storage_status::EVMC_STORAGE_ADDED;
+        }
+        else if (*old_value == new_value) {
+            return evmc_storage_status::EVMC_STORAGE_UNCHANGED;
+        }
+        else if (new_value == NULL_VALUE) {
+            return evmc_storage_status::EVMC_STORAGE_DELETED;
         }
         else {
-            auto old_storage_data = account_state.getStorageValue(key);
-            const auto& old_value = old_storage_data.data;
-
-            account_state.setStorageValue(key, new_value);
-            if (old_value == new_value) {
-                return evmc_storage_status::EVMC_STORAGE_UNCHANGED;
-            }
-            else if (new_value == NULL_VALUE) {
-                return evmc_storage_status::EVMC_STORAGE_DELETED;
-            }
-            else {
-                return evmc_storage_status::EVMC_STORAGE_MODIFIED;
-            }
+            return evmc_storage_status::EVMC_STORAGE_MODIFIED;
         }
     }
 
@@ -113,7 +110,7 @@ class EthAdapter::EthHost : public evmc::Host
             return 0;
         }
         else {
-            return code->get().size();
+            return code->size();
         }
     }
 
@@ -139,12 +136,12 @@ class EthAdapter::EthHost : public evmc::Host
         LOG_DEBUG << "Core::copy_code";
         auto address = vm::toNativeAddress(addr);
         auto account_code_hash = _account_manager.getAccount(address).getCodeHash();
-        if (auto code_opt = _code_manager.getCode(account_code_hash); !code_opt) {
+        if (auto code_ptr = _code_manager.getCode(account_code_hash); !code_ptr) {
             ASSERT(false);
             return 0;
         }
         else {
-            const auto& code = code_opt->get();
+            const auto& code = *code_ptr;
             std::size_t bytes_to_copy = std::min(buffer_size, code.size() - code_offset);
             std::copy_n(code.getData() + code_offset, bytes_to_copy, buffer_data);
             return bytes_to_copy;
@@ -159,11 +156,12 @@ class EthAdapter::EthHost : public evmc::Host
 
         LOG_DEBUG << "Core::selfdestruct";
         auto address = vm::toNativeAddress(eaddr);
-        auto account = _account_manager.getAccount(address);
+        auto balance = _account_manager.getBalance(address);
         auto beneficiary_address = vm::toNativeAddress(ebeneficiary);
-        auto beneficiary_account = _account_manager.getAccount(beneficiary_address);
+        // the beneficiary account is created, even if nothing is transferred to it
+        _account_manager.getAccount(beneficiary_address);
 
-        _account_manager.tryTransferMoney(address, beneficiary_address, account.getBalance());
+        _account_manager.tryTransferMoney(address, beneficiary_address, balance);
         _account_manager.deleteAccount(address);
     }
 
@@ -308,11 +306,11 @@ vm::ExecutionResult EthAdapter::call(const bc::Transaction& associated_tx, const
 
     auto code_hash = _account_manager.getAccount(associated_tx.getTo()).getCodeHash();
 
-    if (auto code_opt = _code_manager.getCode(code_hash); !code_opt) {
+    if (auto code = _code_manager.getCode(code_hash); !code) {
         RAISE_ERROR(base::Error, "cannot find code by hash");
     }
     else {
-        vm::SmartContract contract(*code_opt);
+        vm::SmartContract contract(*code);
         auto message = contract.createMessage(associated_tx.getFee(),
                                               associated_tx.getFrom(),
                                               associated_tx.getTo(),
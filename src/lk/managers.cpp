@@ -1,6 +1,118 @@
 #include "managers.hpp"
 
 #include "base/error.hpp"
+#include "bc/database_keys.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+const base::Bytes ACCOUNTS_PREFIX{ bc::toDatabaseKey(bc::DataType::ACCOUNT, base::Bytes{}) };
+
+const base::Bytes STORAGE_VALUES_PREFIX{ bc::toDatabaseKey(bc::DataType::ACCOUNT_STORAGE, base::Bytes{}) };
+
+const base::Bytes CODES_PREFIX{ bc::toDatabaseKey(bc::DataType::CONTRACT_CODE, base::Bytes{}) };
+
+const base::Bytes OUTPUTS_BY_DEPTH_PREFIX{ bc::toDatabaseKey(bc::DataType::TRANSACTION_OUTPUT_BY_DEPTH,
+                                                             base::Bytes{}) };
+
+
+base::Bytes toAccountKey(const bc::Address& address)
+{
+    return bc::toDatabaseKey(bc::DataType::ACCOUNT, address.getBytes());
+}
+
+
+// account records and storage values are hashed from data of different length to get keys in the state tree
+base::Bytes toAccountLeafKeyData(const bc::Address& address)
+{
+    return address.getBytes().toBytes();
+}
+
+
+base::Bytes toStorageLeafKeyData(const bc::Address& address, const base::Sha256& key)
+{
+    auto data = address.getBytes().toBytes();
+    data.append(key.getBytes().getData(), base::Sha256::SHA256_SIZE);
+    return data;
+}
+
+
+base::Sha256 toAccountLeafKey(const bc::Address& address)
+{
+    return base::Sha256::compute(toAccountLeafKeyData(address));
+}
+
+
+base::Sha256 toStorageLeafKey(const bc::Address& address, const base::Sha256& key)
+{
+    return base::Sha256::compute(toStorageLeafKeyData(address, key));
+}
+
+
+// keys and values of updated leaves are hashed in one batch, so SIMD lanes hash several of them at once
+class LeavesHasher
+{
+  public:
+    void add(base::Bytes key_data, base::Bytes value)
+    {
+        _keys_data.push_back(std::move(key_data));
+        _values.push_back(std::move(value));
+    }
+
+    void hashTo(lk::StateTree::Changes& changes) const
+    {
+        std::vector<base::BytesView> data(_keys_data.begin(), _keys_data.end());
+        data.insert(data.end(), _values.begin(), _values.end());
+        auto hashes = base::Sha256::computeMany(data);
+        for (std::size_t i = 0; i < _keys_data.size(); ++i) {
+            changes[std::move(hashes[i])] = std::move(hashes[_keys_data.size() + i]);
+        }
+    }
+
+  private:
+    std::vector<base::Bytes> _keys_data;
+    std::vector<base::Bytes> _values;
+};
+
+
+base::Bytes toCodeKey(const base::Sha256& hash)
+{
+    return bc::toDatabaseKey(bc::DataType::CONTRACT_CODE, hash.getBytes());
+}
+
+
+base::Bytes toOutputKey(const base::Sha256& tx_hash)
+{
+    return bc::toDatabaseKey(bc::DataType::TRANSACTION_OUTPUT, tx_hash.getBytes());
+}
+
+
+// depth goes first and is serialized as big-endian, so outputs of older blocks are met first by iterator
+base::Bytes toOutputByDepthKey(bc::BlockDepth depth, const base::Sha256& tx_hash)
+{
+    auto data = bc::toDatabaseKey(bc::DataType::TRANSACTION_OUTPUT_BY_DEPTH, base::toBytes(depth));
+    data.append(tx_hash.getBytes().getData(), base::Sha256::SHA256_SIZE);
+    return data;
+}
+
+
+base::Bytes toStorageKeysPrefix(const bc::Address& address)
+{
+    return bc::toDatabaseKey(bc::DataType::ACCOUNT_STORAGE, address.getBytes());
+}
+
+
+base::Bytes toStorageKey(const bc::Address& address, const base::Sha256& key)
+{
+    auto data = toStorageKeysPrefix(address);
+    data.append(key.getBytes().getData(), base::Sha256::SHA256_SIZE);
+    return data;
+}
+
+} // namespace
 
 namespace lk
 {
@@ -15,6 +127,7 @@ std::uint64_t AccountState::getNonce() const noexcept
 void AccountState::incNonce() noexcept
 {
     ++_nonce;
+    _was_modified = true;
 }
 
 
@@ -27,12 +140,14 @@ bc::Balance AccountState::getBalance() const noexcept
 void AccountState::setBalance(bc::Balance new_balance)
 {
     _balance = new_balance;
+    _was_modified = true;
 }
 
 
 void AccountState::addBalance(bc::Balance delta)
 {
     _balance += delta;
+    _was_modified = true;
 }
 
 
@@ -42,6 +157,7 @@ void AccountState::subBalance(bc::Balance delta)
         throw base::LogicError("trying to take more LK from account than it has");
     }
     _balance -= delta;
+    _was_modified = true;
 }
 
 
@@ -54,22 +170,23 @@ const base::Sha256& AccountState::getCodeHash() const noexcept
 void AccountState::setCodeHash(base::Sha256 code_hash)
 {
     _code_hash = std::move(code_hash);
+    _was_modified = true;
 }
 
 
 bool AccountState::checkStorageValue(const base::Sha256& key) const
 {
-    return _storage.find(key) != _storage.end();
+    return findStorageValue(key) != nullptr;
 }
 
 
 AccountState::StorageData AccountState::getStorageValue(const base::Sha256& key) const
 {
-    if (auto it = _storage.find(key); it == _storage.end()) {
+    if (auto value = findStorageValue(key); !value) {
         RAISE_ERROR(base::LogicError, "value was not found by a given key");
     }
     else {
-        return it->second;
+        return *value;
     }
 }
 
@@ -82,36 +199,87 @@ void AccountState::setStorageValue(const base::Sha256& key, base::Bytes value)
 }
 
 
+AccountState::StorageData* AccountState::findStorageValue(const base::Sha256& key) const
+{
+    if (auto it = _storage.find(key); it != _storage.end()) {
+        return &it->second;
+    }
+    if (!_storage_loader) {
+        return nullptr;
+    }
+    if (auto data = _storage_loader(key); data) {
+        StorageData& sd = _storage[key];
+        sd.data = std::move(*data);
+        return &sd;
+    }
+    return nullptr;
+}
+
+
+void AccountState::serialize(base::SerializationOArchive& oa) const
+{
+    oa.serialize(_nonce);
+    oa.serialize(_balance);
+    oa.serialize(_code_hash);
+}
+
+
+AccountState AccountState::deserialize(base::SerializationIArchive& ia)
+{
+    AccountState state;
+    state._nonce = ia.deserialize<std::uint64_t>();
+    state._balance = ia.deserialize<bc::Balance>();
+    state._code_hash = ia.deserialize<base::Sha256>();
+    return state;
+}
+
+
+AccountManager::AccountManager(base::Database& database,
+                               std::size_t accounts_cache_size,
+                               std::size_t storage_values_cache_size)
+  : _database{ database }
+  , _state_tree{ database }
+  , _accounts_cache_size{ accounts_cache_size }
+  , _storage_values_cache_size{ storage_values_cache_size }
+{}
+
+
 void AccountManager::newAccount(const bc::Address& address, base::Sha256 code_hash)
 {
-    if (hasAccount(address)) {
+    std::lock_guard lk(_states_mutex);
+    if (findAccount(address)) {
         RAISE_ERROR(base::LogicError, "address already exists");
     }
 
-    std::unique_lock lk(_rw_mutex);
     AccountState state;
     state.setCodeHash(std::move(code_hash));
-    _states[address] = std::move(state);
+    insertAccount(address, std::move(state));
 }
 
 
 bool AccountManager::hasAccount(const bc::Address& address) const
 {
-    std::shared_lock lk(_rw_mutex);
-    return _states.find(address) != _states.end();
+    std::lock_guard lk(_states_mutex);
+    return findAccount(address) != nullptr;
 }
 
 
 bool AccountManager::deleteAccount(const bc::Address& address)
 {
-    std::unique_lock lk(_rw_mutex);
-    if (auto it = _states.find(address); it != _states.end()) {
-        _states.erase(it);
-        return true;
-    }
-    else {
+    std::lock_guard lk(_states_mutex);
+    if (!findAccount(address)) {
         return false;
     }
+
+    auto it = _states.find(address);
+    // records of the account are removed from database by the next flush
+    auto& storage_keys = _deleted_addresses[address];
+    for (const auto& [key, value] : it->second.state._storage) {
+        storage_keys.push_back(key);
+    }
+    _lru_addresses.erase(it->second.lru_position);
+    _states.erase(it);
+    return true;
 }
 
 
@@ -130,35 +298,33 @@ bc::Address AccountManager::newContract(const bc::Address& address, base::Sha256
 
 const AccountState& AccountManager::getAccount(const bc::Address& address) const
 {
-    std::shared_lock lk(_rw_mutex);
-    auto it = _states.find(address);
-    if (it == _states.end()) {
+    std::lock_guard lk(_states_mutex);
+    if (auto state = findAccount(address); !state) {
         RAISE_ERROR(base::InvalidArgument, "cannot getAccount for non-existent account");
     }
     else {
-        return it->second;
+        return *state;
     }
 }
 
 
 AccountState& AccountManager::getAccount(const bc::Address& address)
 {
-    std::shared_lock lk(_rw_mutex);
-    auto it = _states.find(address);
-    if (it == _states.end()) {
-        AccountState state; // TODO: lazy creation
-        return _states[address] = state;
+    std::lock_guard lk(_states_mutex);
+    if (auto state = findAccount(address); !state) {
+        return insertAccount(address, AccountState{}); // TODO: lazy creation
     }
     else {
-        return it->second;
+        return *state;
     }
 }
 
 
 bc::Balance AccountManager::getBalance(const bc::Address& account_address) const
 {
-    if (hasAccount(account_address)) {
-        return getAccount(account_address).getBalance();
+    std::lock_guard lk(_states_mutex);
+    if (auto state = findAccount(account_address); state) {
+        return state->getBalance();
     }
     else {
         return 0;
@@ -168,11 +334,13 @@ bc::Balance AccountManager::getBalance(const bc::Address& account_address) const
 
 bool AccountManager::checkTransaction(const bc::Transaction& tx) const
 {
-    std::shared_lock lk(_rw_mutex);
-    if (_states.find(tx.getFrom()) == _states.end()) {
+    std::lock_guard lk(_states_mutex);
+    if (auto state = findAccount(tx.getFrom()); !state) {
         return false;
     }
-    return getAccount(tx.getFrom()).getBalance() >= tx.getAmount();
+    else {
+        return state->getBalance() >= tx.getAmount();
+    }
 }
 
 
@@ -198,24 +366,23 @@ bool AccountManager::tryTransferMoney(const bc::Address& from, const bc::Address
 
 void AccountManager::update(const bc::Transaction& tx)
 {
-    std::unique_lock lk(_rw_mutex);
-    auto from_iter = _states.find(tx.getFrom());
+    std::lock_guard lk(_states_mutex);
+    auto from_state = findAccount(tx.getFrom());
 
-    if (from_iter == _states.end() || from_iter->second.getBalance() < tx.getAmount()) {
+    if (!from_state || from_state->getBalance() < tx.getAmount()) {
         RAISE_ERROR(base::LogicError, "account doesn't have enough funds to perform the operation");
     }
 
-    auto& from_state = from_iter->second;
-    from_state.subBalance(tx.getAmount());
-    if (auto to_iter = _states.find(tx.getTo()); to_iter != _states.end()) {
-        to_iter->second.addBalance(tx.getAmount());
+    from_state->subBalance(tx.getAmount());
+    if (auto to_state = findAccount(tx.getTo()); to_state) {
+        to_state->addBalance(tx.getAmount());
     }
     else {
-        AccountState to_state;
-        to_state.setBalance(tx.getAmount());
-        _states.insert({ tx.getTo(), std::move(to_state) });
+        AccountState new_to_state;
+        new_to_state.setBalance(tx.getAmount());
+        insertAccount(tx.getTo(), std::move(new_to_state));
     }
-    from_state.incNonce();
+    from_state->incNonce();
 }
 
 
@@ -229,30 +396,313 @@ void AccountManager::update(const bc::Block& block)
 
 void AccountManager::updateFromGenesis(const bc::Block& block)
 {
-    std::unique_lock lk(_rw_mutex);
+    std::lock_guard lk(_states_mutex);
     for (const auto& tx : block.getTransactions()) {
         AccountState state;
         state.setBalance(tx.getAmount());
-        _states.insert({ tx.getTo(), std::move(state) });
+        insertAccount(tx.getTo(), std::move(state));
+    }
+}
+
+
+base::Sha256 AccountManager::updateStateRoot()
+{
+    std::lock_guard lk(_states_mutex);
+    return updateStateTree();
+}
+
+
+base::Sha256 AccountManager::flush(base::Database::WriteBatch& batch)
+{
+    std::lock_guard lk(_states_mutex);
+    auto state_root = updateStateTree();
+    batch.append(_unflushed_records);
+    _unflushed_records.clear();
+    _state_tree.flush(batch);
+    _removed_addresses.clear();
+    for (auto& [address, cached] : _states) {
+        // from now on values, that are not in memory, can be read from database
+        cached.state._storage_loader = createStorageLoader(address);
+    }
+    return state_root;
+}
+
+
+void AccountManager::shrink()
+{
+    std::lock_guard lk(_states_mutex);
+    std::size_t storage_values_count = 0;
+    for (const auto& [address, cached] : _states) {
+        storage_values_count += cached.state._storage.size();
+    }
+
+    while (!_lru_addresses.empty() &&
+           (_states.size() > _accounts_cache_size || storage_values_count > _storage_values_cache_size)) {
+        auto it = _states.find(_lru_addresses.back());
+        storage_values_count -= it->second.state._storage.size();
+        _states.erase(it);
+        _lru_addresses.pop_back();
+    }
+}
+
+
+void AccountManager::clear()
+{
+    std::lock_guard lk(_states_mutex);
+    base::Database::WriteBatch batch;
+    for (const auto& prefix : { ACCOUNTS_PREFIX, STORAGE_VALUES_PREFIX }) {
+        for (auto it = _database.createIterator(prefix); it.isValid(); it.next()) {
+            batch.remove(it.key());
+        }
+    }
+    _database.write(batch);
+    _state_tree.clear();
+
+    _states.clear();
+    _lru_addresses.clear();
+    _deleted_addresses.clear();
+    _removed_addresses.clear();
+    _unflushed_records.clear();
+}
+
+
+base::Sha256 AccountManager::getStateRoot() const
+{
+    std::lock_guard lk(_states_mutex);
+    return _state_tree.getRoot();
+}
+
+
+base::Sha256 AccountManager::rebuildStateTree(base::Database::WriteBatch& batch)
+{
+    std::lock_guard lk(_states_mutex);
+    LeavesHasher leaves;
+    for (auto it = _database.createIterator(ACCOUNTS_PREFIX); it.isValid(); it.next()) {
+        auto key = it.key();
+        bc::Address address{ key.takePart(ACCOUNTS_PREFIX.size(), key.size()) };
+        leaves.add(toAccountLeafKeyData(address), it.value());
+    }
+    for (auto it = _database.createIterator(STORAGE_VALUES_PREFIX); it.isValid(); it.next()) {
+        auto key = it.key();
+        auto address_end = STORAGE_VALUES_PREFIX.size() + bc::Address::ADDRESS_BYTES_LENGTH;
+        bc::Address address{ key.takePart(STORAGE_VALUES_PREFIX.size(), address_end) };
+        base::Sha256 storage_key{ key.takePart(address_end, key.size()) };
+        leaves.add(toStorageLeafKeyData(address, storage_key), it.value());
     }
+    StateTree::Changes changes;
+    leaves.hashTo(changes);
+
+    _state_tree.clear();
+    _state_tree.update(changes);
+    _state_tree.flush(batch);
+    return _state_tree.getRoot();
 }
 
 
-std::optional<std::reference_wrapper<const base::Bytes>> CodeManager::getCode(const base::Sha256& hash) const
+base::Sha256 AccountManager::updateStateTree()
 {
-    if (auto it = _code_db.find(hash); it == _code_db.end()) {
-        return std::nullopt;
+    StateTree::Changes changes;
+    // removals go first, so an account created again at a deleted address gets a clean storage
+    for (const auto& [address, storage_keys] : _deleted_addresses) {
+        _unflushed_records.remove(toAccountKey(address));
+        changes[toAccountLeafKey(address)] = std::nullopt;
+        for (const auto& storage_key : storage_keys) {
+            _unflushed_records.remove(toStorageKey(address, storage_key));
+            changes[toStorageLeafKey(address, storage_key)] = std::nullopt;
+        }
+        for (auto it = _database.createIterator(toStorageKeysPrefix(address)); it.isValid(); it.next()) {
+            auto key = it.key();
+            _unflushed_records.remove(key);
+            base::Sha256 storage_key{ key.takePart(key.size() - base::Sha256::SHA256_SIZE, key.size()) };
+            changes[toStorageLeafKey(address, storage_key)] = std::nullopt;
+        }
+        _removed_addresses.insert(address);
+    }
+    _deleted_addresses.clear();
+
+    LeavesHasher updated_leaves;
+    for (auto& [address, cached] : _states) {
+        auto& state = cached.state;
+        if (state._was_modified) {
+            auto data = base::toBytes(state);
+            _unflushed_records.put(toAccountKey(address), data);
+            updated_leaves.add(toAccountLeafKeyData(address), std::move(data));
+            state._was_modified = false;
+        }
+        for (auto& [key, value] : state._storage) {
+            if (value.was_modified) {
+                _unflushed_records.put(toStorageKey(address, key), value.data);
+                updated_leaves.add(toStorageLeafKeyData(address, key), value.data);
+                value.was_modified = false;
+            }
+        }
+    }
+    updated_leaves.hashTo(changes);
+
+    _state_tree.update(changes);
+    return _state_tree.getRoot();
+}
+
+
+AccountState* AccountManager::findAccount(const bc::Address& address) const
+{
+    if (auto it = _states.find(address); it != _states.end()) {
+        _lru_addresses.splice(_lru_addresses.begin(), _lru_addresses, it->second.lru_position);
+        return &it->second.state;
+    }
+    else if (_deleted_addresses.find(address) != _deleted_addresses.end() ||
+             _removed_addresses.find(address) != _removed_addresses.end()) {
+        return nullptr;
+    }
+    else if (auto data = _database.get(toAccountKey(address)); data) {
+        auto state = base::fromBytes<AccountState>(*data);
+        state._storage_loader = createStorageLoader(address);
+        return &insertAccount(address, std::move(state));
     }
     else {
+        return nullptr;
+    }
+}
+
+
+AccountState& AccountManager::insertAccount(const bc::Address& address, AccountState state) const
+{
+    // accounts, that are not in database yet, are written by the next flush
+    if (!state._storage_loader) {
+        state._was_modified = true;
+    }
+    _lru_addresses.push_front(address);
+    auto& cached = _states[address];
+    cached.state = std::move(state);
+    cached.lru_position = _lru_addresses.begin();
+    return cached.state;
+}
+
+
+AccountState::StorageLoader AccountManager::createStorageLoader(const bc::Address& address) const
+{
+    return [this, address](const base::Sha256& key) { return _database.get(toStorageKey(address, key)); };
+}
+
+
+CodeManager::CodeManager(base::Database& database, std::size_t codes_cache_size)
+  : _database{ database }
+  , _recent_codes{ codes_cache_size }
+{}
+
+
+std::shared_ptr<const base::Bytes> CodeManager::getCode(const base::Sha256& hash) const
+{
+    std::lock_guard lk(_codes_mutex);
+    if (auto it = _pending_codes.find(hash); it != _pending_codes.end()) {
         return it->second;
     }
+    if (auto code = _recent_codes.find(hash); code) {
+        return code->get();
+    }
+    if (auto data = _database.get(toCodeKey(hash)); data) {
+        auto code = std::make_shared<const base::Bytes>(std::move(*data));
+        _recent_codes.put(hash, code);
+        return code;
+    }
+    return nullptr;
 }
 
 
 void CodeManager::saveCode(base::Bytes code)
 {
     auto hash = base::Sha256::compute(code);
-    _code_db.insert({ std::move(hash), std::move(code) });
+    std::lock_guard lk(_codes_mutex);
+    if (_pending_codes.find(hash) != _pending_codes.end() || _recent_codes.find(hash) ||
+        _database.exists(toCodeKey(hash))) {
+        return;
+    }
+    _pending_codes.insert({ std::move(hash), std::make_shared<const base::Bytes>(std::move(code)) });
+}
+
+
+void CodeManager::flush(base::Database::WriteBatch& batch)
+{
+    std::lock_guard lk(_codes_mutex);
+    for (auto& [hash, code] : _pending_codes) {
+        batch.put(toCodeKey(hash), *code);
+        _recent_codes.put(hash, std::move(code));
+    }
+    _pending_codes.clear();
+}
+
+
+void CodeManager::clear()
+{
+    std::lock_guard lk(_codes_mutex);
+    base::Database::WriteBatch batch;
+    for (auto it = _database.createIterator(CODES_PREFIX); it.isValid(); it.next()) {
+        batch.remove(it.key());
+    }
+    _database.write(batch);
+
+    _pending_codes.clear();
+    _recent_codes.clear();
+}
+
+
+OutputManager::OutputManager(base::Database& database, std::size_t outputs_cache_size, std::size_t retention_depth)
+  : _database{ database }
+  , _retention_depth{ retention_depth }
+  , _recent_outputs{ outputs_cache_size }
+{}
+
+
+std::optional<base::Bytes> OutputManager::getOutput(const base::Sha256& tx_hash) const
+{
+    std::lock_guard lk(_outputs_mutex);
+    if (auto it = _pending_outputs.find(tx_hash); it != _pending_outputs.end()) {
+        return it->second.output;
+    }
+    if (auto output = _recent_outputs.find(tx_hash); output) {
+        return output->get();
+    }
+    if (auto data = _database.get(toOutputKey(tx_hash)); data) {
+        _recent_outputs.put(tx_hash, *data);
+        return data;
+    }
+    return std::nullopt;
+}
+
+
+void OutputManager::saveOutput(const base::Sha256& tx_hash, bc::BlockDepth depth, base::Bytes output)
+{
+    std::lock_guard lk(_outputs_mutex);
+    _pending_outputs[tx_hash] = PendingOutput{ depth, std::move(output) };
+}
+
+
+void OutputManager::flush(base::Database::WriteBatch& batch, bc::BlockDepth top_depth)
+{
+    std::lock_guard lk(_outputs_mutex);
+    for (auto& [tx_hash, pending] : _pending_outputs) {
+        batch.put(toOutputKey(tx_hash), pending.output);
+        batch.put(toOutputByDepthKey(pending.depth, tx_hash), base::Bytes{});
+        _recent_outputs.put(tx_hash, std::move(pending.output));
+    }
+    _pending_outputs.clear();
+
+    if (_retention_depth == 0 || top_depth < _retention_depth) {
+        return;
+    }
+    const auto last_expired_depth = top_depth - _retention_depth;
+    for (auto it = _database.createIterator(OUTPUTS_BY_DEPTH_PREFIX); it.isValid(); it.next()) {
+        auto key = it.key();
+        auto hash_begin = key.size() - base::Sha256::SHA256_SIZE;
+        if (base::fromBytes<bc::BlockDepth>(key.takePart(OUTPUTS_BY_DEPTH_PREFIX.size(), hash_begin)) >
+            last_expired_depth) {
+            break;
+        }
+        base::Sha256 tx_hash{ key.takePart(hash_begin, key.size()) };
+        batch.remove(toOutputKey(tx_hash));
+        batch.remove(key);
+        _recent_outputs.erase(tx_hash);
+    }
 }
 
 } // namespace lk
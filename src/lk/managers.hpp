@@ -1,10 +1,18 @@
 #pragma once
 
+#include "base/database.hpp"
+#include "base/utility.hpp"
 #include "bc/block.hpp"
 #include "bc/transaction.hpp"
+#include "lk/state_tree.hpp"
 
+#include <functional>
+#include <list>
 #include <map>
-#include <shared_mutex>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
 
 
 namespace lk
@@ -23,6 +31,9 @@ class AccountState
         bool was_modified{ false };
     };
     //============================
+    // used to read storage values, that are not in memory yet, from persistent storage
+    using StorageLoader = std::function<std::optional<base::Bytes>(const base::Sha256& key)>;
+    //============================
     std::uint64_t getNonce() const noexcept;
     void incNonce() noexcept;
     //============================
@@ -38,19 +49,36 @@ class AccountState
     StorageData getStorageValue(const base::Sha256& key) const;
     void setStorageValue(const base::Sha256& key, base::Bytes value);
     //============================
+    // storage values are not serialized: they are stored as separate records, see AccountManager
+    void serialize(base::SerializationOArchive& oa) const;
+    static AccountState deserialize(base::SerializationIArchive& ia);
+    //============================
   private:
+    friend class AccountManager;
+    //============================
     std::uint64_t _nonce{ 0 };
     bc::Balance _balance{ 0 };
     base::Sha256 _code_hash{ base::Sha256::null() };
-    std::map<base::Sha256, StorageData> _storage;
+    bool _was_modified{ false };
+    // only values, that were used since the account was loaded, are here
+    mutable std::map<base::Sha256, StorageData> _storage;
+    StorageLoader _storage_loader;
+    //============================
+    StorageData* findStorageValue(const base::Sha256& key) const;
 };
 
 
+/**
+ *  @brief Accounts and storage values of contracts, that are kept in a database.
+ *
+ *  Only recently used accounts are kept in memory. Accounts are dropped out of memory only by shrink,
+ *  so references returned by getAccount are valid until the next shrink.
+ */
 class AccountManager
 {
   public:
     //================
-    AccountManager() = default;
+    AccountManager(base::Database& database, std::size_t accounts_cache_size, std::size_t storage_values_cache_size);
     AccountManager(const AccountManager& hash) = delete;
     AccountManager(AccountManager&& hash) = delete;
 
@@ -76,23 +104,114 @@ class AccountManager
     //================
     bc::Balance getBalance(const bc::Address& account) const;
     //================
+    // puts accounts, that were modified since the previous update, to the state tree and returns the new state root;
+    // records of the accounts and changed tree nodes are kept in memory until flush
+    base::Sha256 updateStateRoot();
+    // adds records of modified accounts and of changed state tree nodes to the batch, returns the new state root
+    base::Sha256 flush(base::Database::WriteBatch& batch);
+    // drops least recently used accounts out of memory, must be called after the batch of flush is written
+    void shrink();
+    // removes all accounts from memory and database
+    void clear();
+    //================
+    // root of the state tree over all accounts and storage values as of the last update or flush
+    base::Sha256 getStateRoot() const;
+    // builds the state tree anew from accounts and storage values on disk, that were written bypassing flush
+    base::Sha256 rebuildStateTree(base::Database::WriteBatch& batch);
     //================
   private:
     //================
-    std::map<bc::Address, AccountState> _states;
-    mutable std::shared_mutex _rw_mutex;
+    struct CachedAccount
+    {
+        AccountState state;
+        std::list<bc::Address>::iterator lru_position;
+    };
+    //================
+    base::Database& _database;
+    StateTree _state_tree;
+    const std::size_t _accounts_cache_size;
+    const std::size_t _storage_values_cache_size;
+    //================
+    mutable std::map<bc::Address, CachedAccount> _states;
+    mutable std::list<bc::Address> _lru_addresses; // the most recently used address is the first one
+    // deleted account -> keys of its storage values, that were in memory: some of them may be not in database yet
+    std::map<bc::Address, std::vector<base::Sha256>> _deleted_addresses;
+    // records of accounts, that were deleted since the previous flush, are still in database
+    std::set<bc::Address> _removed_addresses;
+    // records of accounts, that were put to the state tree since the previous flush
+    base::Database::WriteBatch _unflushed_records;
+    mutable std::mutex _states_mutex;
+    //================
+    // must be called under the states mutex
+    base::Sha256 updateStateTree();
+    AccountState* findAccount(const bc::Address& address) const;
+    AccountState& insertAccount(const bc::Address& address, AccountState state) const;
+    AccountState::StorageLoader createStorageLoader(const bc::Address& address) const;
     //================
 };
 
 
+/**
+ *  @brief Codes of contracts, that are kept in a database by their hashes.
+ *
+ *  Only recently used codes are kept in memory. Returned codes are shared, so they stay valid after eviction.
+ */
 class CodeManager
 {
   public:
-    std::optional<std::reference_wrapper<const base::Bytes>> getCode(const base::Sha256& hash) const;
+    CodeManager(base::Database& database, std::size_t codes_cache_size);
+
+    // returns nullptr if there is no code with a given hash
+    std::shared_ptr<const base::Bytes> getCode(const base::Sha256& hash) const;
+    // saving the same code twice stores it once
     void saveCode(base::Bytes code);
 
+    // adds records of codes, that were saved since the previous flush, to the batch
+    void flush(base::Database::WriteBatch& batch);
+    // removes all codes from memory and database
+    void clear();
+
   private:
-    std::map<base::Sha256, base::Bytes> _code_db;
+    base::Database& _database;
+    // codes are not written to database until flush
+    std::map<base::Sha256, std::shared_ptr<const base::Bytes>> _pending_codes;
+    mutable base::LruCache<base::Sha256, std::shared_ptr<const base::Bytes>> _recent_codes;
+    mutable std::mutex _codes_mutex;
+};
+
+
+/**
+ *  @brief Outputs of executed transactions, that are kept in a database by hashes of transactions.
+ *
+ *  Only recent outputs are kept in memory. Outputs of blocks, that are deeper than the retention depth
+ *  under the top block, are removed from database.
+ */
+class OutputManager
+{
+  public:
+    // zero retention depth keeps outputs of all blocks
+    OutputManager(base::Database& database, std::size_t outputs_cache_size, std::size_t retention_depth);
+
+    // returns std::nullopt if there is no output of a given transaction
+    std::optional<base::Bytes> getOutput(const base::Sha256& tx_hash) const;
+    void saveOutput(const base::Sha256& tx_hash, bc::BlockDepth depth, base::Bytes output);
+
+    // adds records of outputs, that were saved since the previous flush, and removals of expired outputs to the batch
+    void flush(base::Database::WriteBatch& batch, bc::BlockDepth top_depth);
+
+  private:
+    struct PendingOutput
+    {
+        bc::BlockDepth depth;
+        base::Bytes output;
+    };
+
+    base::Database& _database;
+    const std::size_t _retention_depth;
+    // outputs are not written to database until flush
+    std::map<base::Sha256, PendingOutput> _pending_outputs;
+    mutable base::LruCache<base::Sha256, base::Bytes> _recent_outputs;
+    mutable std::mutex _outputs_mutex;
 };
 
 
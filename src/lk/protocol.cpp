@@ -7,16 +7,47 @@
 namespace
 {
 
+// a message in the compact encoding is marked, so it's decoded right regardless of the state of a receiving peer
 template<typename M, typename... Args>
-base::Bytes serializeMessage(Args&&... args)
+base::Bytes serializeMessage(base::IntegerEncoding encoding, Args&&... args)
 {
     LOG_TRACE << lk::enumToString(M::getHandledMessageType());
-    base::SerializationOArchive oa;
+    base::SerializationOArchive counter{ base::SerializationOArchive::Mode::COUNT, encoding };
+    if (encoding == base::IntegerEncoding::COMPACT) {
+        counter.serialize(lk::MessageType::COMPACT_ENCODED);
+    }
+    counter.serialize(M::getHandledMessageType());
+    (counter.serialize(args), ...);
+
+    base::SerializationOArchive oa{ base::SerializationOArchive::Mode::WRITE, encoding };
+    oa.reserve(counter.size());
+    if (encoding == base::IntegerEncoding::COMPACT) {
+        oa.serialize(lk::MessageType::COMPACT_ENCODED);
+    }
     oa.serialize(M::getHandledMessageType());
     (oa.serialize(std::forward<Args>(args)), ...);
     return std::move(oa).getBytes();
 }
 
+
+// the compact encoding is used by default, it's turned on only with peers that support it
+base::IntegerEncoding calcIntegerEncoding(const base::PropertyTree& config)
+{
+    if (!config.hasKey("net.integer_encoding")) {
+        return base::IntegerEncoding::COMPACT;
+    }
+    auto encoding = config.get<std::string>("net.integer_encoding");
+    if (encoding == "fixed") {
+        return base::IntegerEncoding::FIXED;
+    }
+    else if (encoding == "compact") {
+        return base::IntegerEncoding::COMPACT;
+    }
+    else {
+        RAISE_ERROR(base::InvalidArgument, std::string{ "unknown net.integer_encoding: " } + encoding);
+    }
+}
+
 } // namespace
 
 
@@ -51,19 +82,21 @@ void HandshakeMessage::serialize(base::SerializationOArchive& oa,
                                  const bc::Block& block,
                                  const bc::Address& address,
                                  std::uint16_t public_port,
-                                 const std::vector<PeerInfo>& known_peers)
+                                 const std::vector<PeerInfo>& known_peers,
+                                 base::IntegerEncoding integer_encoding)
 {
     oa.serialize(MessageType::HANDSHAKE);
     oa.serialize(block);
     oa.serialize(address);
     oa.serialize(public_port);
     oa.serialize(known_peers);
+    oa.serialize(integer_encoding);
 }
 
 
 void HandshakeMessage::serialize(base::SerializationOArchive& oa) const
 {
-    serialize(oa, _theirs_top_block, _address, _public_port, _known_peers);
+    serialize(oa, _theirs_top_block, _address, _public_port, _known_peers, _integer_encoding);
 }
 
 
@@ -73,13 +106,19 @@ HandshakeMessage HandshakeMessage::deserialize(base::SerializationIArchive& ia)
     auto address = ia.deserialize<bc::Address>();
     auto public_port = ia.deserialize<std::uint16_t>();
     auto known_peers = ia.deserialize<std::vector<PeerInfo>>();
-    return HandshakeMessage(std::move(top_block), std::move(address), public_port, std::move(known_peers));
+    // nodes, that don't send it, know only the fixed encoding
+    auto integer_encoding =
+      ia.getRemainingSize() ? ia.deserialize<base::IntegerEncoding>() : base::IntegerEncoding::FIXED;
+    return HandshakeMessage(
+      std::move(top_block), std::move(address), public_port, std::move(known_peers), integer_encoding);
 }
 
 
 void HandshakeMessage::handle(Peer& peer, Network& network, Core& core)
 {
-    const auto& ours_top_block = core.getTopBlock();
+    auto ours_top_block = core.getTopBlock();
+
+    peer.setEncoding(std::min(_integer_encoding, network.getIntegerEncoding()));
 
     if (auto ep = peer.getPublicEndpoint(); !ep && _public_port) {
         auto public_ep = peer.getEndpoint();
@@ -91,19 +130,19 @@ void HandshakeMessage::handle(Peer& peer, Network& network, Core& core)
         network.checkOutNode(peer_info.endpoint, peer_info.address);
     }
 
-    if (_theirs_top_block == ours_top_block) {
+    if (_theirs_top_block == *ours_top_block) {
         peer.setState(Peer::State::SYNCHRONISED);
         return; // nothing changes, because top blocks are equal
     }
     else {
-        if (ours_top_block.getDepth() > _theirs_top_block.getDepth()) {
+        if (ours_top_block->getDepth() > _theirs_top_block.getDepth()) {
             peer.setState(Peer::State::SYNCHRONISED);
             // do nothing, because we are ahead of this peer and we don't need to sync: this node might sync
             return;
         }
         else {
-            if (core.getTopBlock().getDepth() + 1 == _theirs_top_block.getDepth()) {
-                core.tryAddBlock(_theirs_top_block);
+            if (core.getTopBlock()->getDepth() + 1 == _theirs_top_block.getDepth()) {
+                core.tryAddBlock(std::make_shared<const bc::Block>(std::move(_theirs_top_block)));
                 peer.setState(Peer::State::SYNCHRONISED);
             }
             else {
@@ -111,7 +150,7 @@ void HandshakeMessage::handle(Peer& peer, Network& network, Core& core)
                 GetBlockMessage::serialize(oa, _theirs_top_block.getPrevBlockHash());
                 peer.send(std::move(oa).getBytes());
                 peer.setState(Peer::State::REQUESTED_BLOCKS);
-                peer.addSyncBlock(std::move(_theirs_top_block));
+                peer.addSyncBlock(std::make_shared<const bc::Block>(std::move(_theirs_top_block)));
             }
         }
     }
@@ -121,11 +160,13 @@ void HandshakeMessage::handle(Peer& peer, Network& network, Core& core)
 HandshakeMessage::HandshakeMessage(bc::Block&& top_block,
                                    bc::Address address,
                                    std::uint16_t public_port,
-                                   std::vector<PeerInfo>&& known_peers)
+                                   std::vector<PeerInfo>&& known_peers,
+                                   base::IntegerEncoding integer_encoding)
   : _theirs_top_block{ std::move(top_block) }
   , _address{ std::move(address) }
   , _public_port{ public_port }
   , _known_peers{ std::move(known_peers) }
+  , _integer_encoding{ integer_encoding }
 {}
 
 //============================================
@@ -243,10 +284,10 @@ void GetBlockMessage::handle(Peer& peer, Network& network, Core& core)
 {
     auto block = core.findBlock(_block_hash);
     if (block) {
-        peer.send(serializeMessage<BlockMessage>(*block));
+        peer.send(serializeMessage<BlockMessage>(peer.getEncoding(), *block));
     }
     else {
-        peer.send(serializeMessage<BlockNotFoundMessage>(_block_hash));
+        peer.send(serializeMessage<BlockNotFoundMessage>(peer.getEncoding(), _block_hash));
     }
 }
 
@@ -286,17 +327,18 @@ BlockMessage BlockMessage::deserialize(base::SerializationIArchive& ia)
 void BlockMessage::handle(Peer& peer, Network& network, Core& core)
 {
     if (peer.getState() == Peer::State::SYNCHRONISED) {
-        core.tryAddBlock(std::move(_block));
+        core.tryAddBlock(std::make_shared<const bc::Block>(std::move(_block)));
     }
     else {
         bc::BlockDepth block_depth = _block.getDepth();
-        peer.addSyncBlock(std::move(_block));
+        peer.addSyncBlock(std::make_shared<const bc::Block>(std::move(_block)));
 
-        if (block_depth == core.getTopBlock().getDepth() + 1) {
+        if (block_depth == core.getTopBlock()->getDepth() + 1) {
             peer.applySyncs();
         }
         else {
-            peer.send(serializeMessage<GetBlockMessage>(peer.getSyncBlocks().front().getPrevBlockHash()));
+            peer.send(
+              serializeMessage<GetBlockMessage>(peer.getEncoding(), peer.getSyncBlocks().front()->getPrevBlockHash()));
         }
     }
 }
@@ -363,7 +405,7 @@ GetInfoMessage GetInfoMessage::deserialize(base::SerializationIArchive& ia)
 
 void GetInfoMessage::handle(Peer& peer, Network& network, Core& core)
 {
-    peer.send(serializeMessage<InfoMessage>(core.getTopBlock(), network.allConnectedPeersInfo()));
+    peer.send(serializeMessage<InfoMessage>(peer.getEncoding(), *core.getTopBlock(), network.allConnectedPeersInfo()));
 }
 
 //============================================
@@ -441,7 +483,7 @@ NewNodeMessage NewNodeMessage::deserialize(base::SerializationIArchive& ia)
 void NewNodeMessage::handle(Peer& peer, Network& network, Core& core)
 {
     if (network.checkOutNode(_new_node_endpoint, _address)) {
-        network.broadcast(serializeMessage<NewNodeMessage>(_new_node_endpoint));
+        network.broadcast(serializeMessage<NewNodeMessage>(base::IntegerEncoding::FIXED, _new_node_endpoint));
     }
 }
 
@@ -493,10 +535,14 @@ void runHandle(MessageType mt,
 } // namespace
 
 
-void MessageProcessor::process(const base::Bytes& raw_message)
+void MessageProcessor::process(const base::SharedBytes& raw_message)
 {
     base::SerializationIArchive ia(raw_message);
     auto mt = ia.deserialize<MessageType>();
+    if (mt == MessageType::COMPACT_ENCODED) {
+        ia.setEncoding(base::IntegerEncoding::COMPACT);
+        mt = ia.deserialize<MessageType>();
+    }
     LOG_DEBUG << "Processing " << enumToString(mt) << " message";
     runHandle(mt, ia, _peer, _network, _core, _all_message_types);
     LOG_DEBUG << "Processed  " << enumToString(mt) << " message";
@@ -515,7 +561,7 @@ Peer::Handler::Handler(Peer& owning_peer, Network& owning_network_object, net::S
 }
 
 
-void Peer::Handler::onReceive(const base::Bytes& data)
+void Peer::Handler::onReceive(const base::SharedBytes& data)
 {
     if (_session.isClosed()) {
         return;
@@ -568,10 +614,20 @@ void Peer::setServerEndpoint(net::Endpoint endpoint)
 
 void Peer::doHandshake()
 {
-    base::SerializationOArchive oa;
     std::uint16_t public_port = _owning_network_object._public_port ? *_owning_network_object._public_port : 0;
     auto connected_peers_info = _owning_network_object.allConnectedPeersInfo();
-    HandshakeMessage::serialize(oa, _core.getTopBlock(), _core.getThisNodeAddress(), public_port, connected_peers_info);
+    // kept by a pointer, so both passes see the same block
+    const auto top_block = _core.getTopBlock();
+    // the handshake is always in the fixed encoding, since nothing is known about the peer yet
+    auto integer_encoding = _owning_network_object.getIntegerEncoding();
+    base::SerializationOArchive counter{ base::SerializationOArchive::Mode::COUNT };
+    HandshakeMessage::serialize(
+      counter, *top_block, _core.getThisNodeAddress(), public_port, connected_peers_info, integer_encoding);
+
+    base::SerializationOArchive oa;
+    oa.reserve(counter.size());
+    HandshakeMessage::serialize(
+      oa, *top_block, _core.getThisNodeAddress(), public_port, connected_peers_info, integer_encoding);
     _session.send(std::move(oa).getBytes());
 }
 
@@ -588,7 +644,19 @@ Peer::State Peer::getState() const noexcept
 }
 
 
-void Peer::addSyncBlock(bc::Block block)
+base::IntegerEncoding Peer::getEncoding() const noexcept
+{
+    return _encoding;
+}
+
+
+void Peer::setEncoding(base::IntegerEncoding encoding) noexcept
+{
+    _encoding = encoding;
+}
+
+
+void Peer::addSyncBlock(std::shared_ptr<const bc::Block> block)
 {
     _sync_blocks.push_front(std::move(block));
 }
@@ -605,7 +673,7 @@ bool Peer::applySyncs()
 }
 
 
-const std::forward_list<bc::Block>& Peer::getSyncBlocks() const noexcept
+const std::forward_list<std::shared_ptr<const bc::Block>>& Peer::getSyncBlocks() const noexcept
 {
     return _sync_blocks;
 }
@@ -656,6 +724,7 @@ Network::Network(const base::PropertyTree& config, Core& core)
   : _config{ config }
   , _host{ _config, 0x42 } // TODO: change later
   , _core{ core }
+  , _integer_encoding{ calcIntegerEncoding(config) }
 {
     if (_config.hasKey("net.public_port")) {
         _public_port = _config.get<std::uint16_t>("net.public_port");
@@ -713,6 +782,12 @@ bool Network::checkOutNode(const net::Endpoint& endpoint, const bc::Address& add
 }
 
 
+base::IntegerEncoding Network::getIntegerEncoding() const noexcept
+{
+    return _integer_encoding;
+}
+
+
 void Network::broadcast(const base::Bytes& data)
 {
     LOG_DEBUG << "Broadcasting data size = " << data.size();
@@ -722,13 +797,13 @@ void Network::broadcast(const base::Bytes& data)
 
 void Network::onNewBlock(const bc::Block& block)
 {
-    broadcast(serializeMessage<BlockMessage>(block));
+    broadcast(serializeMessage<BlockMessage>(base::IntegerEncoding::FIXED, block));
 }
 
 
 void Network::onNewPendingTransaction(const bc::Transaction& tx)
 {
-    broadcast(serializeMessage<TransactionMessage>(tx));
+    broadcast(serializeMessage<TransactionMessage>(base::IntegerEncoding::FIXED, tx));
 }
 
 
@@ -29,6 +29,7 @@ namespace lk
                                                       (GET_INFO)
                                                       (INFO)
                                                       (NEW_NODE)
+                                                      (COMPACT_ENCODED)
     )
 // clang-format on
 
@@ -56,7 +57,8 @@ class HandshakeMessage
                           const bc::Block& block,
                           const bc::Address& address,
                           std::uint16_t public_port,
-                          const std::vector<PeerInfo>& known_peers);
+                          const std::vector<PeerInfo>& known_peers,
+                          base::IntegerEncoding integer_encoding);
     void serialize(base::SerializationOArchive& oa) const;
     static HandshakeMessage deserialize(base::SerializationIArchive& ia);
     void handle(Peer& peer, Network& network, Core& core);
@@ -67,11 +69,14 @@ class HandshakeMessage
     std::uint16_t
       _public_port; // zero public port states that peer didn't provide information about his public endpoint
     std::vector<PeerInfo> _known_peers;
+    // the newest integer encoding the peer understands, it goes last, so older nodes just don't read it
+    base::IntegerEncoding _integer_encoding;
 
     HandshakeMessage(bc::Block&& top_block,
                      bc::Address address,
                      std::uint16_t public_port,
-                     std::vector<PeerInfo>&& known_peers);
+                     std::vector<PeerInfo>&& known_peers,
+                     base::IntegerEncoding integer_encoding);
 };
 
 
@@ -230,7 +235,8 @@ class MessageProcessor
   public:
     MessageProcessor(Peer& peer, Network& network, Core& core);
 
-    void process(const base::Bytes& raw_message);
+    // decoded messages can keep parts of the raw message without copying them
+    void process(const base::SharedBytes& raw_message);
 
   private:
     static const base::TypeList<HandshakeMessage,
@@ -276,9 +282,13 @@ class Peer
     void setState(State new_state);
     State getState() const noexcept;
     //================
-    void addSyncBlock(bc::Block block);
+    // messages to the peer are sent in this encoding, it's agreed on in the handshake
+    base::IntegerEncoding getEncoding() const noexcept;
+    void setEncoding(base::IntegerEncoding encoding) noexcept;
+    //================
+    void addSyncBlock(std::shared_ptr<const bc::Block> block);
     bool applySyncs();
-    const std::forward_list<bc::Block>& getSyncBlocks() const noexcept;
+    const std::forward_list<std::shared_ptr<const bc::Block>>& getSyncBlocks() const noexcept;
     //================
     [[nodiscard]] std::unique_ptr<net::Session::Handler> createHandler();
     //================
@@ -294,7 +304,7 @@ class Peer
         Handler(Peer& owning_peer, Network& owning_network_object, net::Session& handled_session, Core& core);
         ~Handler() override = default;
         //================
-        void onReceive(const base::Bytes& data) override;
+        void onReceive(const base::SharedBytes& data) override;
         // virtual void onSend() = 0;
         void onClose() override;
         //================
@@ -318,8 +328,9 @@ class Peer
     State _state{ State::JUST_ESTABLISHED };
     std::optional<net::Endpoint> _endpoint_for_incoming_connections;
     std::optional<bc::Address> _address;
+    base::IntegerEncoding _encoding{ base::IntegerEncoding::FIXED };
     //================
-    std::forward_list<bc::Block> _sync_blocks;
+    std::forward_list<std::shared_ptr<const bc::Block>> _sync_blocks;
     //================
 };
 
@@ -335,6 +346,10 @@ class Network
     [[nodiscard]] std::vector<PeerInfo> allConnectedPeersInfo() const;
     bool checkOutNode(const net::Endpoint& endpoint, const bc::Address& address);
     //================
+    // the newest integer encoding this node uses with peers, that support it too
+    base::IntegerEncoding getIntegerEncoding() const noexcept;
+    //================
+    // broadcasted messages are serialized once for all peers, so they go in the fixed encoding
     void broadcast(const base::Bytes& data);
     //================
   private:
@@ -363,6 +378,7 @@ class Network
     Core& _core;
     //================
     std::optional<std::uint16_t> _public_port;
+    base::IntegerEncoding _integer_encoding;
     //================
     Peer& createPeer(net::Session& session);
     void removePeer(const Peer& peer);
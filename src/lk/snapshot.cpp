@@ -0,0 +1,461 @@
+#include "snapshot.hpp"
+
+#include "base/config.hpp"
+#include "base/error.hpp"
+#include "base/log.hpp"
+#include "bc/blockchain.hpp"
+#include "bc/database_keys.hpp"
+#include "lk/core.hpp"
+#include "lk/managers.hpp"
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <initializer_list>
+#include <thread>
+
+namespace
+{
+
+const base::Bytes SNAPSHOT_MAGIC{ "LKSNAPSHOT" };
+
+constexpr std::uint32_t SNAPSHOT_FORMAT_VERSION = 1;
+
+// only records of these types are taken from a snapshot, so it can't overwrite anything else in a database
+constexpr std::array STATE_DATA_TYPES{ bc::DataType::ACCOUNT,
+                                       bc::DataType::ACCOUNT_STORAGE,
+                                       bc::DataType::CONTRACT_CODE,
+                                       bc::DataType::TRANSACTION_OUTPUT,
+                                       bc::DataType::TRANSACTION_OUTPUT_BY_DEPTH };
+
+
+enum class ChunkType : base::Byte
+{
+    HEADER = 0,
+    BLOCKS = 1,
+    STATE = 2,
+    END = 3
+};
+
+
+struct Header
+{
+    std::uint32_t version;
+    bc::BlockDepth top_depth;
+    base::Sha256 top_hash;
+    base::Sha256 state_root;
+
+    void serialize(base::SerializationOArchive& oa) const
+    {
+        oa.serialize(version);
+        oa.serialize(top_depth);
+        oa.serialize(top_hash);
+        oa.serialize(state_root);
+    }
+
+    static Header deserialize(base::SerializationIArchive& ia)
+    {
+        auto version = ia.deserialize<std::uint32_t>();
+        auto top_depth = ia.deserialize<bc::BlockDepth>();
+        auto top_hash = ia.deserialize<base::Sha256>();
+        auto state_root = ia.deserialize<base::Sha256>();
+        return Header{ version, top_depth, std::move(top_hash), std::move(state_root) };
+    }
+};
+
+
+struct End
+{
+    std::uint64_t blocks_count{ 0 };
+    std::uint64_t records_count{ 0 };
+
+    void serialize(base::SerializationOArchive& oa) const
+    {
+        oa.serialize(blocks_count);
+        oa.serialize(records_count);
+    }
+
+    static End deserialize(base::SerializationIArchive& ia)
+    {
+        End end;
+        end.blocks_count = ia.deserialize<std::uint64_t>();
+        end.records_count = ia.deserialize<std::uint64_t>();
+        return end;
+    }
+};
+
+
+// every chunk is [type][size of payload][payload][sha256 of payload]
+class ChunkWriter
+{
+  public:
+    explicit ChunkWriter(const std::filesystem::path& path)
+      : _path{ path }
+      , _file{ path, std::ios::binary | std::ios::trunc }
+    {
+        writeBytes(SNAPSHOT_MAGIC);
+    }
+
+    void write(ChunkType type, const base::Bytes& payload)
+    {
+        auto type_data = static_cast<base::Byte>(type);
+        writeBytes(base::Bytes(&type_data, 1));
+        writeBytes(base::toBytes(static_cast<std::uint64_t>(payload.size())));
+        writeBytes(payload);
+        writeBytes(base::Sha256::compute(payload).getBytes().toBytes());
+    }
+
+    // items of a record never go to different chunks
+    void addRecord(ChunkType type, std::initializer_list<base::Bytes> items)
+    {
+        if (type != _records_type) {
+            flushRecords();
+            _records_type = type;
+        }
+        for (const auto& item : items) {
+            _records_size += item.size();
+            _records.push_back(item);
+        }
+        if (_records_size >= base::config::SNAPSHOT_CHUNK_SIZE) {
+            flushRecords();
+        }
+    }
+
+    void flushRecords()
+    {
+        if (!_records.empty()) {
+            write(_records_type, base::toBytes(_records));
+            _records.clear();
+            _records_size = 0;
+        }
+    }
+
+    void close()
+    {
+        flushRecords();
+        _file.close();
+        if (!_file) {
+            RAISE_ERROR(base::InaccessibleFile, "failed to write to " + _path.string());
+        }
+    }
+
+  private:
+    const std::filesystem::path _path;
+    std::ofstream _file;
+    ChunkType _records_type{ ChunkType::BLOCKS };
+    std::vector<base::Bytes> _records;
+    std::size_t _records_size{ 0 };
+
+    void writeBytes(const base::Bytes& data)
+    {
+        _file.write(reinterpret_cast<const char*>(data.getData()), static_cast<std::streamsize>(data.size()));
+        if (!_file) {
+            RAISE_ERROR(base::InaccessibleFile, "failed to write to " + _path.string());
+        }
+    }
+};
+
+
+struct Chunk
+{
+    ChunkType type;
+    base::Bytes payload;
+    base::Sha256 checksum;
+
+    void verify() const
+    {
+        if (base::Sha256::compute(payload) != checksum) {
+            RAISE_ERROR(base::ParsingError, "checksum mismatch in a chunk of snapshot");
+        }
+    }
+};
+
+
+class ChunkReader
+{
+  public:
+    explicit ChunkReader(const std::filesystem::path& path)
+      : _path{ path }
+      , _file{ path, std::ios::binary }
+    {
+        if (!_file) {
+            RAISE_ERROR(base::InaccessibleFile, "failed to open " + _path.string());
+        }
+        _remaining_size = std::filesystem::file_size(path);
+        if (readBytes(SNAPSHOT_MAGIC.size()) != SNAPSHOT_MAGIC) {
+            RAISE_ERROR(base::ParsingError, _path.string() + " is not a snapshot file");
+        }
+    }
+
+    Chunk read()
+    {
+        auto type = static_cast<ChunkType>(readBytes(1)[0]);
+        auto payload_size = base::fromBytes<std::uint64_t>(readBytes(sizeof(std::uint64_t)));
+        auto payload = readBytes(payload_size);
+        base::Sha256 checksum{ readBytes(base::Sha256::SHA256_SIZE) };
+        return Chunk{ type, std::move(payload), std::move(checksum) };
+    }
+
+  private:
+    const std::filesystem::path _path;
+    std::ifstream _file;
+    std::uint64_t _remaining_size;
+
+    // sizes are checked against the file, so a corrupted size never leads to a huge allocation
+    base::Bytes readBytes(std::uint64_t size)
+    {
+        if (size > _remaining_size) {
+            RAISE_ERROR(base::ParsingError, "snapshot file " + _path.string() + " is truncated");
+        }
+        base::Bytes data(size);
+        _file.read(reinterpret_cast<char*>(data.getData()), static_cast<std::streamsize>(size));
+        if (!_file) {
+            RAISE_ERROR(base::InaccessibleFile, "failed to read from " + _path.string());
+        }
+        _remaining_size -= size;
+        return data;
+    }
+};
+
+
+struct DecodedChunk
+{
+    ChunkType type;
+    bc::BlockWriter::Blocks blocks;
+    base::Database::WriteBatch batch;
+    std::size_t records_count{ 0 };
+};
+
+
+void checkStateRecord(const base::Bytes& key, const base::Bytes& value)
+{
+    auto is_state_type = [&key](bc::DataType type) { return key[0] == static_cast<base::Byte>(type); };
+    if (key.isEmpty() || std::none_of(STATE_DATA_TYPES.begin(), STATE_DATA_TYPES.end(), is_state_type)) {
+        RAISE_ERROR(base::ParsingError, "snapshot contains a record, that is not a part of state");
+    }
+    // codes are kept by hashes, so they are checked right away, accounts are checked by the state root
+    if (key[0] == static_cast<base::Byte>(bc::DataType::CONTRACT_CODE) &&
+        key != bc::toDatabaseKey(bc::DataType::CONTRACT_CODE, base::Sha256::compute(value).getBytes())) {
+        RAISE_ERROR(base::ParsingError, "snapshot contains a contract code, that doesn't match its hash");
+    }
+}
+
+
+// it is called in parallel for consecutive chunks, so it must not touch anything except a given chunk
+DecodedChunk decodeChunk(const Chunk& chunk)
+{
+    chunk.verify();
+    auto records = base::fromBytes<std::vector<base::Bytes>>(chunk.payload);
+
+    DecodedChunk decoded{ chunk.type, {}, {}, 0 };
+    if (chunk.type == ChunkType::BLOCKS) {
+        for (auto& block_data : records) {
+            // the block keeps its record as the serialized form, so the record is hashed and written as is
+            base::SerializationIArchive ia{ base::SharedBytes(std::move(block_data)) };
+            auto block = std::make_shared<const bc::Block>(bc::Block::deserialize(ia));
+            decoded.blocks.emplace_back(block->getHash(), std::move(block));
+        }
+    }
+    else {
+        if (records.size() % 2 != 0) {
+            RAISE_ERROR(base::ParsingError, "chunk of state records has a key without a value");
+        }
+        for (std::size_t i = 0; i < records.size(); i += 2) {
+            checkStateRecord(records[i], records[i + 1]);
+            decoded.batch.put(records[i], records[i + 1]);
+        }
+        decoded.records_count = records.size() / 2;
+    }
+    return decoded;
+}
+
+
+void checkDatabaseIsKept(const base::PropertyTree& config)
+{
+    if (config.get<bool>("database.clean")) {
+        RAISE_ERROR(base::InvalidArgument, "snapshot can't be used with database.clean set");
+    }
+}
+
+
+End importChunks(bc::Blockchain& blockchain, ChunkReader& reader, const Header& header)
+{
+    auto& database = blockchain.getDatabase();
+    const auto genesis_hash = lk::Core::getGenesisBlock().getHash();
+
+    End imported;
+    auto apply = [&](DecodedChunk decoded) {
+        if (decoded.type == ChunkType::BLOCKS) {
+            if (!decoded.blocks.empty() && decoded.blocks.front().second->getDepth() == 0 &&
+                decoded.blocks.front().first != genesis_hash) {
+                RAISE_ERROR(base::LogicError, "snapshot is made of a chain with other genesis block");
+            }
+            if (!blockchain.tryImportBlocks(decoded.blocks)) {
+                RAISE_ERROR(base::ParsingError, "snapshot contains a block, that doesn't continue the chain");
+            }
+            imported.blocks_count += decoded.blocks.size();
+        }
+        else {
+            database.write(decoded.batch);
+            imported.records_count += decoded.records_count;
+        }
+    };
+
+    // chunks are verified and decoded by a window of tasks, but applied in order of the file
+    const std::size_t window_size = 2 * std::max(1u, std::thread::hardware_concurrency());
+    std::deque<std::future<DecodedChunk>> decoding;
+    auto chunk = reader.read();
+    for (; chunk.type == ChunkType::BLOCKS || chunk.type == ChunkType::STATE; chunk = reader.read()) {
+        decoding.push_back(std::async(std::launch::async, [chunk = std::move(chunk)] { return decodeChunk(chunk); }));
+        if (decoding.size() >= window_size) {
+            apply(decoding.front().get());
+            decoding.pop_front();
+        }
+    }
+    for (; !decoding.empty(); decoding.pop_front()) {
+        apply(decoding.front().get());
+    }
+
+    if (chunk.type != ChunkType::END) {
+        RAISE_ERROR(base::ParsingError, "snapshot contains a chunk of unknown type");
+    }
+    chunk.verify();
+    auto end = base::fromBytes<End>(chunk.payload);
+    if (end.blocks_count != imported.blocks_count || end.records_count != imported.records_count) {
+        RAISE_ERROR(base::ParsingError, "snapshot lacks some of chunks");
+    }
+    if (blockchain.findBlockHashByDepth(header.top_depth) != header.top_hash) {
+        RAISE_ERROR(base::ParsingError, "top block of snapshot doesn't match its header");
+    }
+
+    // state is committed last, so a node never starts with a state, that wasn't verified
+    lk::AccountManager account_manager{ database,
+                                        base::config::STATE_ACCOUNTS_CACHE_SIZE,
+                                        base::config::STATE_STORAGE_VALUES_CACHE_SIZE };
+    base::Database::WriteBatch batch;
+    auto state_root = account_manager.rebuildStateTree(batch);
+    if (state_root != header.state_root) {
+        RAISE_ERROR(base::ParsingError, "state of snapshot doesn't match its state root");
+    }
+    batch.put(bc::toStateRootKey(header.top_depth), state_root.getBytes());
+    batch.put(bc::getStateDepthKey(), base::toBytes(header.top_depth));
+    database.write(batch);
+
+    return imported;
+}
+
+
+// the database had no blocks before the import, so all its records and block files are left from the import
+void removeImportedRecords(const base::PropertyTree& config)
+{
+    auto database_path = config.get<std::string>("database.path");
+    try {
+        auto database = base::createDefaultDatabaseInstance(base::Directory(database_path));
+        base::Database::WriteBatch batch;
+        for (auto it = database.createIterator(base::Bytes{}); it.isValid(); it.next()) {
+            batch.remove(it.key());
+        }
+        database.write(batch);
+        std::filesystem::remove_all(std::filesystem::path(database_path) / "blocks");
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR << "Failed to remove records of a failed import from " << database_path << ": " << e.what();
+    }
+}
+
+} // namespace
+
+namespace lk
+{
+
+void exportSnapshot(const base::PropertyTree& config, const std::filesystem::path& path)
+{
+    checkDatabaseIsKept(config);
+    bc::Blockchain blockchain{ config };
+    blockchain.load();
+    if (!blockchain.findBlockHashByDepth(0)) {
+        RAISE_ERROR(base::LogicError, "database has no blocks to export");
+    }
+
+    auto& database = blockchain.getDatabase();
+    auto top_depth = blockchain.getTopBlock()->getDepth();
+    auto state_depth_data = database.get(bc::getStateDepthKey());
+    if (!state_depth_data || base::fromBytes<bc::BlockDepth>(*state_depth_data) != top_depth) {
+        RAISE_ERROR(base::LogicError, "state is not committed up to the top block, run the node to catch up");
+    }
+    auto state_root_data = database.get(bc::toStateRootKey(top_depth));
+    if (!state_root_data) {
+        RAISE_ERROR(base::LogicError, "state of the top block has no state root");
+    }
+
+    ChunkWriter writer{ path };
+    Header header{
+        SNAPSHOT_FORMAT_VERSION, top_depth, *blockchain.findBlockHashByDepth(top_depth), base::Sha256(*state_root_data)
+    };
+    writer.write(ChunkType::HEADER, base::toBytes(header));
+
+    End end;
+    for (bc::BlockDepth depth = 0; depth <= top_depth; ++depth) {
+        auto block = blockchain.findBlock(*blockchain.findBlockHashByDepth(depth));
+        if (!block) {
+            RAISE_ERROR(base::LogicError, "body of block #" + std::to_string(depth) + " is pruned");
+        }
+        writer.addRecord(ChunkType::BLOCKS, { base::toBytes(*block) });
+        ++end.blocks_count;
+    }
+
+    auto snapshot = database.createSnapshot();
+    for (auto type : STATE_DATA_TYPES) {
+        for (auto it = database.createIterator(bc::toDatabaseKey(type, base::Bytes{}), snapshot); it.isValid();
+             it.next()) {
+            writer.addRecord(ChunkType::STATE, { it.key(), it.value() });
+            ++end.records_count;
+        }
+    }
+    writer.flushRecords();
+    writer.write(ChunkType::END, base::toBytes(end));
+    writer.close();
+
+    LOG_INFO << "Exported " << end.blocks_count << " blocks and " << end.records_count << " state records to "
+             << path;
+}
+
+
+void importSnapshot(const base::PropertyTree& config, const std::filesystem::path& path)
+{
+    checkDatabaseIsKept(config);
+    ChunkReader reader{ path };
+    auto header_chunk = reader.read();
+    if (header_chunk.type != ChunkType::HEADER) {
+        RAISE_ERROR(base::ParsingError, "snapshot doesn't start with a header");
+    }
+    header_chunk.verify();
+    auto header = base::fromBytes<Header>(header_chunk.payload);
+    if (header.version != SNAPSHOT_FORMAT_VERSION) {
+        RAISE_ERROR(base::ParsingError, "unsupported snapshot version " + std::to_string(header.version));
+    }
+
+    {
+        bc::Blockchain blockchain{ config };
+        blockchain.load();
+        if (blockchain.findBlockHashByDepth(0)) {
+            RAISE_ERROR(base::LogicError, "snapshot can be imported only to a database without blocks");
+        }
+    }
+
+    try {
+        bc::Blockchain blockchain{ config };
+        auto imported = importChunks(blockchain, reader, header);
+        LOG_INFO << "Imported " << imported.blocks_count << " blocks and " << imported.records_count
+                 << " state records from " << path;
+    }
+    catch (...) {
+        // the database is left without blocks, so the import can be repeated
+        removeImportedRecords(config);
+        throw;
+    }
+}
+
+} // namespace lk
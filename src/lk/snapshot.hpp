@@ -0,0 +1,23 @@
+#pragma once
+
+#include "base/property_tree.hpp"
+
+#include <filesystem>
+
+namespace lk
+{
+
+/*
+ *  Snapshot is a file with all blocks of a chain and the state as of its top block. It is a stream of chunks,
+ *  each one is checksummed: a header, chunks of blocks in order of depth, chunks of state records and an end.
+ *  Both functions work with a node database given by a config, so the node must not be running at that time.
+ */
+
+// blocks must not be pruned, and the state must be committed up to the top block
+void exportSnapshot(const base::PropertyTree& config, const std::filesystem::path& path);
+
+// the database must not contain blocks; chunks are verified in parallel, written with bulk writes, and the
+// state tree is built from imported records and checked against the state root of the snapshot
+void importSnapshot(const base::PropertyTree& config, const std::filesystem::path& path);
+
+} // namespace lk
@@ -0,0 +1,260 @@
+#include "state_tree.hpp"
+
+#include "base/assert.hpp"
+#include "base/error.hpp"
+#include "bc/database_keys.hpp"
+
+#include <algorithm>
+#include <future>
+
+namespace
+{
+
+constexpr std::size_t KEY_BITS = base::Sha256::SHA256_SIZE * 8;
+constexpr std::size_t PARALLEL_DEPTH = 4; // subtrees above this depth are updated in separate threads
+
+const base::Bytes NODES_PREFIX{ bc::toDatabaseKey(bc::DataType::STATE_TREE_NODE, base::Bytes{}) };
+
+
+bool getBit(const base::Sha256& key, std::size_t index)
+{
+    return (key.getBytes()[index / 8] >> (7 - index % 8)) & 1;
+}
+
+
+base::Sha256 setBit(const base::Sha256& key, std::size_t index, bool value)
+{
+    auto bytes = key.getBytes();
+    base::Byte mask = 1 << (7 - index % 8);
+    if (value) {
+        bytes[index / 8] |= mask;
+    }
+    else {
+        bytes[index / 8] &= ~mask;
+    }
+    return base::Sha256(std::move(bytes));
+}
+
+
+base::Bytes toNodeKey(std::size_t depth, const base::Sha256& path)
+{
+    // bits of path below the depth don't identify the position, so they are zeroed
+    auto path_bytes = path.getBytes();
+    for (std::size_t i = depth; i < KEY_BITS; ++i) {
+        path_bytes[i / 8] &= ~(1 << (7 - i % 8));
+    }
+    auto key = bc::toDatabaseKey(bc::DataType::STATE_TREE_NODE, base::toBytes(static_cast<std::uint16_t>(depth)));
+    key.append(path_bytes.getData(), path_bytes.size());
+    return key;
+}
+
+} // namespace
+
+namespace lk
+{
+
+base::Sha256 StateTree::Node::computeHash() const
+{
+    if (type == Type::EMPTY) {
+        return base::Sha256::null();
+    }
+    // type goes first, so a leaf never has the same hash as an internal node
+    const auto type_byte = static_cast<base::Byte>(type);
+    base::Sha256Hasher hasher;
+    hasher.update(&type_byte, 1);
+    hasher.update(first.getBytes());
+    hasher.update(second.getBytes());
+    return hasher.finalize();
+}
+
+
+void StateTree::Node::serialize(base::SerializationOArchive& oa) const
+{
+    oa.serialize(static_cast<base::Byte>(type));
+    oa.serialize(first);
+    oa.serialize(second);
+}
+
+
+StateTree::Node StateTree::Node::deserialize(base::SerializationIArchive& ia)
+{
+    Node node;
+    node.type = static_cast<Type>(ia.deserialize<base::Byte>());
+    node.first = ia.deserialize<base::Sha256>();
+    node.second = ia.deserialize<base::Sha256>();
+    return node;
+}
+
+
+StateTree::StateTree(base::Database& database)
+  : _database{ database }
+  , _root{ base::Sha256::null() }
+{
+    if (auto data = _database.get(toNodeKey(0, base::Sha256::null())); data) {
+        _root = base::fromBytes<Node>(*data).computeHash();
+    }
+}
+
+
+void StateTree::update(const Changes& changes)
+{
+    if (changes.empty()) {
+        return;
+    }
+    Entries entries(changes.begin(), changes.end());
+    auto root = _root == base::Sha256::null() ? Node{} : loadNode(0, entries.front().first);
+    Nodes nodes;
+    _root = updateNode(0, std::move(root), entries.cbegin(), entries.cend(), nodes).computeHash();
+    for (auto& [key, node] : nodes) {
+        _unflushed_nodes[key] = std::move(node);
+    }
+}
+
+
+void StateTree::flush(base::Database::WriteBatch& batch)
+{
+    for (const auto& [key, node] : _unflushed_nodes) {
+        if (node) {
+            batch.put(key, base::toBytes(*node));
+        }
+        else {
+            batch.remove(key);
+        }
+    }
+    _unflushed_nodes.clear();
+}
+
+
+const base::Sha256& StateTree::getRoot() const noexcept
+{
+    return _root;
+}
+
+
+void StateTree::clear()
+{
+    base::Database::WriteBatch batch;
+    for (auto it = _database.createIterator(NODES_PREFIX); it.isValid(); it.next()) {
+        batch.remove(it.key());
+    }
+    _database.write(batch);
+    _unflushed_nodes.clear();
+    _root = base::Sha256::null();
+}
+
+
+StateTree::Node StateTree::loadNode(std::size_t depth, const base::Sha256& path) const
+{
+    auto key = toNodeKey(depth, path);
+    if (auto it = _unflushed_nodes.find(key); it != _unflushed_nodes.end()) {
+        if (it->second) {
+            return *it->second;
+        }
+    }
+    else if (auto data = _database.get(key); data) {
+        return base::fromBytes<Node>(*data);
+    }
+    RAISE_ERROR(base::DatabaseError, "state tree node is missing");
+}
+
+
+StateTree::Node StateTree::updateNode(std::size_t depth,
+                                      Node node,
+                                      Entries::const_iterator begin,
+                                      Entries::const_iterator end,
+                                      Nodes& nodes) const
+{
+    if (begin == end) {
+        return node;
+    }
+
+    if (node.type == Node::Type::LEAF) {
+        // the leaf goes down as one more change, unless it is changed itself
+        Entries entries(begin, end);
+        auto it = std::lower_bound(
+          entries.begin(), entries.end(), node.first, [](const auto& entry, const auto& key) { return entry.first < key; });
+        if (it == entries.end() || it->first != node.first) {
+            entries.insert(it, { node.first, node.second });
+        }
+        return updateNode(depth, Node{}, entries.cbegin(), entries.cend(), nodes);
+    }
+
+    auto has_value = [](const auto& entry) { return entry.second.has_value(); };
+    Node result;
+    if (node.type == Node::Type::EMPTY && std::count_if(begin, end, has_value) <= 1) {
+        if (auto it = std::find_if(begin, end, has_value); it != end) {
+            result = Node{ Node::Type::LEAF, it->first, *it->second };
+        }
+    }
+    else {
+        ASSERT(depth < KEY_BITS);
+        struct Child
+        {
+            base::Sha256 hash;
+            std::optional<Node> node; // known only if the child was updated
+        };
+
+        auto update_child = [this, depth, &node](bool is_right,
+                                                 Entries::const_iterator child_begin,
+                                                 Entries::const_iterator child_end,
+                                                 Nodes& child_nodes) {
+            const auto& hash = is_right ? node.second : node.first;
+            if (child_begin == child_end) {
+                return Child{ hash, std::nullopt };
+            }
+            // children of an empty node are empty as well
+            auto child = hash == base::Sha256::null() ? Node{} : loadNode(depth + 1, child_begin->first);
+            auto updated = updateNode(depth + 1, std::move(child), child_begin, child_end, child_nodes);
+            return Child{ updated.computeHash(), std::move(updated) };
+        };
+
+        auto middle = std::partition_point(begin, end, [depth](const auto& entry) { return !getBit(entry.first, depth); });
+        Child left{ base::Sha256::null(), std::nullopt };
+        Child right{ base::Sha256::null(), std::nullopt };
+        if (depth < PARALLEL_DEPTH && begin != middle && middle != end) {
+            // subtrees have no common nodes, so they are merged in any order
+            Nodes left_nodes;
+            auto left_future =
+              std::async(std::launch::async, update_child, false, begin, middle, std::ref(left_nodes));
+            right = update_child(true, middle, end, nodes);
+            left = left_future.get();
+            nodes.merge(left_nodes);
+        }
+        else {
+            left = update_child(false, begin, middle, nodes);
+            right = update_child(true, middle, end, nodes);
+        }
+
+        const auto null_hash = base::Sha256::null();
+        if (left.hash == null_hash && right.hash == null_hash) {
+            result = Node{};
+        }
+        else if (left.hash == null_hash || right.hash == null_hash) {
+            bool is_right = left.hash == null_hash;
+            auto& other = is_right ? right : left;
+            auto other_path = setBit(begin->first, depth, is_right);
+            auto other_node = other.node ? *other.node : loadNode(depth + 1, other_path);
+            if (other_node.type == Node::Type::LEAF) {
+                // the only key left in the subtree, so the leaf goes up
+                nodes[toNodeKey(depth + 1, other_path)] = std::nullopt;
+                result = std::move(other_node);
+            }
+            else {
+                result = Node{ Node::Type::INTERNAL, left.hash, right.hash };
+            }
+        }
+        else {
+            result = Node{ Node::Type::INTERNAL, left.hash, right.hash };
+        }
+    }
+
+    if (result.type == Node::Type::EMPTY) {
+        nodes[toNodeKey(depth, begin->first)] = std::nullopt;
+    }
+    else {
+        nodes[toNodeKey(depth, begin->first)] = result;
+    }
+    return result;
+}
+
+} // namespace lk
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "base/database.hpp"
+#include "base/hash.hpp"
+
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace lk
+{
+
+/**
+ *  @brief Sparse Merkle tree over 256-bit keys, that is kept in a database.
+ *
+ *  A subtree with a single key is stored as a leaf at the top of the subtree, so paths are as long as
+ *  needed to tell keys apart. Update rehashes only paths to changed keys, top subtrees are updated in parallel.
+ */
+class StateTree
+{
+  public:
+    //================
+    // key -> hash of a new value, std::nullopt removes a key from the tree
+    using Changes = std::map<base::Sha256, std::optional<base::Sha256>>;
+    //================
+    explicit StateTree(base::Database& database);
+    StateTree(const StateTree&) = delete;
+    StateTree(StateTree&&) = delete;
+    StateTree& operator=(const StateTree&) = delete;
+    StateTree& operator=(StateTree&&) = delete;
+    ~StateTree() = default;
+    //================
+    // changed nodes are kept in memory until flush, the new root is returned by getRoot after that
+    void update(const Changes& changes);
+    // adds records of nodes, that were changed since the previous flush, to the batch
+    void flush(base::Database::WriteBatch& batch);
+    // hash of an empty tree is null
+    const base::Sha256& getRoot() const noexcept;
+    //================
+    // removes all nodes from memory and database
+    void clear();
+    //================
+  private:
+    //================
+    struct Node
+    {
+        enum class Type : base::Byte
+        {
+            EMPTY = 0,
+            LEAF = 1,
+            INTERNAL = 2
+        };
+
+        Type type{ Type::EMPTY };
+        // key and hash of value for a leaf, hashes of left and right subtrees for an internal node
+        base::Sha256 first{ base::Sha256::null() };
+        base::Sha256 second{ base::Sha256::null() };
+
+        base::Sha256 computeHash() const;
+        void serialize(base::SerializationOArchive& oa) const;
+        static Node deserialize(base::SerializationIArchive& ia);
+    };
+    //================
+    using Entries = std::vector<std::pair<base::Sha256, std::optional<base::Sha256>>>;
+    // database key of a node -> the node, std::nullopt for a removed one
+    using Nodes = std::map<base::Bytes, std::optional<Node>>;
+    //================
+    base::Database& _database;
+    base::Sha256 _root;
+    // nodes are read from here first, so updates go on before their records are written
+    Nodes _unflushed_nodes;
+    //================
+    // every position in the tree is a depth and a path to it, which is given by any key under the position
+    Node loadNode(std::size_t depth, const base::Sha256& path) const;
+    Node updateNode(std::size_t depth,
+                    Node node,
+                    Entries::const_iterator begin,
+                    Entries::const_iterator end,
+                    Nodes& nodes) const;
+    //================
+};
+
+} // namespace lk
@@ -1,7 +1,6 @@
 #include "connection.hpp"
 
 #include "base/assert.hpp"
-#include "base/config.hpp"
 #include "base/log.hpp"
 #include "net/error.hpp"
 
@@ -19,7 +18,6 @@ namespace net
 Connection::Connection(boost::asio::io_context& io_context, boost::asio::ip::tcp::socket&& socket)
   : _io_context{ io_context }
   , _socket{ std::move(socket) }
-  , _read_buffer(base::config::NET_MESSAGE_BUFFER_SIZE)
 {
     ASSERT(_socket.is_open());
     const auto& re = _socket.remote_endpoint();
@@ -74,8 +72,10 @@ const Endpoint& Connection::getEndpoint() const
 
 void Connection::receive(std::size_t bytes_to_receive, net::Connection::ReceiveHandler receive_handler)
 {
+    // the previous buffer was given away to a handler
+    _read_buffer = base::Bytes(bytes_to_receive);
     ba::async_read(_socket,
-                   ba::buffer(_read_buffer.toVector()),
+                   ba::buffer(_read_buffer.getData(), _read_buffer.size()),
                    ba::transfer_exactly(bytes_to_receive),
                    [this, cp = shared_from_this(), handler = std::move(receive_handler)](
                      const boost::system::error_code& ec, const std::size_t bytes_received) mutable {
@@ -101,9 +101,8 @@ void Connection::receive(std::size_t bytes_to_receive, net::Connection::ReceiveH
                        }
                        else {
                            try {
-                               //_read_buffer.resize(bytes_received);
-                               (std::move(handler))(_read_buffer);
-                               _read_buffer.resize(base::config::NET_MESSAGE_BUFFER_SIZE);
+                               _read_buffer.resize(bytes_received);
+                               (std::move(handler))(base::SharedBytes(std::move(_read_buffer)));
                            }
                            catch (const std::exception& e) {
                                LOG_WARNING << "Error during packet handling: " << e.what();
@@ -139,7 +138,7 @@ void Connection::sendPendingMessages()
 
     base::Bytes& message = _pending_send_messages.front();
     ba::async_write(_socket,
-                    ba::buffer(message.toVector()),
+                    ba::buffer(message.getData(), message.size()),
                     [this, cp = shared_from_this()](const boost::system::error_code& ec, const std::size_t bytes_sent) {
                         if (_is_closed) {
                             return;
@@ -19,7 +19,8 @@ class Connection : public std::enable_shared_from_this<Connection>
 {
   public:
     //====================
-    using ReceiveHandler = std::function<void(const base::Bytes&)>;
+    // every receive gets its own buffer, so a handler can keep received bytes without copying them
+    using ReceiveHandler = std::function<void(const base::SharedBytes&)>;
     //====================
     Connection(boost::asio::io_context& io_context, boost::asio::ip::tcp::socket&& socket);
 
@@ -8,8 +8,20 @@
 namespace
 {
 static constexpr std::size_t SIZE_OF_MESSAGE_LENGTH_IN_BYTES = 2;
+
+
+// the frame is allocated once for both the length and the message
+base::Bytes makeFrame(const base::Bytes& data)
+{
+    base::SerializationOArchive oa;
+    oa.reserve(SIZE_OF_MESSAGE_LENGTH_IN_BYTES + data.size());
+    oa.serialize(static_cast<std::uint16_t>(data.size()));
+    oa.write(data.getData(), data.size());
+    return std::move(oa).getBytes();
 }
 
+} // namespace
+
 namespace net
 {
 
@@ -43,7 +55,7 @@ bool Session::isClosed() const
 void Session::send(const base::Bytes& data)
 {
     if (isActive()) {
-        _connection->send(base::toBytes(static_cast<std::uint16_t>(data.size())) + data);
+        _connection->send(makeFrame(data));
     }
 }
 
@@ -51,7 +63,7 @@ void Session::send(const base::Bytes& data)
 void Session::send(base::Bytes&& data)
 {
     if (isActive()) {
-        _connection->send(base::toBytes(static_cast<std::uint16_t>(data.size())) + data);
+        _connection->send(makeFrame(data));
     }
 }
 
@@ -81,10 +93,10 @@ void Session::close()
 
 void Session::receive()
 {
-    _connection->receive(SIZE_OF_MESSAGE_LENGTH_IN_BYTES, [this](const base::Bytes& data) {
+    _connection->receive(SIZE_OF_MESSAGE_LENGTH_IN_BYTES, [this](const base::SharedBytes& data) {
         _last_seen = base::Time::now();
         auto length = base::fromBytes<std::uint16_t>(data);
-        _connection->receive(length, [this](const base::Bytes& data) {
+        _connection->receive(length, [this](const base::SharedBytes& data) {
             if (_handler) {
                 _handler->onReceive(data);
             }
@@ -16,7 +16,8 @@ class Session
     {
       public:
         //===================
-        virtual void onReceive(const base::Bytes& bytes) = 0;
+        // bytes are not reused by a connection, so they can be kept by a handler
+        virtual void onReceive(const base::SharedBytes& bytes) = 0;
         // virtual void onSend() = 0;
         virtual void onClose() = 0;
         //===================
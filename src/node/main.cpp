@@ -4,7 +4,8 @@
 #include "base/assert.hpp"
 #include "base/config.hpp"
 #include "base/log.hpp"
-#include "base/program_options.hpp"
+#include "base/subprogram_router.hpp"
+#include "lk/snapshot.hpp"
 #include "node/node.hpp"
 
 #ifdef CONFIG_OS_FAMILY_UNIX
@@ -17,6 +18,7 @@
 #include <cstdlib>
 #include <exception>
 #include <filesystem>
+#include <functional>
 #include <iostream>
 #include <thread>
 
@@ -49,56 +51,92 @@ void atExitHandler()
     boost::log::core::get()->flush();
 }
 
+
+int mainProcess(base::SubprogramRouter& router)
+{
+    LOG_INFO << "Node startup";
+
+    router.getOptionsParser().addOption<std::string>("config,c", config::CONFIG_PATH, "Path to config file");
+    router.update();
+    if (router.getOptionsParser().hasOption("help")) {
+        std::cout << router.helpMessage() << std::endl;
+        return base::config::EXIT_OK;
+    }
+
+    auto config_file_path = router.getOptionsParser().getValue<std::string>("config");
+
+    if (!std::filesystem::exists(config_file_path)) {
+        LOG_ERROR << "[config file is not exists] input file path: " << config_file_path;
+        return base::config::EXIT_FAIL;
+    }
+    else {
+        LOG_INFO << "Found config file by path: " << config_file_path;
+    }
+
+    // handlers initialization
+
+    // setup handler for all signal types defined in Standard, expect SIGABRT. Not all POSIX signals
+    for (auto signal_code : { SIGTERM, SIGSEGV, SIGINT, SIGILL, SIGFPE }) {
+        [[maybe_unused]] auto result = std::signal(signal_code, signalHandler);
+        ASSERT_SOFT(result != SIG_ERR);
+    }
+
+    {
+        [[maybe_unused]] auto result = std::atexit(atExitHandler);
+        ASSERT_SOFT(result == 0);
+    }
+
+    //=====================
+    SoftConfig exe_config(config_file_path);
+    Node node(exe_config);
+    node.run();
+    //=====================
+    std::this_thread::sleep_for(std::chrono::seconds(4500));
+
+    return base::config::EXIT_OK;
+}
+
+
+// snapshots are made and imported with the node stopped, since the node database is opened exclusively
+int processSnapshot(base::SubprogramRouter& router,
+                    const std::function<void(const base::PropertyTree&, const std::filesystem::path&)>& action)
+{
+    router.getOptionsParser().addOption<std::string>("config,c", config::CONFIG_PATH, "Path to config file");
+    router.getOptionsParser().addRequiredOption<std::string>("file,f", "Path to snapshot file");
+    router.update();
+    if (router.getOptionsParser().hasOption("help")) {
+        std::cout << router.helpMessage() << std::endl;
+        return base::config::EXIT_OK;
+    }
+
+    auto config_file_path = router.getOptionsParser().getValue<std::string>("config");
+    if (!std::filesystem::exists(config_file_path)) {
+        LOG_ERROR << "[config file is not exists] input file path: " << config_file_path;
+        return base::config::EXIT_FAIL;
+    }
+
+    SoftConfig exe_config(config_file_path);
+    action(exe_config, router.getOptionsParser().getValue<std::string>("file"));
+    return base::config::EXIT_OK;
+}
+
 } // namespace
 
+
 int main(int argc, char** argv)
 {
     try {
         base::initLog(base::Sink::FILE | base::Sink::STDOUT);
-        LOG_INFO << "Node startup";
-
-        // set up options parser
-        base::ProgramOptionsParser parser;
-        parser.addOption<std::string>("config,c", config::CONFIG_PATH, "Path to config file");
-
-        // process options
-        parser.process(argc, argv);
-        if (parser.hasOption("help")) {
-            std::cout << parser.helpMessage() << std::endl;
-            return base::config::EXIT_OK;
-        }
-
-        auto config_file_path = parser.getValue<std::string>("config");
-
-        if (!std::filesystem::exists(config_file_path)) {
-            LOG_ERROR << "[config file is not exists] input file path: " << parser.getValue<std::string>("config");
-            return base::config::EXIT_FAIL;
-        }
-        else {
-            LOG_INFO << "Found config file by path: " << config_file_path;
-        }
-
-        // handlers initialization
-
-        // setup handler for all signal types defined in Standard, expect SIGABRT. Not all POSIX signals
-        for (auto signal_code : { SIGTERM, SIGSEGV, SIGINT, SIGILL, SIGFPE }) {
-            [[maybe_unused]] auto result = std::signal(signal_code, signalHandler);
-            ASSERT_SOFT(result != SIG_ERR);
-        }
-
-        {
-            [[maybe_unused]] auto result = std::atexit(atExitHandler);
-            ASSERT_SOFT(result == 0);
-        }
-
-        //=====================
-        SoftConfig exe_config(config_file_path);
-        Node node(exe_config);
-        node.run();
-        //=====================
-        std::this_thread::sleep_for(std::chrono::seconds(4500));
-
-        return base::config::EXIT_OK;
+        base::SubprogramRouter router("node", mainProcess);
+        router.addSubprogram(
+          "export_snapshot", "write blocks and state to a snapshot file", [](base::SubprogramRouter& subprogram) {
+              return processSnapshot(subprogram, lk::exportSnapshot);
+          });
+        router.addSubprogram(
+          "import_snapshot", "fill an empty database from a snapshot file", [](base::SubprogramRouter& subprogram) {
+              return processSnapshot(subprogram, lk::importSnapshot);
+          });
+        return router.process(argc, argv);
     }
     catch (const std::exception& error) {
         LOG_ERROR << "[exception caught in main] " << error.what();
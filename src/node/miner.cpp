@@ -198,7 +198,7 @@ void MinerWorker::worker()
                 while (last_read_version == _common_state.getVersion()) {
                     auto attempting_nonce = mt();
                     b.setNonce(attempting_nonce);
-                    if (base::Sha256::compute(base::toBytes(b)).getBytes() < complexity) {
+                    if (b.getHash().getBytes() < complexity) {
                         _common_state.callHandlerAndDrop(std::move(data.block_to_mine).value());
                     }
                 }
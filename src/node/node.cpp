@@ -37,7 +37,7 @@ void Node::run()
 
 void Node::onBlockMine(bc::Block&& block)
 {
-    _core.tryAddBlock(block);
+    _core.tryAddBlock(std::make_shared<const bc::Block>(std::move(block)));
 }
 
 
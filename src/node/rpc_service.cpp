@@ -58,7 +58,7 @@ rpc::Info GeneralServerService::info()
 {
     LOG_TRACE << "Received RPC request {info}";
     try {
-        auto hash = base::Sha256::compute(base::toBytes(_core.getTopBlock()));
+        auto hash = _core.getTopBlock()->getHash();
         return { hash, 0 };
     }
     catch (const std::exception& e) {
@@ -116,7 +116,7 @@ std::tuple<rpc::OperationStatus, bc::Address, bc::Balance> GeneralServerService:
 
     try {
         _core.addPendingTransactionAndWait(tx);
-        auto hash = base::Sha256::compute(base::toBytes(tx));
+        auto hash = tx.getHash();
         auto raw_output = _core.getTransactionOutput(hash);
         if (raw_output.isEmpty()) {
             return { rpc::OperationStatus::createFailed(std::string{ "Transaction failed" }),
@@ -179,7 +179,7 @@ std::tuple<rpc::OperationStatus, std::string, bc::Balance> GeneralServerService:
 
     try {
         _core.addPendingTransactionAndWait(tx);
-        auto hash = base::Sha256::compute(base::toBytes(tx));
+        auto hash = tx.getHash();
         const auto& result_bytes = _core.getTransactionOutput(hash);
         if (result_bytes.isEmpty()) {
             return { rpc::OperationStatus::createFailed(std::string{ "Message call failed" }), std::string{}, gas };
@@ -0,0 +1,212 @@
+#include "bench.hpp"
+
+#include "base/bytes.hpp"
+
+#include <openssl/bio.h>
+#include <openssl/buffer.h>
+#include <openssl/evp.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+// the scalar and OpenSSL conversions that base used before the SIMD kernels, kept as a baseline
+
+constexpr std::string_view BASE58_ALPHABET = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+
+std::string scalarToHex(const base::Bytes& bytes)
+{
+    static constexpr char DIGITS[] = "0123456789abcdef";
+    std::string ret(bytes.size() * 2, '\0');
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        ret[2 * i] = DIGITS[bytes[i] >> 4];
+        ret[2 * i + 1] = DIGITS[bytes[i] & 0xF];
+    }
+    return ret;
+}
+
+
+base::Byte hexDigit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return static_cast<base::Byte>(c - '0');
+    }
+    if (c >= 'a' && c <= 'f') {
+        return static_cast<base::Byte>(c - 'a' + 10);
+    }
+    return static_cast<base::Byte>(c - 'A' + 10);
+}
+
+
+base::Bytes scalarFromHex(std::string_view hex)
+{
+    base::Bytes ret(hex.size() / 2);
+    for (std::size_t i = 0; i < ret.size(); ++i) {
+        ret[i] = static_cast<base::Byte>((hexDigit(hex[2 * i]) << 4) | hexDigit(hex[2 * i + 1]));
+    }
+    return ret;
+}
+
+
+std::string bioBase64Encode(const base::Bytes& bytes)
+{
+    BIO* bio = BIO_push(BIO_new(BIO_f_base64()), BIO_new(BIO_s_mem()));
+    BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
+    BIO_write(bio, bytes.getData(), static_cast<int>(bytes.size()));
+    BIO_flush(bio);
+    BUF_MEM* buffer;
+    BIO_get_mem_ptr(bio, &buffer);
+    std::string ret(buffer->data, buffer->length);
+    BIO_free_all(bio);
+    return ret;
+}
+
+
+base::Bytes bioBase64Decode(std::string_view base64)
+{
+    BIO* bio = BIO_push(BIO_new(BIO_f_base64()), BIO_new_mem_buf(base64.data(), static_cast<int>(base64.size())));
+    BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
+    base::Bytes ret(base64.size());
+    auto length = BIO_read(bio, ret.getData(), static_cast<int>(base64.size()));
+    BIO_free_all(bio);
+    ret.resize(static_cast<std::size_t>(std::max(length, 0)));
+    return ret;
+}
+
+
+// one base58 digit at a time
+std::string digitsBase58Encode(const base::Bytes& bytes)
+{
+    std::size_t zeros_count = 0;
+    while (zeros_count < bytes.size() && bytes[zeros_count] == 0) {
+        ++zeros_count;
+    }
+    std::vector<base::Byte> digits;
+    for (std::size_t i = zeros_count; i < bytes.size(); ++i) {
+        std::size_t carry = bytes[i];
+        for (auto& digit : digits) {
+            carry += 256 * digit;
+            digit = static_cast<base::Byte>(carry % 58);
+            carry /= 58;
+        }
+        for (; carry != 0; carry /= 58) {
+            digits.push_back(static_cast<base::Byte>(carry % 58));
+        }
+    }
+    std::string ret(zeros_count, '1');
+    for (auto it = digits.rbegin(); it != digits.rend(); ++it) {
+        ret += BASE58_ALPHABET[*it];
+    }
+    return ret;
+}
+
+
+// one base58 digit at a time
+base::Bytes digitsBase58Decode(std::string_view base58)
+{
+    std::size_t ones_count = 0;
+    while (ones_count < base58.size() && base58[ones_count] == '1') {
+        ++ones_count;
+    }
+    std::vector<base::Byte> bytes;
+    for (std::size_t i = ones_count; i < base58.size(); ++i) {
+        std::size_t carry = BASE58_ALPHABET.find(base58[i]);
+        for (auto& byte : bytes) {
+            carry += 58 * byte;
+            byte = static_cast<base::Byte>(carry);
+            carry >>= 8;
+        }
+        for (; carry != 0; carry >>= 8) {
+            bytes.push_back(static_cast<base::Byte>(carry));
+        }
+    }
+    base::Bytes ret(ones_count + bytes.size());
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        ret[ones_count + i] = bytes[bytes.size() - 1 - i];
+    }
+    return ret;
+}
+
+
+base::Bytes randomBytes(std::size_t size)
+{
+    std::mt19937 rng(size);
+    base::Bytes ret(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        ret[i] = static_cast<base::Byte>(rng());
+    }
+    return ret;
+}
+
+
+std::size_t callsCount(std::size_t size)
+{
+    return size > 2048 ? 2000 : 200000;
+}
+
+}
+
+
+BENCHMARK(hex)
+{
+    for (std::size_t size : { 32, 65, 1024, 24 * 1024 }) {
+        auto bytes = randomBytes(size);
+        auto hex = base::toHex(bytes);
+        auto suffix = " " + std::to_string(size) + "B";
+        auto calls_count = callsCount(size);
+
+        bench::report("scalar toHex" + suffix,
+                      bench::measure(calls_count, [&bytes] { bench::keep(scalarToHex(bytes)); }));
+        bench::report("toHex" + suffix, bench::measure(calls_count, [&bytes] { bench::keep(base::toHex(bytes)); }));
+        bench::report("scalar fromHex" + suffix,
+                      bench::measure(calls_count, [&hex] { bench::keep(scalarFromHex(hex)); }));
+        bench::report("fromHex" + suffix,
+                      bench::measure(calls_count, [&hex] { bench::keep(base::fromHex<base::Bytes>(hex)); }));
+    }
+}
+
+
+BENCHMARK(base64)
+{
+    for (std::size_t size : { 32, 65, 1024, 24 * 1024 }) {
+        auto bytes = randomBytes(size);
+        auto base64 = base::base64Encode(bytes);
+        auto suffix = " " + std::to_string(size) + "B";
+        auto calls_count = callsCount(size);
+
+        bench::report("OpenSSL BIO encode" + suffix,
+                      bench::measure(calls_count, [&bytes] { bench::keep(bioBase64Encode(bytes)); }));
+        bench::report("base64Encode" + suffix,
+                      bench::measure(calls_count, [&bytes] { bench::keep(base::base64Encode(bytes)); }));
+        bench::report("OpenSSL BIO decode" + suffix,
+                      bench::measure(calls_count, [&base64] { bench::keep(bioBase64Decode(base64)); }));
+        bench::report("base64Decode" + suffix,
+                      bench::measure(calls_count, [&base64] { bench::keep(base::base64Decode(base64)); }));
+    }
+}
+
+
+BENCHMARK(base58)
+{
+    constexpr std::size_t CALLS_COUNT = 20000;
+    for (std::size_t size : { 25, 64, 256 }) {
+        auto bytes = randomBytes(size);
+        auto base58 = base::base58Encode(bytes);
+        auto suffix = " " + std::to_string(size) + "B";
+
+        bench::report("digit by digit encode" + suffix,
+                      bench::measure(CALLS_COUNT, [&bytes] { bench::keep(digitsBase58Encode(bytes)); }));
+        bench::report("base58Encode" + suffix,
+                      bench::measure(CALLS_COUNT, [&bytes] { bench::keep(base::base58Encode(bytes)); }));
+        bench::report("digit by digit decode" + suffix,
+                      bench::measure(CALLS_COUNT, [&base58] { bench::keep(digitsBase58Decode(base58)); }));
+        bench::report("base58Decode" + suffix,
+                      bench::measure(CALLS_COUNT, [&base58] { bench::keep(base::base58Decode(base58)); }));
+    }
+}
@@ -0,0 +1,59 @@
+#include "bench.hpp"
+
+#include "base/bytes.hpp"
+#include "base/hash.hpp"
+
+#include <openssl/sha.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+constexpr std::size_t MESSAGES_COUNT = 1000;
+constexpr std::size_t CALLS_COUNT = 20;
+
+std::vector<base::Bytes> randomMessages(std::size_t length)
+{
+    std::mt19937 rng(length);
+    std::vector<base::Bytes> messages(MESSAGES_COUNT, base::Bytes(length));
+    for (auto& message : messages) {
+        for (std::size_t i = 0; i < length; ++i) {
+            message[i] = static_cast<base::Byte>(rng());
+        }
+    }
+    return messages;
+}
+
+}
+
+
+// time per message of a batch against messages hashed one by one
+BENCHMARK(sha256_compute_many)
+{
+    for (std::size_t length : { 32, 65, 200, 400, 4096 }) {
+        auto messages = randomMessages(length);
+        std::vector<base::BytesView> views(messages.begin(), messages.end());
+        auto suffix = " " + std::to_string(length) + "B";
+
+        bench::report("computeMany" + suffix, bench::measure(CALLS_COUNT, [&views] {
+                          bench::keep(base::Sha256::computeMany(views).front());
+                      }) / MESSAGES_COUNT);
+
+        bench::report("compute" + suffix, bench::measure(CALLS_COUNT, [&views] {
+                          for (const auto& view : views) {
+                              bench::keep(base::Sha256::compute(view));
+                          }
+                      }) / MESSAGES_COUNT);
+
+        bench::report("OpenSSL SHA256" + suffix, bench::measure(CALLS_COUNT, [&views] {
+                          base::FixedBytes<base::Sha256::SHA256_SIZE> digest;
+                          for (const auto& view : views) {
+                              SHA256(view.getData(), view.size(), digest.getData());
+                              bench::keep(digest);
+                          }
+                      }) / MESSAGES_COUNT);
+    }
+}
@@ -0,0 +1,137 @@
+#include "bench.hpp"
+
+#include "base/crypto.hpp"
+#include "base/serialization.hpp"
+#include "bc/block.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+constexpr std::size_t TRANSACTIONS_COUNT = 100;
+
+bc::Transaction makeTransaction(std::size_t index)
+{
+    return bc::Transaction{ bc::Address::null(),
+                            bc::Address::null(),
+                            bc::Balance(index),
+                            1,
+                            base::Time(1000 + index),
+                            bc::Transaction::Type::MESSAGE_CALL,
+                            base::Bytes(64) };
+}
+
+
+// transactions are left unsigned, if no keys are given
+bc::Block makeBlock(const std::pair<base::RsaPublicKey, base::RsaPrivateKey>* keys)
+{
+    bc::TransactionsSet txs;
+    for (std::size_t i = 0; i < TRANSACTIONS_COUNT; ++i) {
+        auto tx = makeTransaction(i);
+        if (keys) {
+            tx.sign(keys->first, keys->second);
+        }
+        txs.add(tx);
+    }
+    return bc::Block{ 1, base::Sha256::null(), base::Time(1), bc::Address::null(), std::move(txs) };
+}
+
+
+// serialization without the counting pass, the buffer grows while values are written
+template<typename T>
+base::Bytes toBytesUncounted(const T& value)
+{
+    base::SerializationOArchive oa;
+    oa.serialize(value);
+    return std::move(oa).getBytes();
+}
+
+
+template<typename T>
+void reportToBytes(const std::string& name, const T& value, std::size_t calls_count)
+{
+    bench::report(name + " counted",
+                  bench::measure(calls_count, [&value] { bench::keep(base::toBytes(value)); }));
+    bench::report(name + " uncounted",
+                  bench::measure(calls_count, [&value] { bench::keep(toBytesUncounted(value)); }));
+}
+
+
+// the same encoding as the vector serialization, but every element goes through its own serialize call
+template<typename T>
+base::Bytes toBytesByElements(const std::vector<T>& v)
+{
+    base::SerializationOArchive oa;
+    oa.serialize(v.size());
+    for (const auto& x : v) {
+        oa.serialize(x);
+    }
+    return std::move(oa).getBytes();
+}
+
+
+template<typename T>
+std::vector<T> fromBytesByElements(const base::Bytes& bytes)
+{
+    base::SerializationIArchive ia(bytes);
+    std::vector<T> v(ia.deserialize<std::size_t>());
+    for (auto& x : v) {
+        x = ia.deserialize<T>();
+    }
+    return v;
+}
+
+
+template<typename T>
+void reportVector(const std::string& name, const std::vector<T>& v, std::size_t calls_count)
+{
+    auto bytes = base::toBytes(v);
+    bench::report(name + " serialize bulk", bench::measure(calls_count, [&v] { bench::keep(base::toBytes(v)); }));
+    bench::report(name + " serialize by elements",
+                  bench::measure(calls_count, [&v] { bench::keep(toBytesByElements(v)); }));
+    bench::report(name + " deserialize bulk",
+                  bench::measure(calls_count, [&bytes] { bench::keep(base::fromBytes<std::vector<T>>(bytes)); }));
+    bench::report(name + " deserialize by elements",
+                  bench::measure(calls_count, [&bytes] { bench::keep(fromBytesByElements<T>(bytes)); }));
+}
+
+}
+
+
+// toBytes counts the size first and reserves the buffer once
+BENCHMARK(serialization_counted)
+{
+    auto keys = base::generateKeys();
+    auto signed_block = makeBlock(&keys);
+    auto unsigned_block = makeBlock(nullptr);
+    auto signed_tx = makeTransaction(0);
+    signed_tx.sign(keys.first, keys.second);
+    auto unsigned_tx = makeTransaction(0);
+
+    reportToBytes("block of 100 signed txs", signed_block, 300);
+    reportToBytes("block of 100 unsigned txs", unsigned_block, 3000);
+    reportToBytes("signed tx", signed_tx, 20000);
+    reportToBytes("unsigned tx", unsigned_tx, 100000);
+}
+
+
+// vectors of integrals and FixedBytes are written and read by whole memory blocks
+BENCHMARK(serialization_bulk_vectors)
+{
+    constexpr std::size_t SIZE = 10000;
+    std::vector<base::Byte> bytes(SIZE);
+    std::vector<std::uint64_t> numbers(SIZE);
+    std::vector<base::FixedBytes<32>> hashes;
+    for (std::size_t i = 0; i < SIZE; ++i) {
+        bytes[i] = static_cast<base::Byte>(i);
+        numbers[i] = i * 0x0101010101010101;
+        hashes.push_back(base::Sha256::compute(base::toBytes(i)).getBytes());
+    }
+
+    reportVector("10000 bytes", bytes, 20000);
+    reportVector("10000 u64", numbers, 5000);
+    reportVector("10000 32-byte hashes", hashes, 1000);
+}
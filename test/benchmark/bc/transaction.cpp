@@ -0,0 +1,51 @@
+#include "bench.hpp"
+
+#include "base/crypto.hpp"
+#include "base/serialization.hpp"
+#include "bc/block.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+constexpr std::size_t TRANSACTIONS_COUNT = 100;
+constexpr std::size_t CALLS_COUNT = 200;
+
+// transactions of senders go round robin, so with more senders than keys cached by a thread every key is parsed again
+base::Bytes makeBlockBytes(const std::vector<std::pair<base::RsaPublicKey, base::RsaPrivateKey>>& senders)
+{
+    bc::TransactionsSet txs;
+    for (std::size_t i = 0; i < TRANSACTIONS_COUNT; ++i) {
+        const auto& [pub, priv] = senders[i % senders.size()];
+        bc::Transaction tx{ bc::Address::null(),
+                            bc::Address::null(),
+                            bc::Balance(i),
+                            1,
+                            base::Time(1000 + i),
+                            bc::Transaction::Type::MESSAGE_CALL,
+                            base::Bytes(64) };
+        tx.sign(pub, priv);
+        txs.add(tx);
+    }
+    return base::toBytes(bc::Block{ 1, base::Sha256::null(), base::Time(1), bc::Address::null(), std::move(txs) });
+}
+
+}
+
+
+// parsed public keys are shared by transactions of the same sender
+BENCHMARK(transaction_decoding)
+{
+    std::vector<std::pair<base::RsaPublicKey, base::RsaPrivateKey>> senders;
+    for (std::size_t senders_count : { 1, 4, 20 }) {
+        while (senders.size() < senders_count) {
+            senders.push_back(base::generateKeys());
+        }
+        auto bytes = makeBlockBytes(senders);
+        bench::report("block of 100 signed txs, senders: " + std::to_string(senders_count),
+                      bench::measure(CALLS_COUNT, [&bytes] { bench::keep(base::fromBytes<bc::Block>(bytes)); }));
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace bench
+{
+
+// average duration of a call in nanoseconds, the first call warms caches up and is not counted
+template<typename F>
+double measure(std::size_t calls_count, F&& f)
+{
+    f();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < calls_count; ++i) {
+        f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / calls_count;
+}
+
+
+inline const void* volatile kept = nullptr;
+
+// the value escapes through a volatile store, so the compiler can't drop a computation whose result is unused
+template<typename T>
+void keep(const T& value)
+{
+    kept = &value;
+}
+
+
+void report(const std::string& name, double ns);
+
+
+class Registrar
+{
+  public:
+    Registrar(const char* name, void (*run)());
+};
+
+}
+
+#define BENCHMARK(name)                                                                                                \
+    static void name();                                                                                                \
+    static bench::Registrar name##_registrar(#name, name);                                                             \
+    static void name()
@@ -0,0 +1,62 @@
+#include "bench.hpp"
+
+#include "base/database.hpp"
+#include "base/hash.hpp"
+#include "bc/database_keys.hpp"
+#include "lk/managers.hpp"
+
+#include <filesystem>
+#include <string>
+
+namespace
+{
+
+constexpr std::size_t CALLS_COUNT = 200000;
+
+base::Sha256 storageKey(std::size_t i)
+{
+    base::FixedBytes<base::Sha256::SHA256_SIZE> key;
+    key[0] = static_cast<base::Byte>(i);
+    key[1] = static_cast<base::Byte>(i >> 8);
+    return base::Sha256(base::Bytes(key.getData(), key.size()));
+}
+
+}
+
+
+// the path of EVM SLOAD and SSTORE through the account manager, storage keys and values are 32 bytes
+BENCHMARK(evm_storage)
+{
+    const std::string path = "bench_storage_db";
+    std::filesystem::remove_all(path);
+    {
+        auto database = base::createClearDatabaseInstance(base::Directory(path));
+        lk::AccountManager manager{ database, 100, CALLS_COUNT };
+        auto& account = manager.getAccount(bc::Address{ base::Bytes("11111111111111111111") });
+
+        base::FixedBytes<base::Sha256::SHA256_SIZE> value;
+        std::size_t i = 0;
+        bench::report("set storage value", bench::measure(CALLS_COUNT, [&] {
+                          value[31] = static_cast<base::Byte>(i);
+                          account.setStorageValue(storageKey(i++), base::Bytes(value.getData(), value.size()));
+                      }));
+
+        i = 0;
+        bench::report("get storage value", bench::measure(CALLS_COUNT, [&] {
+                          bench::keep(account.getStorageValue(storageKey(i++)));
+                      }));
+
+        i = 0;
+        bench::report("storage database key", bench::measure(CALLS_COUNT, [&] {
+                          bench::keep(bc::toDatabaseKey(bc::DataType::ACCOUNT_STORAGE, storageKey(i++).getBytes()));
+                      }));
+
+        bench::report("32-byte Bytes copy and move", bench::measure(CALLS_COUNT, [&value] {
+                          base::Bytes bytes(value.getData(), value.size());
+                          base::Bytes copy(bytes);
+                          base::Bytes moved(std::move(copy));
+                          bench::keep(moved);
+                      }));
+    }
+    std::filesystem::remove_all(path);
+}
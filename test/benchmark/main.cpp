@@ -0,0 +1,50 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+std::vector<std::pair<std::string, void (*)()>>& benchmarks()
+{
+    static std::vector<std::pair<std::string, void (*)()>> instance;
+    return instance;
+}
+
+}
+
+namespace bench
+{
+
+void report(const std::string& name, double ns)
+{
+    std::cout << "  " << std::left << std::setw(48) << name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << ns << " ns" << std::endl;
+}
+
+
+Registrar::Registrar(const char* name, void (*run)())
+{
+    benchmarks().emplace_back(name, run);
+}
+
+}
+
+
+// runs all benchmarks, or only those named in arguments
+int main(int argc, char** argv)
+{
+    std::vector<std::string> selected(argv + 1, argv + argc);
+    for (const auto& [name, run] : benchmarks()) {
+        if (selected.empty() || std::find(selected.begin(), selected.end(), name) != selected.end()) {
+            std::cout << name << std::endl;
+            run();
+        }
+    }
+    return 0;
+}
@@ -1,9 +1,13 @@
 #include <boost/test/unit_test.hpp>
 
 #include "base/bytes.hpp"
+#include "base/error.hpp"
 #include "base/hash.hpp"
 
+#include <algorithm>
+#include <cctype>
 #include <memory>
+#include <string>
 
 BOOST_AUTO_TEST_CASE(bytes_storage_check)
 {
@@ -170,6 +174,39 @@ BOOST_AUTO_TEST_CASE(bytes_append2)
 }
 
 
+BOOST_AUTO_TEST_CASE(bytes_grow_past_inline_capacity)
+{
+    base::Bytes bytes;
+    for (std::size_t i = 0; i < 3 * base::Bytes::INLINE_CAPACITY; ++i) {
+        bytes.append(static_cast<base::Byte>(i));
+    }
+    BOOST_CHECK_EQUAL(bytes.size(), 3 * base::Bytes::INLINE_CAPACITY);
+
+    bytes.append(bytes.getData(), bytes.size());
+    bool res = true;
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        res = res && (bytes[i] == static_cast<base::Byte>(i % (3 * base::Bytes::INLINE_CAPACITY)));
+    }
+    BOOST_CHECK(res);
+
+    base::Bytes small{ 0x1, 0x2, 0x3 };
+    base::Bytes copied(bytes);
+    BOOST_CHECK(copied == bytes);
+    copied = small;
+    BOOST_CHECK(copied == small);
+
+    base::Bytes moved(std::move(bytes));
+    BOOST_CHECK(bytes.isEmpty());
+    BOOST_CHECK_EQUAL(moved.size(), 6 * base::Bytes::INLINE_CAPACITY);
+    moved = std::move(small);
+    BOOST_CHECK(moved == base::Bytes({ 0x1, 0x2, 0x3 }));
+
+    moved.shrinkToFit();
+    BOOST_CHECK(moved == base::Bytes({ 0x1, 0x2, 0x3 }));
+    BOOST_CHECK_EQUAL(moved.capacity(), base::Bytes::INLINE_CAPACITY);
+}
+
+
 BOOST_AUTO_TEST_CASE(bytes_intializer_list_constructor)
 {
     base::Bytes bytes{ 0x1, 0xFF, 0x2, 0xFE };
@@ -207,6 +244,54 @@ BOOST_AUTO_TEST_CASE(bytes_from_hex)
 }
 
 
+BOOST_AUTO_TEST_CASE(bytes_hex_of_long_bytes)
+{
+    // long enough to be converted by both vectorized and byte-at-a-time code
+    base::Bytes target_bytes(100);
+    std::string target_hex;
+    for (std::size_t i = 0; i < target_bytes.size(); ++i) {
+        target_bytes[i] = static_cast<base::Byte>(i * 37);
+        target_hex += "0123456789abcdef"[target_bytes[i] >> 4];
+        target_hex += "0123456789abcdef"[target_bytes[i] & 0xF];
+    }
+    BOOST_CHECK_EQUAL(base::toHex(target_bytes), target_hex);
+    BOOST_CHECK_EQUAL(base::fromHex<base::Bytes>(target_hex), target_bytes);
+
+    std::string upper_hex = target_hex;
+    std::transform(upper_hex.begin(), upper_hex.end(), upper_hex.begin(), ::toupper);
+    BOOST_CHECK_EQUAL(base::fromHex<base::Bytes>(upper_hex), target_bytes);
+
+    for (auto position : { 5, 70, 190 }) {
+        auto invalid_hex = target_hex;
+        invalid_hex[position] = 'g';
+        BOOST_CHECK_THROW(base::fromHex<base::Bytes>(invalid_hex), base::InvalidArgument);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(shared_bytes_parts_refer_to_the_same_bytes)
+{
+    base::Bytes bytes(3 * base::Bytes::INLINE_CAPACITY);
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<base::Byte>(i);
+    }
+    const auto* data = bytes.getData();
+
+    base::SharedBytes part;
+    {
+        base::SharedBytes shared{ std::move(bytes) };
+        BOOST_CHECK(shared.getData() == data);
+        part = shared.takePart(10, 20);
+    }
+    BOOST_CHECK_EQUAL(part.size(), 10);
+    BOOST_CHECK(part.getData() == data + 10);
+    BOOST_CHECK_EQUAL(part[0], 10);
+    BOOST_CHECK(part.takePart(5, 10) == base::SharedBytes(base::Bytes{ 15, 16, 17, 18, 19 }));
+    BOOST_CHECK(base::BytesView(part) == part.toBytes());
+    BOOST_CHECK(base::SharedBytes{}.isEmpty());
+}
+
+
 BOOST_AUTO_TEST_CASE(fixed_bytes_storage_check)
 {
     base::FixedBytes<111> fb1;
@@ -344,6 +429,25 @@ BOOST_AUTO_TEST_CASE(base64_encode_fixed_bytes_one_byte)
 }
 
 
+BOOST_AUTO_TEST_CASE(base64_encode_decode_long)
+{
+    for (std::size_t size : { 98, 99, 100 }) {
+        base::Bytes target_msg(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            target_msg[i] = static_cast<base::Byte>(i * 101);
+        }
+        auto base64 = base::base64Encode(target_msg);
+        BOOST_CHECK_EQUAL(base64.size(), (size + 2) / 3 * 4);
+        BOOST_CHECK(base::base64Decode(base64) == target_msg);
+
+        auto invalid_base64 = base64;
+        invalid_base64[20] = '-';
+        BOOST_CHECK_THROW(base::base64Decode(invalid_base64), base::InvalidArgument);
+        BOOST_CHECK_THROW(base::base64Decode(base64.substr(1)), base::InvalidArgument);
+    }
+}
+
+
 BOOST_AUTO_TEST_CASE(base58_encode_decode)
 {
     base::Bytes target_msg("dFM#69356^#-04  @#4-0^\n\n4#0632=-GEJ3dls5s,spi+-5+0");
@@ -373,3 +477,14 @@ BOOST_AUTO_TEST_CASE(base58_encode_decode_empty)
     BOOST_CHECK(base64 == "");
     BOOST_CHECK(target_msg == decode_base64);
 }
+
+
+BOOST_AUTO_TEST_CASE(base58_encode_decode_leading_zeroes)
+{
+    base::Bytes target_msg{ 0x00, 0x00, 0x01, 0x02 };
+    auto base58 = base::base58Encode(target_msg);
+    BOOST_CHECK(base58 == "115T");
+    BOOST_CHECK(base::base58Decode(base58) == target_msg);
+    BOOST_CHECK(base::base58Decode("111") == base::Bytes(3));
+    BOOST_CHECK_THROW(base::base58Decode("11O"), base::InvalidArgument);
+}
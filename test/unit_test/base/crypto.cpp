@@ -4,6 +4,8 @@
 
 #include <base/crypto.hpp>
 
+#include <optional>
+
 BOOST_AUTO_TEST_CASE(Rsa_pub_encrypt_priv_decrypt_check)
 {
     auto rsa = base::generateKeys(3688);
@@ -75,6 +77,25 @@ BOOST_AUTO_TEST_CASE(Rsa_serialization_constructor)
 }
 
 
+BOOST_AUTO_TEST_CASE(Rsa_pub_key_loaded_from_same_bytes)
+{
+    auto rsa1 = base::generateKeys(1024);
+    auto rsa2 = base::generateKeys(2048);
+
+    base::Bytes msg{ "Rs@_sh4red k3y" };
+    std::optional<base::RsaPublicKey> copy;
+    // loaded keys are reused, so the same bytes are loaded more times than keys are kept
+    for (int i = 0; i < 40; ++i) {
+        const auto& rsa = i % 2 ? rsa1 : rsa2;
+        base::RsaPublicKey pub_key(rsa.first.toBytes());
+        BOOST_CHECK(pub_key.toBytes() == rsa.first.toBytes());
+        BOOST_CHECK_EQUAL(pub_key.maxEncryptSize(), rsa.first.maxEncryptSize());
+        BOOST_CHECK(rsa.second.decrypt(pub_key.encrypt(msg)) == msg);
+        copy = pub_key;
+    }
+    BOOST_CHECK(rsa1.second.decrypt(copy->encrypt(msg)) == msg);
+}
+
 BOOST_AUTO_TEST_CASE(RsaPubKey_constructor_from_file_save_in_file)
 {
     auto [pub_rsa, priv_rsa] = base::generateKeys(2012);
@@ -236,4 +236,149 @@ BOOST_AUTO_TEST_CASE(data_base_with_long_path)
     BOOST_CHECK_EQUAL(data_base2.get(key1).value().toString(), bytes1.toString());
 
     std::filesystem::remove_all(path_to_data_base_folder);
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(data_base_write_batch)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+
+    base::Bytes bytes1("sgfabvduflalfgfdnjknv  lcjnajfhvbadg ksd weufib34g 8vb");
+    base::Bytes bytes2("SGJ$( GDSN3tdgjs#)(u35");
+    base::Bytes key1("test key");
+    base::Bytes key2("test key too");
+    base::Bytes key3("I will remove it in the batch");
+
+    auto data_base = base::createClearDatabaseInstance(path_to_data_base_folder);
+    data_base.put(key3, base::Bytes("rem"));
+
+    base::Database::WriteBatch batch;
+    BOOST_CHECK(batch.isEmpty());
+    batch.put(key1, bytes1);
+    batch.put(key2, bytes2);
+    batch.remove(key3);
+    BOOST_CHECK_EQUAL(batch.size(), 3);
+
+    BOOST_CHECK(!data_base.exists(key1));
+    BOOST_CHECK(!data_base.exists(key2));
+    BOOST_CHECK(data_base.exists(key3));
+
+    data_base.write(batch);
+
+    BOOST_CHECK(data_base.exists(key1));
+    BOOST_CHECK(data_base.exists(key2));
+    BOOST_CHECK(!data_base.exists(key3));
+    BOOST_CHECK_EQUAL(data_base.get(key1).value().toString(), bytes1.toString());
+    BOOST_CHECK_EQUAL(data_base.get(key2).value().toString(), bytes2.toString());
+
+    batch.clear();
+    BOOST_CHECK(batch.isEmpty());
+
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(data_base_iterate_by_prefix)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+
+    auto data_base = base::createClearDatabaseInstance(path_to_data_base_folder);
+    data_base.put(base::Bytes("a1"), base::Bytes("first"));
+    data_base.put(base::Bytes("b3"), base::Bytes("b third"));
+    data_base.put(base::Bytes("b1"), base::Bytes("b first"));
+    data_base.put(base::Bytes("b2"), base::Bytes("b second"));
+    data_base.put(base::Bytes("c1"), base::Bytes("last"));
+
+    std::vector<std::string> keys;
+    std::vector<std::string> values;
+    for (auto it = data_base.createIterator(base::Bytes("b")); it.isValid(); it.next()) {
+        keys.push_back(it.key().toString());
+        values.push_back(it.value().toString());
+    }
+    BOOST_CHECK((keys == std::vector<std::string>{ "b1", "b2", "b3" }));
+    BOOST_CHECK((values == std::vector<std::string>{ "b first", "b second", "b third" }));
+
+    auto it = data_base.createIterator(base::Bytes("b"));
+    it.seek(base::Bytes("b2"));
+    BOOST_CHECK(it.isValid());
+    BOOST_CHECK_EQUAL(it.key().toString(), "b2");
+
+    BOOST_CHECK(!data_base.createIterator(base::Bytes("d")).isValid());
+
+    std::size_t total_count = 0;
+    for (auto all = data_base.createIterator(base::Bytes{}); all.isValid(); all.next()) {
+        ++total_count;
+    }
+    BOOST_CHECK_EQUAL(total_count, 5);
+
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(data_base_iterate_backward)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+
+    auto data_base = base::createClearDatabaseInstance(path_to_data_base_folder);
+    data_base.put(base::Bytes("a1"), base::Bytes("first"));
+    data_base.put(base::Bytes("b1"), base::Bytes("b first"));
+    data_base.put(base::Bytes("b2"), base::Bytes("b second"));
+    data_base.put(base::Bytes("b4"), base::Bytes("b fourth"));
+    data_base.put(base::Bytes("c1"), base::Bytes("last"));
+
+    std::vector<std::string> keys;
+    for (auto it = data_base.createIterator(base::Bytes("b"), base::Database::Direction::BACKWARD); it.isValid();
+         it.next()) {
+        keys.push_back(it.key().toString());
+    }
+    BOOST_CHECK((keys == std::vector<std::string>{ "b4", "b2", "b1" }));
+
+    auto it = data_base.createIterator(base::Bytes("b"), base::Database::Direction::BACKWARD);
+    it.seek(base::Bytes("b3"));
+    BOOST_CHECK(it.isValid());
+    BOOST_CHECK_EQUAL(it.key().toString(), "b2");
+
+    auto last = data_base.createIterator(base::Bytes("c"), base::Database::Direction::BACKWARD);
+    BOOST_CHECK(last.isValid());
+    BOOST_CHECK_EQUAL(last.key().toString(), "c1");
+
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(data_base_snapshot_and_get_many)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+
+    auto data_base = base::createClearDatabaseInstance(path_to_data_base_folder);
+    data_base.put(base::Bytes("k1"), base::Bytes("v1"));
+    data_base.put(base::Bytes("k2"), base::Bytes("v2"));
+
+    auto snapshot = data_base.createSnapshot();
+    data_base.put(base::Bytes("k1"), base::Bytes("new v1"));
+    data_base.put(base::Bytes("k3"), base::Bytes("v3"));
+    data_base.remove(base::Bytes("k2"));
+
+    BOOST_CHECK_EQUAL(data_base.get(base::Bytes("k1"), snapshot).value().toString(), "v1");
+    BOOST_CHECK(data_base.exists(base::Bytes("k2"), snapshot));
+    BOOST_CHECK(!data_base.exists(base::Bytes("k3"), snapshot));
+    BOOST_CHECK(!data_base.exists(base::Bytes("k2")));
+    BOOST_CHECK(data_base.exists(base::Bytes("k3")));
+
+    std::size_t snapshot_count = 0;
+    for (auto it = data_base.createIterator(base::Bytes("k"), snapshot); it.isValid(); it.next()) {
+        ++snapshot_count;
+    }
+    BOOST_CHECK_EQUAL(snapshot_count, 2);
+
+    auto values = data_base.getMany({ base::Bytes("k3"), base::Bytes("k2"), base::Bytes("k1") });
+    BOOST_CHECK_EQUAL(values.size(), 3);
+    BOOST_CHECK_EQUAL(values[0].value().toString(), "v3");
+    BOOST_CHECK(!values[1]);
+    BOOST_CHECK_EQUAL(values[2].value().toString(), "new v1");
+
+    auto old_values = data_base.getMany({ base::Bytes("k2"), base::Bytes("k3") }, snapshot);
+    BOOST_CHECK_EQUAL(old_values[0].value().toString(), "v2");
+    BOOST_CHECK(!old_values[1]);
+
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
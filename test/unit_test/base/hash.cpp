@@ -3,6 +3,11 @@
 #include "base/bytes.hpp"
 #include "base/hash.hpp"
 
+#include <algorithm>
+#include <span>
+#include <string>
+#include <vector>
+
 
 BOOST_AUTO_TEST_CASE(sha256_hash)
 {
@@ -29,6 +34,76 @@ BOOST_AUTO_TEST_CASE(sha256_hash)
 }
 
 
+BOOST_AUTO_TEST_CASE(sha256_hash_padding_boundaries)
+{
+    BOOST_CHECK_EQUAL(base::Sha256::compute(base::Bytes("abc")).toHex(),
+                      "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    // 56 bytes, so the length goes to the second padding block
+    BOOST_CHECK_EQUAL(
+      base::Sha256::compute(base::Bytes("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq")).toHex(),
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    BOOST_CHECK_EQUAL(base::Sha256::compute(base::Bytes(std::string(1000000, 'a'))).toHex(),
+                      "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+
+BOOST_AUTO_TEST_CASE(sha256_compute_many)
+{
+    BOOST_CHECK(base::Sha256::computeMany({}).empty());
+
+    // sizes around block boundaries in shuffled order, so lanes get messages of different lengths
+    std::vector<base::Bytes> messages;
+    for (std::size_t i = 0; i < 300; ++i) {
+        base::Bytes message((i * 37) % 300);
+        for (std::size_t j = 0; j < message.size(); ++j) {
+            message[j] = static_cast<base::Byte>(i * 7 + j);
+        }
+        messages.push_back(std::move(message));
+    }
+    std::vector<base::BytesView> views(messages.begin(), messages.end());
+
+    auto hashes = base::Sha256::computeMany(views);
+    BOOST_REQUIRE_EQUAL(hashes.size(), messages.size());
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+        BOOST_CHECK_EQUAL(hashes[i], base::Sha256::compute(messages[i]));
+    }
+
+    const base::BytesView few[] = { views[1], views[0] };
+    auto few_hashes = base::Sha256::computeMany(few);
+    BOOST_REQUIRE_EQUAL(few_hashes.size(), 2);
+    BOOST_CHECK_EQUAL(few_hashes[0], hashes[1]);
+    BOOST_CHECK_EQUAL(few_hashes[1], hashes[0]);
+
+    auto part_hashes = base::Sha256::computeMany(std::span(views).subspan(100, 50));
+    BOOST_REQUIRE_EQUAL(part_hashes.size(), 50);
+    for (std::size_t i = 0; i < part_hashes.size(); ++i) {
+        BOOST_CHECK_EQUAL(part_hashes[i], hashes[100 + i]);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(sha256_hasher_by_parts)
+{
+    base::Bytes data(300);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<base::Byte>(i * 13);
+    }
+
+    base::Sha256Hasher hasher;
+    for (std::size_t size : { 0, 1, 55, 56, 63, 64, 65, 128, 300 }) {
+        auto expected = base::Sha256::compute(base::BytesView(data.getData(), size));
+        // parts cross block boundaries at different points
+        for (std::size_t part_size : { 1, 7, 64, 100 }) {
+            for (std::size_t offset = 0; offset < size; offset += part_size) {
+                hasher.update(data.getData() + offset, std::min(part_size, size - offset));
+            }
+            // the hasher starts over after finalize
+            BOOST_CHECK_EQUAL(hasher.finalize(), expected);
+        }
+    }
+}
+
+
 BOOST_AUTO_TEST_CASE(sha256_serialization)
 {
     auto target_hash =
@@ -84,3 +84,12 @@ BOOST_AUTO_TEST_CASE(property_tree_usage3)
 
     std::filesystem::remove("config.json");
 }
+
+
+BOOST_AUTO_TEST_CASE(property_tree_get_with_default)
+{
+    auto config = base::parseJson(R"({ "cache": { "size": 10 } })");
+    BOOST_CHECK_EQUAL(config.get<std::size_t>("cache.size", 5), 10);
+    BOOST_CHECK_EQUAL(config.get<std::size_t>("cache.depth", 5), 5);
+    BOOST_CHECK_THROW(base::parseJson(R"({ "size": "big" })").get<std::size_t>("size", 5), base::Error);
+}
@@ -1,5 +1,7 @@
 #include <boost/test/unit_test.hpp>
 
+#include "base/error.hpp"
+#include "base/hash.hpp"
 #include "base/serialization.hpp"
 
 #include <limits>
@@ -298,4 +300,134 @@ BOOST_AUTO_TEST_CASE(serialization_pair2)
     BOOST_CHECK(p1._value == p4._value);
     BOOST_CHECK(p2._value == p5._value);
     BOOST_CHECK(p3._value == p6._value);
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(serialization_bytes_view_points_into_archive)
+{
+    base::Bytes data("some bytes");
+    base::SerializationOArchive oa;
+    oa.serialize(data);
+    oa.serialize(std::uint32_t{ 7 });
+    const auto& raw = oa.getBytes();
+
+    base::SerializationIArchive ia{ base::BytesView(raw) };
+    auto view = ia.deserialize<base::BytesView>();
+    BOOST_CHECK(view == base::BytesView(data));
+    BOOST_CHECK(view.getData() >= raw.getData() && view.getData() + view.size() <= raw.getData() + raw.size());
+    BOOST_CHECK_EQUAL(ia.deserialize<std::uint32_t>(), 7);
+    BOOST_CHECK(base::fromBytes<base::Bytes>(raw.takePart(0, raw.size() - 4)) == data);
+}
+
+
+BOOST_AUTO_TEST_CASE(serialization_deserialize_past_end_throws)
+{
+    auto raw = base::toBytes(base::Bytes("some bytes"));
+    base::SerializationIArchive ia(base::BytesView(raw).takePart(0, raw.size() - 1));
+    BOOST_CHECK_THROW(ia.deserialize<base::Bytes>(), base::Error);
+}
+
+
+BOOST_AUTO_TEST_CASE(serialization_vectors_bulk_format)
+{
+    std::vector<std::uint32_t> numbers(1000);
+    for (std::size_t i = 0; i < numbers.size(); ++i) {
+        numbers[i] = static_cast<std::uint32_t>(i * 2654435761u);
+    }
+    std::vector<base::FixedBytes<4>> hashes{ base::FixedBytes<4>{ 1, 2, 3, 4 }, base::FixedBytes<4>{ 5, 6, 7, 8 } };
+
+    // bulk serialization must give the same bytes as serialization of elements one by one
+    base::SerializationOArchive oa;
+    oa.serialize(numbers.size());
+    for (auto x : numbers) {
+        oa.serialize(x);
+    }
+    oa.serialize(hashes.size());
+    for (const auto& x : hashes) {
+        oa.serialize(x);
+    }
+    BOOST_CHECK(base::toBytes(numbers) + base::toBytes(hashes) == oa.getBytes());
+
+    base::SerializationIArchive ia(oa.getBytes());
+    BOOST_CHECK(ia.deserialize<std::vector<std::uint32_t>>() == numbers);
+    BOOST_CHECK(ia.deserialize<std::vector<base::FixedBytes<4>>>() == hashes);
+}
+
+
+BOOST_AUTO_TEST_CASE(serialization_empty_vectors)
+{
+    for (auto encoding : { base::IntegerEncoding::FIXED, base::IntegerEncoding::COMPACT }) {
+        auto bytes = base::toBytes(std::vector<std::uint8_t>{}, encoding) +
+                     base::toBytes(std::vector<std::uint32_t>{}, encoding) +
+                     base::toBytes(std::vector<std::uint64_t>{}, encoding) +
+                     base::toBytes(std::vector<base::FixedBytes<32>>{}, encoding);
+        base::SerializationIArchive ia(bytes, encoding);
+        BOOST_CHECK(ia.deserialize<std::vector<std::uint8_t>>().empty());
+        BOOST_CHECK(ia.deserialize<std::vector<std::uint32_t>>().empty());
+        BOOST_CHECK(ia.deserialize<std::vector<std::uint64_t>>().empty());
+        BOOST_CHECK(ia.deserialize<std::vector<base::FixedBytes<32>>>().empty());
+        BOOST_CHECK_EQUAL(ia.getRemainingSize(), 0);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(serialization_vector_with_too_large_size_throws)
+{
+    auto raw = base::toBytes(std::size_t{ 1 } << 60) + base::Bytes("abc");
+    BOOST_CHECK_THROW(base::fromBytes<std::vector<std::uint64_t>>(raw), base::Error);
+    BOOST_CHECK_THROW(base::fromBytes<std::vector<std::string>>(raw), base::Error);
+}
+
+
+BOOST_AUTO_TEST_CASE(serialization_compact_integers)
+{
+    const std::vector<std::uint64_t> values{ 0, 1, 127, 128, 300, 16383, 16384, std::uint64_t{ 1 } << 63, ~0ull };
+    const std::vector<std::size_t> sizes{ 1, 1, 1, 2, 2, 2, 3, 10, 10 };
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        auto bytes = base::toBytes(values[i], base::IntegerEncoding::COMPACT);
+        BOOST_CHECK_EQUAL(bytes.size(), sizes[i]);
+        BOOST_CHECK_EQUAL(base::fromBytes<std::uint64_t>(bytes, base::IntegerEncoding::COMPACT), values[i]);
+    }
+    BOOST_CHECK(base::toBytes(std::uint64_t{ 300 }, base::IntegerEncoding::COMPACT) == base::Bytes({ 0xAC, 0x02 }));
+
+    // other integers and the fixed encoding are not changed
+    BOOST_CHECK_EQUAL(base::toBytes(std::uint32_t{ 1 }, base::IntegerEncoding::COMPACT).size(), 4);
+    BOOST_CHECK_EQUAL(base::toBytes(std::uint64_t{ 1 }).size(), 8);
+
+    auto bytes = base::toBytes(std::pair{ base::Bytes("abc"), values }, base::IntegerEncoding::COMPACT);
+    BOOST_CHECK_EQUAL(bytes.size(), 1 + 3 + 1 + 32);
+    base::SerializationIArchive ia(bytes, base::IntegerEncoding::COMPACT);
+    auto decoded = ia.deserialize<base::Bytes, std::vector<std::uint64_t>>();
+    BOOST_CHECK(decoded.first == base::Bytes("abc"));
+    BOOST_CHECK(decoded.second == values);
+}
+
+
+BOOST_AUTO_TEST_CASE(serialization_compact_integers_reject_malformed)
+{
+    auto decode = [](const base::Bytes& bytes) {
+        return base::fromBytes<std::uint64_t>(bytes, base::IntegerEncoding::COMPACT);
+    };
+    // not in the shortest form
+    BOOST_CHECK_THROW(decode(base::Bytes({ 0x80, 0x00 })), base::Error);
+    // more than 64 bits
+    BOOST_CHECK_THROW(decode(base::Bytes({ 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02 })), base::Error);
+    // unterminated
+    BOOST_CHECK_THROW(decode(base::Bytes({ 0x80 })), base::Error);
+}
+
+
+BOOST_AUTO_TEST_CASE(serialization_hash_archive)
+{
+    std::vector<base::Bytes> values{ base::Bytes("abc"), base::Bytes(100), base::Bytes{} };
+    auto value = std::pair{ std::uint64_t{ 42 }, values };
+
+    base::Sha256Hasher hasher;
+    base::SerializationOArchive oa{ hasher };
+    oa.serialize(value);
+    BOOST_CHECK_EQUAL(oa.size(), base::calcSerializedSize(value));
+    BOOST_CHECK(oa.getBytes().isEmpty());
+    BOOST_CHECK_EQUAL(hasher.finalize(), base::Sha256::compute(base::toBytes(value)));
+
+    BOOST_CHECK_EQUAL(base::Sha256::computeSerialized(value), base::Sha256::compute(base::toBytes(value)));
+    BOOST_CHECK_THROW(base::SerializationOArchive{ base::SerializationOArchive::Mode::HASH }, base::Error);
+}
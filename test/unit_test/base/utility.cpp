@@ -0,0 +1,64 @@
+#include <boost/test/unit_test.hpp>
+
+#include "base/utility.hpp"
+
+#include <string>
+
+BOOST_AUTO_TEST_CASE(lru_cache_put_and_find)
+{
+    base::LruCache<int, std::string> cache(3);
+    cache.put(1, "one");
+    cache.put(2, "two");
+    cache.put(3, "three");
+
+    BOOST_CHECK_EQUAL(cache.size(), 3);
+    BOOST_CHECK_EQUAL(cache.capacity(), 3);
+    BOOST_CHECK(cache.find(1));
+    BOOST_CHECK_EQUAL(cache.find(2)->get(), "two");
+    BOOST_CHECK(!cache.find(4));
+}
+
+
+BOOST_AUTO_TEST_CASE(lru_cache_evicts_least_recently_used)
+{
+    base::LruCache<int, std::string> cache(2);
+    cache.put(1, "one");
+    cache.put(2, "two");
+    BOOST_CHECK(cache.find(1)); // now 2 is the least recently used
+    cache.put(3, "three");
+
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    BOOST_CHECK(cache.find(1));
+    BOOST_CHECK(!cache.find(2));
+    BOOST_CHECK(cache.find(3));
+}
+
+
+BOOST_AUTO_TEST_CASE(lru_cache_update_and_erase)
+{
+    base::LruCache<int, std::string> cache(2);
+    cache.put(1, "one");
+    cache.put(1, "uno");
+    BOOST_CHECK_EQUAL(cache.size(), 1);
+    BOOST_CHECK_EQUAL(cache.find(1)->get(), "uno");
+
+    cache.find(1)->get() = "eins";
+    BOOST_CHECK_EQUAL(cache.find(1)->get(), "eins");
+
+    BOOST_CHECK(cache.erase(1));
+    BOOST_CHECK(!cache.erase(1));
+    BOOST_CHECK(!cache.find(1));
+
+    cache.put(2, "two");
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(lru_cache_zero_capacity)
+{
+    base::LruCache<int, std::string> cache(0);
+    cache.put(1, "one");
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    BOOST_CHECK(!cache.find(1));
+}
@@ -316,3 +316,60 @@ BOOST_AUTO_TEST_CASE(block_serialization2)
     BOOST_CHECK(block_tx_set.find(trans4));
     BOOST_CHECK(block_tx_set.find(trans5));
 }
+
+
+BOOST_AUTO_TEST_CASE(block_hash_is_reset_by_setters)
+{
+    bc::Block block(121, base::Sha256::compute(base::Bytes("prev")), base::Time(), miner_address, getTestSet());
+    block.setNonce(bc::NonceInt(1));
+    auto hash = block.getHash();
+    BOOST_CHECK(hash == base::Sha256::compute(base::toBytes(block)));
+
+    bc::Block copy = block;
+    BOOST_CHECK(copy.getHash() == hash);
+
+    block.setNonce(bc::NonceInt(2));
+    BOOST_CHECK(block.getHash() != hash);
+    BOOST_CHECK(block.getHash() == base::Sha256::compute(base::toBytes(block)));
+    BOOST_CHECK(base::fromBytes<bc::Block>(base::toBytes(block)).getNonce() == bc::NonceInt(2));
+
+    hash = block.getHash();
+    block.addTransaction(bc::Transaction{ bc::Address(base::generateKeys().first),
+                                          bc::Address(base::generateKeys().first),
+                                          777,
+                                          0,
+                                          base::Time(),
+                                          bc::Transaction::Type::MESSAGE_CALL,
+                                          base::Bytes{} });
+    BOOST_CHECK(block.getHash() != hash);
+    BOOST_CHECK(block.getHash() == base::Sha256::compute(base::toBytes(block)));
+}
+
+
+BOOST_AUTO_TEST_CASE(block_keeps_received_bytes)
+{
+    bc::Block block(121, base::Sha256::compute(base::Bytes("prev")), base::Time(), miner_address, getTestSet());
+    block.setNonce(bc::NonceInt(1));
+    base::Bytes message{ 0x7 };
+    message.append(base::toBytes(block));
+    base::SharedBytes received{ std::move(message) };
+
+    base::SerializationIArchive ia{ received };
+    BOOST_CHECK_EQUAL(ia.deserialize<base::Byte>(), 0x7);
+    auto received_block = bc::Block::deserialize(ia);
+    BOOST_CHECK(received_block == block);
+    BOOST_CHECK(received_block.getSerialized().getData() == received.getData() + 1);
+    BOOST_CHECK(received_block.getHash() == block.getHash());
+    BOOST_CHECK(received_block.getTransactions().begin()->getHash() == block.getTransactions().begin()->getHash());
+    BOOST_CHECK(base::toBytes(received_block) == base::toBytes(block));
+
+    received_block.setNonce(bc::NonceInt(2));
+    BOOST_CHECK(received_block.getHash() != block.getHash());
+    BOOST_CHECK(received_block.getHash() == base::Sha256::compute(base::toBytes(received_block)));
+
+    base::SharedBytes compact{ base::toBytes(block, base::IntegerEncoding::COMPACT) };
+    base::SerializationIArchive compact_ia{ compact, base::IntegerEncoding::COMPACT };
+    auto compact_block = bc::Block::deserialize(compact_ia);
+    BOOST_CHECK(compact_block.getHash() == block.getHash());
+    BOOST_CHECK(compact_block.getSerialized() == block.getSerialized());
+}
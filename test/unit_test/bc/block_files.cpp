@@ -0,0 +1,44 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bc/block_files.hpp"
+
+#include <filesystem>
+
+BOOST_AUTO_TEST_CASE(block_files_append_and_read)
+{
+    std::filesystem::path path_to_files_folder("local_test_block_files");
+    std::filesystem::remove_all(path_to_files_folder);
+    base::Bytes first("first record");
+    base::Bytes second("second record");
+    bc::BlockFiles::Location first_location{};
+    bc::BlockFiles::Location second_location{};
+    {
+        bc::BlockFiles files{ path_to_files_folder, 20 };
+        first_location = files.append(first);
+        second_location = files.append(second);
+        files.sync();
+        // the second record doesn't fit into the first file
+        BOOST_CHECK_EQUAL(first_location.file_index, 0);
+        BOOST_CHECK_EQUAL(second_location.file_index, 1);
+
+        auto first_view = files.read(first_location);
+        BOOST_REQUIRE(first_view);
+        BOOST_CHECK(first_view->toBytes() == first);
+        BOOST_CHECK(!files.read({ 1, 0, 100 }));
+    }
+    {
+        bc::BlockFiles files{ path_to_files_folder, 20 };
+        auto third_location = files.append(base::Bytes("third"));
+        files.sync();
+        BOOST_CHECK_EQUAL(third_location.file_index, 1);
+        BOOST_CHECK_EQUAL(third_location.offset, second.size());
+
+        auto second_view = files.read(second_location);
+        BOOST_REQUIRE(second_view);
+        files.removeFilesBefore(1);
+        BOOST_CHECK(!files.read(first_location));
+        BOOST_CHECK(second_view->toBytes() == second);
+        BOOST_CHECK(files.read(third_location)->toBytes() == base::Bytes("third"));
+    }
+    std::filesystem::remove_all(path_to_files_folder);
+}
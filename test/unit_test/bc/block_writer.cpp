@@ -0,0 +1,133 @@
+#include <boost/test/unit_test.hpp>
+
+#include "bc/block_writer.hpp"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+std::shared_ptr<const bc::Block> makeBlock(bc::BlockDepth depth)
+{
+    return std::make_shared<const bc::Block>(
+      bc::Block{ depth, base::Sha256::null(), base::Time(1000 + depth), bc::Address::null(), {} });
+}
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(block_writer_group_commit)
+{
+    std::mutex groups_mutex;
+    std::vector<std::size_t> groups_sizes;
+    {
+        bc::BlockWriter writer{ [&](const bc::BlockWriter::Blocks& blocks) {
+                                   std::lock_guard lk(groups_mutex);
+                                   groups_sizes.push_back(blocks.size());
+                               },
+                                bc::BlockWriter::CommitMode::GROUP,
+                                std::chrono::milliseconds{ 10000 },
+                                3 };
+
+        std::vector<std::shared_future<void>> written;
+        for (bc::BlockDepth depth = 0; depth < 5; ++depth) {
+            auto block = makeBlock(depth);
+            written.push_back(writer.enqueue(block->getHash(), block));
+        }
+
+        auto first_block = makeBlock(0);
+        auto last_block = makeBlock(4);
+        written[0].wait();
+        BOOST_CHECK(!writer.findPending(first_block->getHash()));
+        BOOST_CHECK(writer.findPending(last_block->getHash()));
+        // the last group isn't due yet, so it isn't written without a flush
+        BOOST_CHECK(writer.getWritten().wait_for(std::chrono::milliseconds{ 10 }) == std::future_status::timeout);
+
+        writer.flush().wait();
+        BOOST_CHECK(writer.getWritten().wait_for(std::chrono::seconds::zero()) == std::future_status::ready);
+        BOOST_CHECK(!writer.findPending(last_block->getHash()));
+    }
+
+    BOOST_CHECK((groups_sizes == std::vector<std::size_t>{ 3, 2 }));
+}
+
+
+BOOST_AUTO_TEST_CASE(block_writer_strict_commit)
+{
+    std::vector<std::size_t> groups_sizes;
+    {
+        bc::BlockWriter writer{ [&](const bc::BlockWriter::Blocks& blocks) { groups_sizes.push_back(blocks.size()); },
+                                bc::BlockWriter::CommitMode::STRICT,
+                                std::chrono::milliseconds{ 10000 },
+                                3 };
+        for (bc::BlockDepth depth = 0; depth < 4; ++depth) {
+            auto block = makeBlock(depth);
+            writer.enqueue(block->getHash(), block).get();
+        }
+    }
+
+    BOOST_CHECK((groups_sizes == std::vector<std::size_t>{ 1, 1, 1, 1 }));
+}
+
+
+BOOST_AUTO_TEST_CASE(block_writer_notifies_written_groups)
+{
+    std::mutex depths_mutex;
+    std::vector<bc::BlockDepth> written_depths;
+    {
+        bc::BlockWriter writer{ [](const bc::BlockWriter::Blocks&) {},
+                                bc::BlockWriter::CommitMode::GROUP,
+                                std::chrono::milliseconds{ 10000 },
+                                2,
+                                [&](const bc::BlockWriter::Blocks& blocks) {
+                                    std::lock_guard lk(depths_mutex);
+                                    written_depths.push_back(blocks.back().second->getDepth());
+                                } };
+        for (bc::BlockDepth depth = 0; depth < 5; ++depth) {
+            auto block = makeBlock(depth);
+            writer.enqueue(block->getHash(), block);
+        }
+        writer.flush().wait();
+    }
+
+    // every group is notified once and in the order of writing
+    BOOST_CHECK((written_depths == std::vector<bc::BlockDepth>{ 1, 3, 4 }));
+}
+
+
+BOOST_AUTO_TEST_CASE(block_writer_reports_failure)
+{
+    bc::BlockWriter writer{ [](const bc::BlockWriter::Blocks&) { RAISE_ERROR(base::DatabaseError, "write failed"); },
+                            bc::BlockWriter::CommitMode::STRICT,
+                            std::chrono::milliseconds{ 0 },
+                            1 };
+    auto block = makeBlock(0);
+    BOOST_CHECK_THROW(writer.enqueue(block->getHash(), block).get(), base::DatabaseError);
+}
+
+
+BOOST_AUTO_TEST_CASE(block_writer_stops_after_failure)
+{
+    std::size_t handler_calls = 0;
+    bc::BlockWriter writer{ [&](const bc::BlockWriter::Blocks&) {
+                               ++handler_calls;
+                               RAISE_ERROR(base::DatabaseError, "write failed");
+                           },
+                            bc::BlockWriter::CommitMode::GROUP,
+                            std::chrono::milliseconds{ 0 },
+                            1 };
+    auto first_block = makeBlock(0);
+    BOOST_CHECK_THROW(writer.enqueue(first_block->getHash(), first_block).get(), base::DatabaseError);
+
+    // later blocks are not written, so there is no gap after the failed one
+    auto second_block = makeBlock(1);
+    BOOST_CHECK_THROW(writer.enqueue(second_block->getHash(), second_block).get(), base::DatabaseError);
+    BOOST_CHECK_THROW(writer.flush().get(), base::DatabaseError);
+    BOOST_CHECK_THROW(writer.checkFailure(), base::DatabaseError);
+    BOOST_CHECK_EQUAL(handler_calls, 1);
+    BOOST_CHECK(writer.findPending(first_block->getHash()));
+    BOOST_CHECK(writer.findPending(second_block->getHash()));
+}
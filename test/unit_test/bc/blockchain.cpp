@@ -0,0 +1,438 @@
+#include <boost/test/unit_test.hpp>
+
+#include "base/property_tree.hpp"
+#include "base/database.hpp"
+#include "bc/blockchain.hpp"
+#include "bc/database_keys.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+const char* const PRUNED_CONFIG = R"({
+    "database": { "path": "local_test_base", "clean": false, "commit_mode": "strict" },
+    "blockchain": { "top_blocks_cache_size": 1, "recent_blocks_cache_size": 0, "prune_depth": 2 }
+})";
+
+
+const char* const PRUNED_FILES_CONFIG = R"({
+    "database": { "path": "local_test_base", "clean": false, "commit_mode": "strict" },
+    "blockchain": { "top_blocks_cache_size": 1, "recent_blocks_cache_size": 0, "prune_depth": 2,
+                    "block_storage": "files", "block_file_max_size": 1 }
+})";
+
+
+const char* const COMPACT_CONFIG = R"({
+    "database": { "path": "local_test_base", "clean": false, "commit_mode": "strict" },
+    "blockchain": { "top_blocks_cache_size": 1, "recent_blocks_cache_size": 0, "block_encoding": "compact" }
+})";
+
+
+const char* const FIXED_CONFIG = R"({
+    "database": { "path": "local_test_base", "clean": false, "commit_mode": "strict" },
+    "blockchain": { "top_blocks_cache_size": 1, "recent_blocks_cache_size": 0, "block_encoding": "fixed" }
+})";
+
+
+bc::Transaction makeTransaction(bc::BlockDepth depth)
+{
+    return bc::Transaction{ bc::Address::null(),
+                            bc::Address::null(),
+                            depth,
+                            0,
+                            base::Time(1000 + depth),
+                            bc::Transaction::Type::MESSAGE_CALL,
+                            base::Bytes{} };
+}
+
+
+bc::Block makeBlock(bc::BlockDepth depth, const base::Sha256& prev_block_hash)
+{
+    bc::TransactionsSet txs;
+    txs.add(makeTransaction(depth));
+    bc::Block block{ depth, prev_block_hash, base::Time(1000 + depth), bc::Address::null(), std::move(txs) };
+    block.setNonce(depth);
+    return block;
+}
+
+
+// blocks are pruned in background, so a test waits until a body of a given block is dropped
+bool waitForPruning(const bc::Blockchain& blockchain, const base::Sha256& block_hash)
+{
+    for (int attempt = 0; attempt < 500; ++attempt) {
+        if (!blockchain.findBlock(block_hash)) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+    }
+    return false;
+}
+
+
+// hashes of blocks kept by the depth index, in order of their keys
+std::vector<base::Sha256> readDepthIndex(base::Database& database)
+{
+    std::vector<base::Sha256> hashes;
+    auto prefix = bc::toDatabaseKey(bc::DataType::BLOCK_HASH_BY_DEPTH, base::Bytes{});
+    for (auto it = database.createIterator(prefix); it.isValid(); it.next()) {
+        hashes.emplace_back(it.value());
+    }
+    return hashes;
+}
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(blockchain_prunes_bodies_of_old_blocks)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    std::filesystem::remove_all(path_to_data_base_folder);
+    auto config = base::parseJson(PRUNED_CONFIG);
+
+    std::vector<base::Sha256> hashes;
+    {
+        bc::Blockchain blockchain{ config };
+        auto genesis = makeBlock(0, base::Sha256(base::Bytes(32)));
+        blockchain.addGenesisBlock(genesis);
+        hashes.push_back(base::Sha256::compute(base::toBytes(genesis)));
+        for (bc::BlockDepth depth = 1; depth < 6; ++depth) {
+            auto block = makeBlock(depth, hashes.back());
+            BOOST_REQUIRE(blockchain.tryAddBlock(block));
+            hashes.push_back(base::Sha256::compute(base::toBytes(block)));
+        }
+        blockchain.flush().wait();
+        BOOST_REQUIRE(waitForPruning(blockchain, hashes[3]));
+
+        BOOST_CHECK(!blockchain.findBlock(hashes[0]));
+        BOOST_CHECK(!blockchain.findBlock(hashes[1]));
+        BOOST_CHECK(!blockchain.findTransaction(base::Sha256::compute(base::toBytes(makeTransaction(1)))));
+        BOOST_CHECK(blockchain.hasTransaction(base::Sha256::compute(base::toBytes(makeTransaction(1)))));
+        BOOST_CHECK(blockchain.findBlock(hashes[4]));
+
+        auto header = blockchain.findBlockHeader(hashes[3]);
+        BOOST_REQUIRE(header);
+        BOOST_CHECK_EQUAL(header->getDepth(), 3);
+        BOOST_CHECK(header->getPrevBlockHash() == hashes[2]);
+        BOOST_CHECK(header->getTransactions().isEmpty());
+    }
+    {
+        bc::Blockchain blockchain{ config };
+        blockchain.load();
+        BOOST_CHECK_EQUAL(blockchain.getTopBlock()->getDepth(), 5);
+        BOOST_CHECK(blockchain.findBlockHashByDepth(2) == hashes[2]);
+        BOOST_CHECK(!blockchain.findBlock(hashes[3]));
+        BOOST_CHECK(blockchain.findBlock(hashes[5]));
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(blockchain_keeps_bodies_after_pruning_limit)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    std::filesystem::remove_all(path_to_data_base_folder);
+
+    {
+        bc::Blockchain blockchain{ base::parseJson(PRUNED_CONFIG) };
+        blockchain.setPruningLimit(1);
+        std::vector<base::Sha256> hashes;
+        auto genesis = makeBlock(0, base::Sha256(base::Bytes(32)));
+        blockchain.addGenesisBlock(genesis);
+        hashes.push_back(genesis.getHash());
+        for (bc::BlockDepth depth = 1; depth < 6; ++depth) {
+            auto block = makeBlock(depth, hashes.back());
+            BOOST_REQUIRE(blockchain.tryAddBlock(block));
+            hashes.push_back(block.getHash());
+        }
+        blockchain.flush().wait();
+
+        // blocks up to the limit are pruned by a single pass, so later ones are kept after it
+        BOOST_REQUIRE(waitForPruning(blockchain, hashes[1]));
+        BOOST_CHECK(blockchain.findBlock(hashes[2]));
+        BOOST_CHECK(blockchain.findBlock(hashes[3]));
+
+        blockchain.setPruningLimit(2);
+        BOOST_REQUIRE(waitForPruning(blockchain, hashes[2]));
+        BOOST_CHECK(blockchain.findBlock(hashes[3]));
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(blockchain_keeps_blocks_in_files)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    std::filesystem::remove_all(path_to_data_base_folder);
+    auto config = base::parseJson(PRUNED_FILES_CONFIG);
+
+    std::vector<base::Sha256> hashes;
+    {
+        bc::Blockchain blockchain{ config };
+        auto genesis = makeBlock(0, base::Sha256(base::Bytes(32)));
+        blockchain.addGenesisBlock(genesis);
+        hashes.push_back(base::Sha256::compute(base::toBytes(genesis)));
+        for (bc::BlockDepth depth = 1; depth < 6; ++depth) {
+            auto block = makeBlock(depth, hashes.back());
+            BOOST_REQUIRE(blockchain.tryAddBlock(block));
+            hashes.push_back(base::Sha256::compute(base::toBytes(block)));
+        }
+        blockchain.flush().wait();
+        BOOST_REQUIRE(waitForPruning(blockchain, hashes[3]));
+    }
+    // every block gets its own file, files of pruned blocks are removed
+    BOOST_CHECK(!std::filesystem::exists(path_to_data_base_folder / "blocks" / "blocks_000000.dat"));
+    BOOST_CHECK(std::filesystem::exists(path_to_data_base_folder / "blocks" / "blocks_000004.dat"));
+    {
+        bc::Blockchain blockchain{ config };
+        blockchain.load();
+        BOOST_CHECK_EQUAL(blockchain.getTopBlock()->getDepth(), 5);
+        BOOST_CHECK(!blockchain.findBlock(hashes[2]));
+        BOOST_CHECK(blockchain.findBlockHeader(hashes[2]));
+        auto block = blockchain.findBlock(hashes[4]);
+        BOOST_REQUIRE(block);
+        BOOST_CHECK(*block == makeBlock(4, hashes[3]));
+    }
+    {
+        // the storage of blocks is kept by the database, so it isn't changed by a config
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        blockchain.load();
+        BOOST_CHECK_EQUAL(blockchain.getTopBlock()->getDepth(), 5);
+        auto block = blockchain.findBlock(hashes[4]);
+        BOOST_REQUIRE(block);
+        BOOST_CHECK(*block == makeBlock(4, hashes[3]));
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(blockchain_keeps_encoding_of_database)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    std::filesystem::remove_all(path_to_data_base_folder);
+
+    std::vector<base::Sha256> hashes;
+    {
+        bc::Blockchain blockchain{ base::parseJson(COMPACT_CONFIG) };
+        auto genesis = makeBlock(0, base::Sha256(base::Bytes(32)));
+        blockchain.addGenesisBlock(genesis);
+        hashes.push_back(genesis.getHash());
+        for (bc::BlockDepth depth = 1; depth < 4; ++depth) {
+            auto block = makeBlock(depth, hashes.back());
+            BOOST_REQUIRE(blockchain.tryAddBlock(block));
+            hashes.push_back(block.getHash());
+        }
+        blockchain.flush().wait();
+    }
+    // the encoding was chosen when the database was created, so a changed option doesn't break reading
+    {
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        blockchain.load();
+        BOOST_CHECK_EQUAL(blockchain.getTopBlock()->getDepth(), 3);
+        auto block = blockchain.findBlock(hashes[1]);
+        BOOST_REQUIRE(block);
+        BOOST_CHECK(*block == makeBlock(1, hashes[0]));
+        BOOST_CHECK(block->getHash() == hashes[1]);
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(blockchain_top_block_outlives_eviction)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    std::filesystem::remove_all(path_to_data_base_folder);
+    {
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        auto genesis = makeBlock(0, base::Sha256(base::Bytes(32)));
+        blockchain.addGenesisBlock(genesis);
+        auto top_block = blockchain.getTopBlock();
+
+        // only one block is kept in memory, so the genesis is dropped by the chain
+        BOOST_REQUIRE(blockchain.tryAddBlock(makeBlock(1, genesis.getHash())));
+        BOOST_CHECK_EQUAL(blockchain.getTopBlock()->getDepth(), 1);
+        BOOST_CHECK(*top_block == genesis);
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(blockchain_finds_transactions_by_hash)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    std::filesystem::remove_all(path_to_data_base_folder);
+
+    auto genesis = makeBlock(0, base::Sha256(base::Bytes(32)));
+    // the second transaction of a block is found by its index as well
+    bc::TransactionsSet txs;
+    txs.add(makeTransaction(1));
+    txs.add(makeTransaction(100));
+    bc::Block block{ 1, genesis.getHash(), base::Time(1001), bc::Address::null(), std::move(txs) };
+    auto next_block = makeBlock(2, block.getHash());
+    const auto tx_hash = makeTransaction(100).getHash();
+    {
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        blockchain.addGenesisBlock(genesis);
+        BOOST_REQUIRE(blockchain.tryAddBlock(block));
+
+        auto tx = blockchain.findTransaction(tx_hash);
+        BOOST_REQUIRE(tx);
+        BOOST_CHECK(*tx == makeTransaction(100));
+
+        // only one block is kept in memory, so the transaction is read from the database
+        BOOST_REQUIRE(blockchain.tryAddBlock(next_block));
+        blockchain.flush().wait();
+        tx = blockchain.findTransaction(tx_hash);
+        BOOST_REQUIRE(tx);
+        BOOST_CHECK(*tx == makeTransaction(100));
+        BOOST_CHECK(blockchain.findTransaction(makeTransaction(0).getHash()));
+
+        BOOST_CHECK(!blockchain.findTransaction(makeTransaction(3).getHash()));
+    }
+    {
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        blockchain.load();
+        auto tx = blockchain.findTransaction(tx_hash);
+        BOOST_REQUIRE(tx);
+        BOOST_CHECK(*tx == makeTransaction(100));
+        BOOST_CHECK(blockchain.findTransaction(makeTransaction(2).getHash()));
+        BOOST_CHECK(!blockchain.findTransaction(makeTransaction(3).getHash()));
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(blockchain_has_mined_transactions)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    std::filesystem::remove_all(path_to_data_base_folder);
+
+    // core rejects a transaction that the chain already has, so a mined transaction can't be replayed
+    auto genesis = makeBlock(0, base::Sha256(base::Bytes(32)));
+    auto block = makeBlock(1, genesis.getHash());
+    auto replayed_tx = makeTransaction(1);
+    // the same transfer with another fee
+    bc::Transaction new_tx{ bc::Address::null(),
+                            bc::Address::null(),
+                            1,
+                            1,
+                            base::Time(1001),
+                            bc::Transaction::Type::MESSAGE_CALL,
+                            base::Bytes{} };
+    {
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        blockchain.addGenesisBlock(genesis);
+        BOOST_CHECK(!blockchain.hasTransaction(replayed_tx.getHash()));
+        BOOST_REQUIRE(blockchain.tryAddBlock(block));
+        BOOST_CHECK(blockchain.hasTransaction(replayed_tx.getHash()));
+        BOOST_CHECK(!blockchain.hasTransaction(new_tx.getHash()));
+    }
+    {
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        blockchain.load();
+        BOOST_CHECK(blockchain.hasTransaction(replayed_tx.getHash()));
+        BOOST_CHECK(blockchain.hasTransaction(makeTransaction(0).getHash()));
+        BOOST_CHECK(!blockchain.hasTransaction(new_tx.getHash()));
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(blockchain_builds_depth_index_of_old_database)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    std::filesystem::remove_all(path_to_data_base_folder);
+
+    std::vector<base::Sha256> hashes;
+    {
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        auto genesis = makeBlock(0, base::Sha256(base::Bytes(32)));
+        blockchain.addGenesisBlock(genesis);
+        hashes.push_back(genesis.getHash());
+        for (bc::BlockDepth depth = 1; depth < 5; ++depth) {
+            auto block = makeBlock(depth, hashes.back());
+            BOOST_REQUIRE(blockchain.tryAddBlock(block));
+            hashes.push_back(block.getHash());
+        }
+    }
+    {
+        // a database written before blocks got indexed by depth has no such keys
+        auto database = base::createDefaultDatabaseInstance(base::Directory(path_to_data_base_folder));
+        BOOST_REQUIRE(readDepthIndex(database) == hashes);
+        base::Database::WriteBatch batch;
+        auto prefix = bc::toDatabaseKey(bc::DataType::BLOCK_HASH_BY_DEPTH, base::Bytes{});
+        for (auto it = database.createIterator(prefix); it.isValid(); it.next()) {
+            batch.remove(it.key());
+        }
+        database.write(batch);
+        BOOST_REQUIRE(readDepthIndex(database).empty());
+    }
+    {
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        blockchain.load();
+        BOOST_CHECK_EQUAL(blockchain.getTopBlock()->getDepth(), 4);
+        for (bc::BlockDepth depth = 0; depth < hashes.size(); ++depth) {
+            BOOST_CHECK(blockchain.findBlockHashByDepth(depth) == hashes[depth]);
+        }
+        BOOST_CHECK(blockchain.findBlock(hashes[1]));
+    }
+    {
+        auto database = base::createDefaultDatabaseInstance(base::Directory(path_to_data_base_folder));
+        BOOST_CHECK(readDepthIndex(database) == hashes);
+    }
+    {
+        // the built index is loaded as any other one
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        blockchain.load();
+        BOOST_CHECK_EQUAL(blockchain.getTopBlock()->getDepth(), 4);
+        BOOST_CHECK(blockchain.findBlockHashByDepth(2) == hashes[2]);
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(blockchain_keeps_written_blocks_added_before_load)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    std::filesystem::remove_all(path_to_data_base_folder);
+
+    auto genesis = makeBlock(0, base::Sha256(base::Bytes(32)));
+    std::vector<base::Sha256> hashes{ genesis.getHash() };
+    {
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        blockchain.addGenesisBlock(genesis);
+        for (bc::BlockDepth depth = 1; depth < 4; ++depth) {
+            auto block = makeBlock(depth, hashes.back());
+            BOOST_REQUIRE(blockchain.tryAddBlock(block));
+            hashes.push_back(block.getHash());
+        }
+    }
+    {
+        // the genesis is added before the chain is loaded, so the writer looks it up on disk and skips it
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        BOOST_REQUIRE(blockchain.tryAddBlock(genesis));
+        blockchain.flush().wait();
+        blockchain.load();
+        BOOST_CHECK_EQUAL(blockchain.getTopBlock()->getDepth(), 3);
+    }
+    {
+        // without the depth index the chain is walked back from the last written block, which is not the genesis
+        auto database = base::createDefaultDatabaseInstance(base::Directory(path_to_data_base_folder));
+        base::Database::WriteBatch batch;
+        auto prefix = bc::toDatabaseKey(bc::DataType::BLOCK_HASH_BY_DEPTH, base::Bytes{});
+        for (auto it = database.createIterator(prefix); it.isValid(); it.next()) {
+            batch.remove(it.key());
+        }
+        database.write(batch);
+    }
+    {
+        bc::Blockchain blockchain{ base::parseJson(FIXED_CONFIG) };
+        blockchain.load();
+        BOOST_CHECK_EQUAL(blockchain.getTopBlock()->getDepth(), 3);
+        BOOST_CHECK(blockchain.findBlockHashByDepth(3) == hashes[3]);
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
@@ -1,5 +1,6 @@
 #include <boost/test/unit_test.hpp>
 
+#include "bc/block.hpp"
 #include "bc/transaction.hpp"
 
 
@@ -56,6 +57,23 @@ BOOST_AUTO_TEST_CASE(transaction_constructor_move)
 }
 
 
+BOOST_AUTO_TEST_CASE(transaction_nothrow_move)
+{
+    // otherwise vectors of transactions copy them on reallocation
+    static_assert(std::is_nothrow_move_constructible_v<bc::Transaction>);
+    static_assert(std::is_nothrow_move_assignable_v<bc::Transaction>);
+    static_assert(std::is_nothrow_move_constructible_v<bc::Block>);
+
+    bc::Transaction tx{ bc::Address::null(), bc::Address::null(), 1, 1, base::Time::now(),
+                        bc::Transaction::Type::MESSAGE_CALL, base::Bytes{} };
+    auto hash = tx.getHash();
+    std::vector<bc::Transaction> txs;
+    txs.push_back(std::move(tx));
+    txs.reserve(txs.capacity() + 1);
+    BOOST_CHECK(txs.front().getHash() == hash);
+}
+
+
 BOOST_AUTO_TEST_CASE(transaction_operator_equal_copy)
 {
     bc::Address from = bc::Address(base::generateKeys().first);
@@ -195,3 +213,23 @@ BOOST_AUTO_TEST_CASE(transaction_builder_set_all2)
     BOOST_CHECK(tx1.getAmount() == amount);
     BOOST_CHECK(tx1.getFee() == fee);
 }
+
+
+BOOST_AUTO_TEST_CASE(transaction_hash_is_reset_by_sign)
+{
+    auto [pub_key, priv_key] = base::generateKeys();
+    bc::Transaction tx(bc::Address(pub_key),
+                       bc::Address(base::generateKeys().first),
+                       100,
+                       1,
+                       base::Time::now(),
+                       bc::Transaction::Type::MESSAGE_CALL,
+                       base::Bytes{});
+    auto unsigned_hash = tx.getHash();
+    BOOST_CHECK(unsigned_hash == base::Sha256::compute(base::toBytes(tx)));
+
+    tx.sign(pub_key, priv_key);
+    BOOST_CHECK(tx.getHash() != unsigned_hash);
+    BOOST_CHECK(tx.getHash() == base::Sha256::compute(base::toBytes(tx)));
+    BOOST_CHECK(base::fromBytes<bc::Transaction>(base::toBytes(tx)).checkSign());
+}
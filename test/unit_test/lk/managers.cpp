@@ -0,0 +1,263 @@
+#include <boost/test/unit_test.hpp>
+
+#include "lk/managers.hpp"
+
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+
+const bc::Address FIRST_ADDRESS{ base::Bytes(bc::Address::ADDRESS_BYTES_LENGTH) };
+const bc::Address SECOND_ADDRESS{ base::Bytes("11111111111111111111") };
+const base::Sha256 STORAGE_KEY{ base::Sha256::compute(base::Bytes("key")) };
+const base::Sha256 OLD_STORAGE_KEY{ base::Sha256::compute(base::Bytes("old key")) };
+
+
+// state changes of four blocks over a committed account, returns the state root after each block
+std::vector<base::Sha256> applyBlocks(base::Database& database, bool is_flushed_by_block)
+{
+    lk::AccountManager manager{ database, 10, 10 };
+    manager.getAccount(FIRST_ADDRESS).setStorageValue(OLD_STORAGE_KEY, base::Bytes("old value"));
+    base::Database::WriteBatch committed_batch;
+    manager.flush(committed_batch);
+    database.write(committed_batch);
+
+    std::vector<base::Sha256> roots;
+    auto end_block = [&] {
+        if (is_flushed_by_block) {
+            base::Database::WriteBatch batch;
+            roots.push_back(manager.flush(batch));
+            database.write(batch);
+        }
+        else {
+            roots.push_back(manager.updateStateRoot());
+        }
+    };
+
+    manager.getAccount(FIRST_ADDRESS).setBalance(100);
+    manager.getAccount(FIRST_ADDRESS).setStorageValue(STORAGE_KEY, base::Bytes("value"));
+    end_block();
+    manager.getAccount(SECOND_ADDRESS).setBalance(200);
+    end_block();
+    BOOST_CHECK(manager.deleteAccount(FIRST_ADDRESS));
+    end_block();
+    // records of the deleted account may be still in database, but they are not read back
+    BOOST_CHECK(!manager.hasAccount(FIRST_ADDRESS));
+    manager.newAccount(FIRST_ADDRESS, base::Sha256::null());
+    BOOST_CHECK(!manager.getAccount(FIRST_ADDRESS).checkStorageValue(OLD_STORAGE_KEY));
+    manager.getAccount(FIRST_ADDRESS).setBalance(100);
+    end_block();
+
+    base::Database::WriteBatch batch;
+    BOOST_CHECK(manager.flush(batch) == roots.back());
+    database.write(batch);
+    return roots;
+}
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(account_manager_reads_evicted_accounts_from_database)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    {
+        auto database = base::createClearDatabaseInstance(path_to_data_base_folder);
+        lk::AccountManager manager{ database, 1, 1 };
+
+        manager.getAccount(FIRST_ADDRESS).setBalance(100);
+        manager.getAccount(FIRST_ADDRESS).setStorageValue(STORAGE_KEY, base::Bytes("value"));
+        manager.getAccount(SECOND_ADDRESS).setBalance(200);
+        base::Database::WriteBatch batch;
+        manager.flush(batch);
+        database.write(batch);
+        manager.shrink();
+
+        BOOST_CHECK(manager.hasAccount(FIRST_ADDRESS));
+        BOOST_CHECK_EQUAL(manager.getBalance(FIRST_ADDRESS), 100);
+        BOOST_CHECK_EQUAL(manager.getBalance(SECOND_ADDRESS), 200);
+        BOOST_CHECK(manager.getAccount(FIRST_ADDRESS).checkStorageValue(STORAGE_KEY));
+        BOOST_CHECK_EQUAL(manager.getAccount(FIRST_ADDRESS).getStorageValue(STORAGE_KEY).data.toString(), "value");
+    }
+    {
+        auto database = base::createDefaultDatabaseInstance(path_to_data_base_folder);
+        lk::AccountManager manager{ database, 1, 1 };
+        BOOST_CHECK_EQUAL(manager.getBalance(FIRST_ADDRESS), 100);
+        BOOST_CHECK(manager.getAccount(FIRST_ADDRESS).checkStorageValue(STORAGE_KEY));
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(account_manager_deletes_account_storage)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    {
+        auto database = base::createClearDatabaseInstance(path_to_data_base_folder);
+        lk::AccountManager manager{ database, 10, 10 };
+
+        manager.newAccount(FIRST_ADDRESS, base::Sha256::null());
+        manager.getAccount(FIRST_ADDRESS).setStorageValue(STORAGE_KEY, base::Bytes("value"));
+        base::Database::WriteBatch first_batch;
+        manager.flush(first_batch);
+        database.write(first_batch);
+
+        BOOST_CHECK(manager.deleteAccount(FIRST_ADDRESS));
+        BOOST_CHECK(!manager.hasAccount(FIRST_ADDRESS));
+        manager.newAccount(FIRST_ADDRESS, base::Sha256::null());
+        BOOST_CHECK(!manager.getAccount(FIRST_ADDRESS).checkStorageValue(STORAGE_KEY));
+        base::Database::WriteBatch second_batch;
+        manager.flush(second_batch);
+        database.write(second_batch);
+    }
+    {
+        auto database = base::createDefaultDatabaseInstance(path_to_data_base_folder);
+        lk::AccountManager manager{ database, 10, 10 };
+        BOOST_CHECK(manager.hasAccount(FIRST_ADDRESS));
+        BOOST_CHECK(!manager.getAccount(FIRST_ADDRESS).checkStorageValue(STORAGE_KEY));
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(account_manager_state_root_depends_only_on_state)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    base::Sha256 first_root{ base::Sha256::null() };
+    {
+        auto database = base::createClearDatabaseInstance(path_to_data_base_folder);
+        lk::AccountManager manager{ database, 10, 10 };
+        BOOST_CHECK(manager.getStateRoot() == base::Sha256::null());
+
+        manager.getAccount(FIRST_ADDRESS).setBalance(100);
+        manager.getAccount(SECOND_ADDRESS).setStorageValue(STORAGE_KEY, base::Bytes("value"));
+        base::Database::WriteBatch first_batch;
+        first_root = manager.flush(first_batch);
+        database.write(first_batch);
+        BOOST_CHECK(first_root == manager.getStateRoot());
+        BOOST_CHECK(first_root != base::Sha256::null());
+
+        manager.getAccount(FIRST_ADDRESS).setBalance(200);
+        base::Database::WriteBatch second_batch;
+        auto second_root = manager.flush(second_batch);
+        database.write(second_batch);
+        BOOST_CHECK(second_root != first_root);
+
+        // the same state gives the same root, no matter how it was reached
+        manager.getAccount(FIRST_ADDRESS).setBalance(100);
+        base::Database::WriteBatch third_batch;
+        BOOST_CHECK(manager.flush(third_batch) == first_root);
+        database.write(third_batch);
+    }
+    {
+        auto database = base::createDefaultDatabaseInstance(path_to_data_base_folder);
+        lk::AccountManager manager{ database, 10, 10 };
+        BOOST_CHECK(manager.getStateRoot() == first_root);
+
+        BOOST_CHECK(manager.deleteAccount(FIRST_ADDRESS));
+        BOOST_CHECK(manager.deleteAccount(SECOND_ADDRESS));
+        base::Database::WriteBatch batch;
+        BOOST_CHECK(manager.flush(batch) == base::Sha256::null());
+        database.write(batch);
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(account_manager_updates_state_root_by_block)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    std::vector<base::Sha256> flushed_roots;
+    {
+        auto database = base::createClearDatabaseInstance(path_to_data_base_folder);
+        flushed_roots = applyBlocks(database, true);
+    }
+    std::vector<base::Sha256> roots;
+    {
+        auto database = base::createClearDatabaseInstance(path_to_data_base_folder);
+        roots = applyBlocks(database, false);
+    }
+    // roots of blocks, that are kept in memory, are the same as if every block was written
+    BOOST_CHECK(roots == flushed_roots);
+    BOOST_CHECK_EQUAL(roots.size(), 4);
+    for (std::size_t i = 1; i < roots.size(); ++i) {
+        BOOST_CHECK(roots[i] != roots[i - 1]);
+    }
+    {
+        auto database = base::createDefaultDatabaseInstance(path_to_data_base_folder);
+        lk::AccountManager manager{ database, 10, 10 };
+        BOOST_CHECK(manager.getStateRoot() == roots.back());
+        BOOST_CHECK(manager.hasAccount(FIRST_ADDRESS));
+        BOOST_CHECK(!manager.getAccount(FIRST_ADDRESS).checkStorageValue(STORAGE_KEY));
+        BOOST_CHECK(!manager.getAccount(FIRST_ADDRESS).checkStorageValue(OLD_STORAGE_KEY));
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(code_manager_keeps_codes_in_database)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    base::Bytes code("contract code");
+    auto code_hash = base::Sha256::compute(code);
+    {
+        auto database = base::createClearDatabaseInstance(path_to_data_base_folder);
+        lk::CodeManager manager{ database, 0 };
+
+        manager.saveCode(code);
+        auto pending_code = manager.getCode(code_hash);
+        BOOST_REQUIRE(pending_code);
+        BOOST_CHECK(*pending_code == code);
+
+        base::Database::WriteBatch batch;
+        manager.flush(batch);
+        database.write(batch);
+        BOOST_CHECK(*pending_code == code);
+        BOOST_CHECK(!manager.getCode(base::Sha256::compute(base::Bytes("other code"))));
+    }
+    {
+        auto database = base::createDefaultDatabaseInstance(path_to_data_base_folder);
+        lk::CodeManager manager{ database, 1 };
+        auto code_from_database = manager.getCode(code_hash);
+        BOOST_REQUIRE(code_from_database);
+        BOOST_CHECK(*code_from_database == code);
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
+
+
+BOOST_AUTO_TEST_CASE(output_manager_removes_expired_outputs)
+{
+    std::filesystem::path path_to_data_base_folder("local_test_base");
+    auto first_tx_hash = base::Sha256::compute(base::Bytes("first tx"));
+    auto second_tx_hash = base::Sha256::compute(base::Bytes("second tx"));
+    {
+        auto database = base::createClearDatabaseInstance(path_to_data_base_folder);
+        lk::OutputManager manager{ database, 1, 2 };
+
+        manager.saveOutput(first_tx_hash, 1, base::Bytes("first output"));
+        BOOST_CHECK_EQUAL(manager.getOutput(first_tx_hash)->toString(), "first output");
+        base::Database::WriteBatch first_batch;
+        manager.flush(first_batch, 1);
+        database.write(first_batch);
+
+        manager.saveOutput(second_tx_hash, 2, base::Bytes("second output"));
+        base::Database::WriteBatch second_batch;
+        manager.flush(second_batch, 2);
+        database.write(second_batch);
+        BOOST_CHECK_EQUAL(manager.getOutput(first_tx_hash)->toString(), "first output");
+        BOOST_CHECK(!manager.getOutput(base::Sha256::null()));
+    }
+    {
+        auto database = base::createDefaultDatabaseInstance(path_to_data_base_folder);
+        lk::OutputManager manager{ database, 1, 2 };
+        BOOST_CHECK_EQUAL(manager.getOutput(first_tx_hash)->toString(), "first output");
+
+        base::Database::WriteBatch batch;
+        manager.flush(batch, 3);
+        database.write(batch);
+        BOOST_CHECK(!manager.getOutput(first_tx_hash));
+        BOOST_CHECK_EQUAL(manager.getOutput(second_tx_hash)->toString(), "second output");
+    }
+    std::filesystem::remove_all(path_to_data_base_folder);
+}
@@ -0,0 +1,141 @@
+#include <boost/test/unit_test.hpp>
+
+#include "base/error.hpp"
+#include "base/property_tree.hpp"
+#include "bc/blockchain.hpp"
+#include "bc/database_keys.hpp"
+#include "lk/core.hpp"
+#include "lk/managers.hpp"
+#include "lk/snapshot.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+
+const char* const SOURCE_CONFIG = R"({
+    "database": { "path": "local_test_base", "clean": false, "commit_mode": "strict" }
+})";
+
+
+const char* const TARGET_CONFIG = R"({
+    "database": { "path": "local_test_base_imported", "clean": false, "commit_mode": "strict" },
+    "blockchain": { "block_storage": "files" }
+})";
+
+
+const char* const SNAPSHOT_PATH = "local_test_snapshot.dat";
+
+const bc::Address ACCOUNT_ADDRESS{ base::Bytes("11111111111111111111") };
+const base::Sha256 STORAGE_KEY{ base::Sha256::compute(base::Bytes("key")) };
+
+
+bc::Block makeBlock(bc::BlockDepth depth, const base::Sha256& prev_block_hash)
+{
+    bc::TransactionsSet txs;
+    txs.add(bc::Transaction{ bc::Address::null(),
+                             ACCOUNT_ADDRESS,
+                             depth,
+                             0,
+                             base::Time(1000 + depth),
+                             bc::Transaction::Type::MESSAGE_CALL,
+                             base::Bytes{} });
+    bc::Block block{ depth, prev_block_hash, base::Time(1000 + depth), bc::Address::null(), std::move(txs) };
+    block.setNonce(depth);
+    return block;
+}
+
+
+// makes a chain of a few blocks with a committed state of the top one, returns hashes of blocks
+std::vector<base::Sha256> makeSourceDatabase(const base::PropertyTree& config, base::Sha256& state_root)
+{
+    std::filesystem::remove_all(config.get<std::string>("database.path"));
+    bc::Blockchain blockchain{ config };
+    blockchain.addGenesisBlock(lk::Core::getGenesisBlock());
+    std::vector<base::Sha256> hashes{ base::Sha256::compute(base::toBytes(lk::Core::getGenesisBlock())) };
+    for (bc::BlockDepth depth = 1; depth < 4; ++depth) {
+        auto block = makeBlock(depth, hashes.back());
+        BOOST_REQUIRE(blockchain.tryAddBlock(block));
+        hashes.push_back(base::Sha256::compute(base::toBytes(block)));
+    }
+
+    lk::AccountManager manager{ blockchain.getDatabase(), 10, 10 };
+    manager.updateFromGenesis(lk::Core::getGenesisBlock());
+    manager.getAccount(ACCOUNT_ADDRESS).setBalance(6);
+    manager.getAccount(ACCOUNT_ADDRESS).setStorageValue(STORAGE_KEY, base::Bytes("value"));
+    base::Database::WriteBatch batch;
+    state_root = manager.flush(batch);
+    batch.put(bc::toStateRootKey(hashes.size() - 1), state_root.getBytes());
+    batch.put(bc::getStateDepthKey(), base::toBytes(bc::BlockDepth{ hashes.size() - 1 }));
+    blockchain.getDatabase().write(batch);
+    return hashes;
+}
+
+} // namespace
+
+
+BOOST_AUTO_TEST_CASE(snapshot_transfers_chain_and_state)
+{
+    auto source_config = base::parseJson(SOURCE_CONFIG);
+    auto target_config = base::parseJson(TARGET_CONFIG);
+    base::Sha256 state_root{ base::Sha256::null() };
+    auto hashes = makeSourceDatabase(source_config, state_root);
+
+    lk::exportSnapshot(source_config, SNAPSHOT_PATH);
+    std::filesystem::remove_all(target_config.get<std::string>("database.path"));
+    lk::importSnapshot(target_config, SNAPSHOT_PATH);
+
+    bc::Blockchain blockchain{ target_config };
+    blockchain.load();
+    BOOST_CHECK_EQUAL(blockchain.getTopBlock()->getDepth(), hashes.size() - 1);
+    for (bc::BlockDepth depth = 0; depth < hashes.size(); ++depth) {
+        BOOST_CHECK(blockchain.findBlockHashByDepth(depth) == hashes[depth]);
+        BOOST_CHECK(blockchain.findBlock(hashes[depth]));
+    }
+
+    auto& database = blockchain.getDatabase();
+    BOOST_CHECK(database.get(bc::toStateRootKey(hashes.size() - 1)) == state_root.getBytes().toBytes());
+    lk::AccountManager manager{ database, 10, 10 };
+    BOOST_CHECK(manager.getStateRoot() == state_root);
+    BOOST_CHECK_EQUAL(manager.getBalance(ACCOUNT_ADDRESS), 6);
+    BOOST_CHECK(manager.getAccount(ACCOUNT_ADDRESS).getStorageValue(STORAGE_KEY).data == base::Bytes("value"));
+}
+
+
+BOOST_AUTO_TEST_CASE(snapshot_import_rejects_corrupted_file)
+{
+    auto source_config = base::parseJson(SOURCE_CONFIG);
+    auto target_config = base::parseJson(TARGET_CONFIG);
+    base::Sha256 state_root{ base::Sha256::null() };
+    makeSourceDatabase(source_config, state_root);
+    lk::exportSnapshot(source_config, SNAPSHOT_PATH);
+
+    {
+        std::fstream file(SNAPSHOT_PATH, std::ios::binary | std::ios::in | std::ios::out);
+        auto position = static_cast<std::streamoff>(std::filesystem::file_size(SNAPSHOT_PATH) / 2);
+        file.seekg(position);
+        auto byte = static_cast<char>(file.get() ^ 0xFF);
+        file.seekp(position);
+        file.put(byte);
+    }
+    std::filesystem::remove_all(target_config.get<std::string>("database.path"));
+    BOOST_CHECK_THROW(lk::importSnapshot(target_config, SNAPSHOT_PATH), base::Error);
+
+    {
+        // blocks and state, that were imported before the failure, are removed
+        bc::Blockchain blockchain{ target_config };
+        blockchain.load();
+        BOOST_CHECK(!blockchain.findBlockHashByDepth(0));
+        BOOST_CHECK(!blockchain.getDatabase().exists(bc::getStateDepthKey()));
+    }
+
+    // so the import can be repeated with an intact snapshot
+    lk::exportSnapshot(source_config, SNAPSHOT_PATH);
+    lk::importSnapshot(target_config, SNAPSHOT_PATH);
+    bc::Blockchain blockchain{ target_config };
+    blockchain.load();
+    BOOST_CHECK(blockchain.getDatabase().get(bc::toStateRootKey(blockchain.getTopBlock()->getDepth())) ==
+                state_root.getBytes().toBytes());
+}